@@ -17,8 +17,20 @@
 #include <string.h>
 #include "tdbcInt.h"
 
+/*
+ * The library script, library/tdbc.tcl, as arrays of lines generated at
+ * build time by tools/genScript.tcl: 'tdbcScript' is evaluated when the
+ * package is loaded, and 'tdbcLazyScript' when a method that it defines
+ * is first needed.
+ */
+
+#include "tdbcScript.h"
+
 /* Static procedures declared in this file */
 
+static int EvalScriptLines(Tcl_Interp* interp, const char *const lines[]);
+static int TdbcDefineLazyObjCmd(ClientData unused, Tcl_Interp* interp,
+				int objc, Tcl_Obj *const objv[]);
 static int TdbcMapSqlStateObjCmd(ClientData unused, Tcl_Interp* interp,
 				 int objc, Tcl_Obj *const objv[]);
 
@@ -30,7 +42,26 @@ static const struct TdbcCommand {
     const char* name;		/* Name of the command */
     Tcl_ObjCmdProc* proc;	/* Command procedure */
 } commandTable[] = {
+    { "::tdbc::DefineLazy",	TdbcDefineLazyObjCmd },
+    { "::tdbc::ExpandStreamParams", TdbcExpandStreamParamsObjCmd },
+    { "::tdbc::FetchAll",	TdbcFetchAllObjCmd },
+    { "::tdbc::FetchRow",	TdbcFetchRowObjCmd },
+    { "::tdbc::ForeachVars",	TdbcForeachVarsObjCmd },
+    { "::tdbc::Intern",		TdbcInternObjCmd },
+    { "::tdbc::Materialize",	TdbcMaterializeObjCmd },
+    { "::tdbc::Prefetch",	TdbcPrefetchObjCmd },
+    { "::tdbc::RecordQueryStats", TdbcRecordQueryStatsObjCmd },
+    { "::tdbc::ResultSetType",	TdbcResultSetTypeObjCmd },
+    { "::tdbc::SizeOf",		TdbcSizeOfObjCmd },
+    { "::tdbc::StreamParamCount", TdbcStreamParamCountObjCmd },
+    { "::tdbc::TestFetchType",	TdbcTestFetchTypeObjCmd },
+    { "::tdbc::Watchdog",	TdbcWatchdogObjCmd },
+    { "::tdbc::classify",	TdbcClassifyObjCmd },
+    { "::tdbc::fingerprint",	TdbcFingerprintObjCmd },
     { "::tdbc::mapSqlState",	TdbcMapSqlStateObjCmd },
+    { "::tdbc::parameterize",	TdbcParameterizeObjCmd },
+    { "::tdbc::querystats",	TdbcQuerystatsObjCmd },
+    { "::tdbc::streamparam",	TdbcStreamParamObjCmd },
     { "::tdbc::tokenize", 	TdbcTokenizeObjCmd },
     { NULL, 		  	NULL               },
 };
@@ -175,6 +206,79 @@ TdbcMapSqlStateObjCmd(
     }
 }
 
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * EvalScriptLines --
+ *
+ *	Evaluates a script, given as an array of lines, at global level.
+ *
+ * Results:
+ *	Returns a standard Tcl result.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+EvalScriptLines(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    const char *const lines[]	/* Lines of the script, ending with NULL */
+) {
+    Tcl_DString script;		/* Text of the script */
+    int status;
+    int i;
+
+    Tcl_DStringInit(&script);
+    for (i = 0; lines[i] != NULL; ++i) {
+	Tcl_DStringAppend(&script, lines[i], -1);
+    }
+    status = Tcl_EvalEx(interp, Tcl_DStringValue(&script),
+			Tcl_DStringLength(&script), TCL_EVAL_GLOBAL);
+    Tcl_DStringFree(&script);
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcDefineLazyObjCmd --
+ *
+ *	Makes the definitions of the library script that are deferred until
+ *	first use.
+ *
+ * Usage:
+ *	::tdbc::DefineLazy
+ *
+ * Results:
+ *	Returns 1 if the definitions were made, or 0 if they had already
+ *	been made, either by an earlier call or because the library script
+ *	was sourced in full.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+TdbcDefineLazyObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    if (objc != 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, "");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetVar(interp, "::tdbc::lazyDefined", TCL_GLOBAL_ONLY) != NULL) {
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(0));
+	return TCL_OK;
+    }
+    if (EvalScriptLines(interp, tdbcLazyScript) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(1));
+    return TCL_OK;
+}
+
 /*
  *-----------------------------------------------------------------------------
  *
@@ -186,7 +290,9 @@ TdbcMapSqlStateObjCmd(
  *
  *	Creates a ::tdbc namespace and a ::tdbc::Connection class
  *	from which the connection objects created by a TDBC driver
- *	may inherit.
+ *	may inherit. The classes are defined by the library script that
+ *	is compiled into this library, unless library/tdbc.tcl has
+ *	already been sourced.
  *
  *-----------------------------------------------------------------------------
  */
@@ -198,11 +304,14 @@ Tdbc_Init(
 
     int i;
 
-    /* Require Tcl */
+    /* Require Tcl and TclOO */
 
     if (Tcl_InitStubs(interp, "8.5", 0) == NULL) {
 	return TCL_ERROR;
     }
+    if (Tcl_OOInitStubs(interp) == NULL) {
+	return TCL_ERROR;
+    }
 
     /* Create the provided commands */
 
@@ -211,6 +320,14 @@ Tdbc_Init(
 			     (ClientData) NULL, (Tcl_CmdDeleteProc*) NULL);
     }
 
+    /* Define the base classes */
+
+    if (Tcl_FindCommand(interp, "::tdbc::connection", NULL,
+			TCL_GLOBAL_ONLY) == NULL
+	&& EvalScriptLines(interp, tdbcScript) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
     /* Provide the TDBC package */
 
     if (Tcl_PkgProvideEx(interp, PACKAGE_NAME, PACKAGE_VERSION,
@@ -17,6 +17,7 @@
 #define TDBC_H_INCLUDED 1
 
 #include <tcl.h>
+#include <tclOO.h>
 
 #ifndef TDBCAPI
 #   if defined(BUILD_tdbc)
@@ -62,6 +63,89 @@ DLLIMPORT int		Tdbc_Init(Tcl_Interp* interp);
 #define	TDBC_VERSION	"1.0.0"
 #define TDBC_PATCHLEVEL "1.0.0"
 
+/*
+ * A driver written in C may attach a Tdbc_ResultSetType to each of its
+ * result set objects with Tdbc_SetResultSetType. The framework's loops
+ * over rows (the 'allrows', 'foreach' and 'nextrow' methods of the base
+ * class, and materialized result sets) then call the driver's procedures
+ * directly instead of dispatching to its 'columns', 'nextlist',
+ * 'nextdict', 'nextresults' and 'rowcount' methods. The driver must still
+ * implement those methods for other callers.
+ *
+ * Each procedure receives the client data given to Tdbc_SetResultSetType,
+ * and returns TCL_OK or TCL_ERROR, leaving an error message in the
+ * interpreter in the latter case.
+ *
+ * Tdbc_ColumnsProc stores a list of the names of the columns of the
+ * current set of results in *columnsPtr.
+ *
+ * Tdbc_FetchRowProc fetches the next row of the current set of results
+ * into values[0] .. values[nColumns-1], storing NULL for a cell that is a
+ * SQL NULL, and sets *gotRowPtr to 1; or sets *gotRowPtr to 0 if there are
+ * no more rows. The framework increments the reference count of each
+ * value, and decrements it when it is done with the value.
+ *
+ * Tdbc_NextResultsProc advances to the next set of results, setting
+ * *moreResultsPtr to 1 if there is one and to 0 otherwise. It may be NULL
+ * if a statement never returns more than one set of results.
+ *
+ * Tdbc_RowCountProc stores the number of rows affected by the statement,
+ * or -1 if it is not known, in *rowCountPtr.
+ *
+ * A table of version TDBC_RESULTSETTYPE_VERSION_2 also has 'flags'. If
+ * they include TDBC_FETCH_THREADSAFE, 'execute -prefetch' may call the
+ * fetchRowProc from a thread that TDBC creates, while the thread that
+ * owns the result set makes no other call on it. Such a call receives a
+ * NULL interpreter; to report an error, the procedure stores the message
+ * in values[0], and optionally an error code in values[1], and returns
+ * TCL_ERROR. The values array has room for at least two elements. The
+ * destructor of tdbc::resultset stops the thread, so a driver's destructor
+ * must call [next] before it frees the data that the fetchRowProc uses.
+ */
+
+typedef int (Tdbc_ColumnsProc)(Tcl_Interp* interp, ClientData clientData,
+			       Tcl_Obj** columnsPtr);
+typedef int (Tdbc_FetchRowProc)(Tcl_Interp* interp, ClientData clientData,
+				int nColumns, Tcl_Obj** values,
+				int* gotRowPtr);
+typedef int (Tdbc_NextResultsProc)(Tcl_Interp* interp, ClientData clientData,
+				   int* moreResultsPtr);
+typedef int (Tdbc_RowCountProc)(Tcl_Interp* interp, ClientData clientData,
+				Tcl_WideInt* rowCountPtr);
+
+#define TDBC_RESULTSETTYPE_VERSION_1 1
+#define TDBC_RESULTSETTYPE_VERSION_2 2
+
+#define TDBC_FETCH_THREADSAFE 0x1
+
+typedef struct Tdbc_ResultSetType {
+    const char* name;		/* Name of the type, for introspection */
+    int version;		/* TDBC_RESULTSETTYPE_VERSION_1 or _2 */
+    Tdbc_ColumnsProc* columnsProc;
+    Tdbc_FetchRowProc* fetchRowProc;
+    Tdbc_NextResultsProc* nextResultsProc;
+    Tdbc_RowCountProc* rowCountProc;
+    int flags;			/* Combination of TDBC_FETCH_* flags.
+				 * Version 2 and later. */
+} Tdbc_ResultSetType;
+
+/*
+ * A driver written in C may attach a Tdbc_CancelProc to each of its
+ * connection objects with Tdbc_SetCancelProc. When an execution on the
+ * connection overruns its timeout ('-timeout' or the connection's
+ * '-querytimeout'), a watchdog thread that TDBC owns calls the procedure
+ * while the interpreter's thread is still waiting for the driver; the
+ * '$connection cancel' method calls it from the interpreter's thread. The
+ * procedure must ask the database to abandon the statement running on
+ * the connection, so that the waiting call returns an error, and must
+ * return promptly. It must be safe to call from any thread, whether or
+ * not a statement is running; calls such as sqlite3_interrupt, PQcancel,
+ * SQLCancel or a KILL QUERY issued over a second link qualify. It must
+ * not call back into TDBC.
+ */
+
+typedef void (Tdbc_CancelProc)(ClientData clientData);
+
 /*
  * Include the Stubs declarations for the public API, generated from
  * tdbc.decls.
@@ -0,0 +1,479 @@
+/*
+ * tdbcCancel.c --
+ *
+ *	Cancellation of queries that overrun their timeouts. A driver
+ *	written in C may register a procedure that cancels the query running
+ *	on a connection; a watchdog thread that TDBC owns calls it when the
+ *	deadline of an execution on that connection passes, while the
+ *	interpreter's thread is still waiting for the driver.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+
+/*
+ * Metadata attached to a connection object by Tdbc_SetCancelProc.
+ */
+
+typedef struct CancelData {
+    Tdbc_CancelProc* proc;	/* Driver's procedure */
+    ClientData clientData;	/* Driver's data for the connection */
+} CancelData;
+
+/*
+ * Structure that describes a deadline that the watchdog is watching.
+ * Deadlines are kept in a list in order of time. A deadline that has
+ * fired stays in the list until it is disarmed, so that the interpreter
+ * can ask whether it fired.
+ */
+
+typedef struct Deadline {
+    struct Deadline* nextPtr;	/* Next deadline in order of time */
+    Tcl_WideInt token;		/* Token that identifies the deadline */
+    Tcl_Time when;		/* Time at which the deadline passes */
+    CancelData* cancelPtr;	/* Connection's cancel procedure, or NULL
+				 * if the connection has been destroyed */
+    int fired;			/* 1 if the cancel procedure was called */
+} Deadline;
+
+/*
+ * State of the watchdog thread
+ */
+
+enum WatchdogState {
+    WATCHDOG_IDLE,		/* No thread is running */
+    WATCHDOG_RUNNING,		/* The thread is watching the deadlines */
+    WATCHDOG_STOPPING		/* The thread has been asked to exit */
+};
+
+/*
+ * The watchdog is shared by all interpreters in the process. The mutex
+ * protects the list of deadlines, the state, and the cancel procedures of
+ * the connections that have deadlines, which the watchdog calls while
+ * holding it.
+ */
+
+TCL_DECLARE_MUTEX(watchdogMutex)
+static Tcl_Condition watchdogChanged;
+static Deadline* firstDeadline = NULL;
+static Tcl_WideInt lastToken = 0;
+static int watchdogState = WATCHDOG_IDLE;
+static Tcl_ThreadId watchdogThread;
+
+/* Static procedures declared in this file */
+
+static int CloneCancelData(Tcl_Interp* interp, ClientData oldData,
+			   ClientData* newDataPtr);
+static void DeleteCancelData(ClientData clientData);
+static int StartWatchdog(void);
+static void StopWatchdog(ClientData dummy);
+static Tcl_ThreadCreateType WatchdogThread(ClientData dummy);
+static Deadline* FindDeadline(Tcl_WideInt token, Deadline*** prevPtrPtr);
+
+/* Type of the metadata */
+
+static const Tcl_ObjectMetadataType cancelMetadata = {
+    TCL_OO_METADATA_VERSION_CURRENT,
+				/* version */
+    "TdbcCancelProc",		/* name */
+    DeleteCancelData,		/* deleteProc */
+    CloneCancelData		/* cloneProc */
+};
+
+/* Subcommands of ::tdbc::Watchdog */
+
+static const char *const watchdogSubcommands[] = {
+    "arm", "cancel", "disarm", "fired", NULL
+};
+enum WatchdogSubcommand {
+    WD_ARM, WD_CANCEL, WD_DISARM, WD_FIRED
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_SetCancelProc --
+ *
+ *	Attaches a driver's cancel procedure to a connection object.
+ *
+ * Parameters:
+ *	object -- Connection object
+ *	proc -- Procedure that cancels the query running on the connection,
+ *		or NULL to detach any procedure.
+ *	clientData -- Data passed to the procedure. The driver remains
+ *		      responsible for freeing it, and must not free it until
+ *		      the procedure has been detached or the object has been
+ *		      destroyed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI void
+Tdbc_SetCancelProc(
+    Tcl_Object object,		/* Connection object */
+    Tdbc_CancelProc* proc,	/* Cancel procedure */
+    ClientData clientData	/* Data for the procedure */
+) {
+    CancelData* dataPtr = NULL;
+
+    if (proc != NULL) {
+	dataPtr = (CancelData*) ckalloc(sizeof(CancelData));
+	dataPtr->proc = proc;
+	dataPtr->clientData = clientData;
+    }
+    Tcl_ObjectSetMetadata(object, &cancelMetadata, (ClientData) dataPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcWatchdogObjCmd --
+ *
+ *	Controls the deadlines of executions.
+ *
+ * Usage:
+ *	::tdbc::Watchdog arm connection ms
+ *		Starts watching a deadline 'ms' milliseconds from now, and
+ *		returns a token for it. When the deadline passes, the
+ *		watchdog thread calls the connection's cancel procedure.
+ *		Returns an empty string if the connection has no cancel
+ *		procedure or the build has no threads.
+ *	::tdbc::Watchdog fired token
+ *		Returns 1 if the cancel procedure has been called for the
+ *		deadline, and 0 otherwise.
+ *	::tdbc::Watchdog disarm token
+ *		Stops watching the deadline, and returns whether it fired.
+ *	::tdbc::Watchdog cancel connection
+ *		Calls the connection's cancel procedure at once. Returns 1
+ *		if the connection has one, and 0 otherwise.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcWatchdogObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Object object;
+    CancelData* cancelPtr;
+    Deadline* dPtr;
+    Deadline** prevPtr;
+    Tcl_WideInt token;
+    Tcl_WideInt ms;
+    int fired;
+    int index;
+
+    if (objc < 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand arg ?ms?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], watchdogSubcommands,
+			    "subcommand", 0, &index) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if ((index == WD_ARM && objc != 4) || (index != WD_ARM && objc != 3)) {
+	Tcl_WrongNumArgs(interp, 2, objv,
+			 index == WD_ARM ? "connection ms"
+			 : (index == WD_CANCEL) ? "connection" : "token");
+	return TCL_ERROR;
+    }
+
+    switch ((enum WatchdogSubcommand) index) {
+
+    case WD_ARM:
+	object = Tcl_GetObjectFromObj(interp, objv[2]);
+	if (object == NULL
+	    || Tcl_GetWideIntFromObj(interp, objv[3], &ms) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	cancelPtr = (CancelData*)
+	    Tcl_ObjectGetMetadata(object, &cancelMetadata);
+	if (cancelPtr == NULL || StartWatchdog() != TCL_OK) {
+	    return TCL_OK;
+	}
+	dPtr = (Deadline*) ckalloc(sizeof(Deadline));
+	Tcl_GetTime(&dPtr->when);
+	dPtr->when.sec += (long) (ms / 1000);
+	dPtr->when.usec += (long) (ms % 1000) * 1000;
+	if (dPtr->when.usec >= 1000000) {
+	    dPtr->when.usec -= 1000000;
+	    ++dPtr->when.sec;
+	}
+	dPtr->cancelPtr = cancelPtr;
+	dPtr->fired = 0;
+
+	/* Insert the deadline in order of time, and wake the watchdog */
+
+	Tcl_MutexLock(&watchdogMutex);
+	dPtr->token = ++lastToken;
+	for (prevPtr = &firstDeadline; *prevPtr != NULL;
+	     prevPtr = &(*prevPtr)->nextPtr) {
+	    if ((*prevPtr)->when.sec > dPtr->when.sec
+		|| ((*prevPtr)->when.sec == dPtr->when.sec
+		    && (*prevPtr)->when.usec > dPtr->when.usec)) {
+		break;
+	    }
+	}
+	dPtr->nextPtr = *prevPtr;
+	*prevPtr = dPtr;
+	token = dPtr->token;
+	Tcl_ConditionNotify(&watchdogChanged);
+	Tcl_MutexUnlock(&watchdogMutex);
+	Tcl_SetObjResult(interp, Tcl_NewWideIntObj(token));
+	return TCL_OK;
+
+    case WD_CANCEL:
+	object = Tcl_GetObjectFromObj(interp, objv[2]);
+	if (object == NULL) {
+	    return TCL_ERROR;
+	}
+	cancelPtr = (CancelData*)
+	    Tcl_ObjectGetMetadata(object, &cancelMetadata);
+	if (cancelPtr != NULL) {
+	    cancelPtr->proc(cancelPtr->clientData);
+	}
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(cancelPtr != NULL));
+	return TCL_OK;
+
+    case WD_DISARM:
+    case WD_FIRED:
+	if (Tcl_GetWideIntFromObj(interp, objv[2], &token) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	Tcl_MutexLock(&watchdogMutex);
+	dPtr = FindDeadline(token, &prevPtr);
+	fired = (dPtr != NULL && dPtr->fired);
+	if (dPtr != NULL && index == WD_DISARM) {
+	    *prevPtr = dPtr->nextPtr;
+	    ckfree((char*) dPtr);
+	}
+	Tcl_MutexUnlock(&watchdogMutex);
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(fired));
+	return TCL_OK;
+    }
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FindDeadline --
+ *
+ *	Finds a deadline by its token. The caller must hold the mutex.
+ *
+ * Results:
+ *	Returns the deadline, or NULL if there is none with the token, and
+ *	stores in *prevPtrPtr the address of the pointer to it.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Deadline*
+FindDeadline(
+    Tcl_WideInt token,		/* Token of the deadline */
+    Deadline*** prevPtrPtr	/* OUTPUT: Pointer to the deadline */
+) {
+    Deadline** prevPtr;
+
+    for (prevPtr = &firstDeadline; *prevPtr != NULL;
+	 prevPtr = &(*prevPtr)->nextPtr) {
+	if ((*prevPtr)->token == token) {
+	    *prevPtrPtr = prevPtr;
+	    return *prevPtr;
+	}
+    }
+    return NULL;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * WatchdogThread --
+ *
+ *	Body of the thread that calls the cancel procedures of connections
+ *	whose deadlines have passed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_ThreadCreateType
+WatchdogThread(
+    ClientData dummy		/* Not used */
+) {
+    Deadline* dPtr;
+    Tcl_Time now;
+    Tcl_Time wait;
+    Tcl_Time* waitPtr;
+
+    Tcl_MutexLock(&watchdogMutex);
+    while (watchdogState == WATCHDOG_RUNNING) {
+
+	/*
+	 * Fire the deadlines that have passed, and sleep until the next
+	 * one, or until a deadline is added.
+	 */
+
+	Tcl_GetTime(&now);
+	waitPtr = NULL;
+	for (dPtr = firstDeadline; dPtr != NULL; dPtr = dPtr->nextPtr) {
+	    if (dPtr->fired) {
+		continue;
+	    }
+	    if (dPtr->when.sec > now.sec
+		|| (dPtr->when.sec == now.sec && dPtr->when.usec > now.usec)) {
+		wait.sec = dPtr->when.sec - now.sec;
+		wait.usec = dPtr->when.usec - now.usec;
+		if (wait.usec < 0) {
+		    wait.usec += 1000000;
+		    --wait.sec;
+		}
+		waitPtr = &wait;
+		break;
+	    }
+	    dPtr->fired = 1;
+	    if (dPtr->cancelPtr != NULL) {
+		dPtr->cancelPtr->proc(dPtr->cancelPtr->clientData);
+	    }
+	}
+	Tcl_ConditionWait(&watchdogChanged, &watchdogMutex, waitPtr);
+    }
+    Tcl_MutexUnlock(&watchdogMutex);
+    Tcl_ExitThread(TCL_OK);
+    TCL_THREAD_CREATE_RETURN;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * StartWatchdog --
+ *
+ *	Starts the watchdog thread if it is not running.
+ *
+ * Results:
+ *	Returns TCL_ERROR if the build has no threads or the thread cannot
+ *	be created.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+StartWatchdog(void)
+{
+#ifndef TCL_THREADS
+    return TCL_ERROR;
+#else
+    int status = TCL_OK;
+
+    Tcl_MutexLock(&watchdogMutex);
+    if (watchdogState == WATCHDOG_IDLE) {
+	watchdogState = WATCHDOG_RUNNING;
+	if (Tcl_CreateThread(&watchdogThread, WatchdogThread, NULL,
+			     TCL_THREAD_STACK_DEFAULT,
+			     TCL_THREAD_JOINABLE) != TCL_OK) {
+	    watchdogState = WATCHDOG_IDLE;
+	    status = TCL_ERROR;
+	} else {
+	    Tcl_CreateExitHandler(StopWatchdog, NULL);
+	}
+    }
+    Tcl_MutexUnlock(&watchdogMutex);
+    return status;
+#endif
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * StopWatchdog --
+ *
+ *	Stops the watchdog thread when the process exits, and frees the
+ *	deadlines that remain.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+StopWatchdog(
+    ClientData dummy		/* Not used */
+) {
+    Deadline* dPtr;
+    int result;
+
+    Tcl_MutexLock(&watchdogMutex);
+    if (watchdogState != WATCHDOG_RUNNING) {
+	Tcl_MutexUnlock(&watchdogMutex);
+	return;
+    }
+    watchdogState = WATCHDOG_STOPPING;
+    Tcl_ConditionNotify(&watchdogChanged);
+    Tcl_MutexUnlock(&watchdogMutex);
+    Tcl_JoinThread(watchdogThread, &result);
+
+    while (firstDeadline != NULL) {
+	dPtr = firstDeadline;
+	firstDeadline = dPtr->nextPtr;
+	ckfree((char*) dPtr);
+    }
+    watchdogState = WATCHDOG_IDLE;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * CloneCancelData --
+ *
+ *	Copies the cancel procedure when a connection object is copied.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+CloneCancelData(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData oldData,		/* Metadata of the original object */
+    ClientData* newDataPtr	/* OUTPUT: Metadata of the copy */
+) {
+    CancelData* oldPtr = (CancelData*) oldData;
+    CancelData* newPtr = (CancelData*) ckalloc(sizeof(CancelData));
+
+    *newPtr = *oldPtr;
+    *newDataPtr = (ClientData) newPtr;
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeleteCancelData --
+ *
+ *	Detaches the cancel procedure from a connection object, making sure
+ *	that the watchdog will not call it again.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeleteCancelData(
+    ClientData clientData	/* Metadata of the object */
+) {
+    CancelData* cancelPtr = (CancelData*) clientData;
+    Deadline* dPtr;
+
+    Tcl_MutexLock(&watchdogMutex);
+    for (dPtr = firstDeadline; dPtr != NULL; dPtr = dPtr->nextPtr) {
+	if (dPtr->cancelPtr == cancelPtr) {
+	    dPtr->cancelPtr = NULL;
+	}
+    }
+    Tcl_MutexUnlock(&watchdogMutex);
+    ckfree((char*) cancelPtr);
+}
@@ -17,7 +17,7 @@
 /* !BEGIN!: Do not edit below this line. */
 
 #define TDBC_STUBS_EPOCH 0
-#define TDBC_STUBS_REVISION 3
+#define TDBC_STUBS_REVISION 9
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +34,44 @@ TDBCAPI Tcl_Obj*	Tdbc_TokenizeSql (Tcl_Interp* interp,
 				const char* statement);
 /* 2 */
 TDBCAPI const char*	Tdbc_MapSqlState (const char* sqlstate);
+/* 3 */
+TDBCAPI void		Tdbc_SetResultSetType (Tcl_Object object,
+				const Tdbc_ResultSetType* typePtr,
+				ClientData clientData);
+/* 4 */
+TDBCAPI const Tdbc_ResultSetType* Tdbc_GetResultSetType (Tcl_Object object,
+				ClientData* clientDataPtr);
+/* 5 */
+TDBCAPI Tcl_Obj*	Tdbc_NewInt64Value (Tcl_WideInt value);
+/* 6 */
+TDBCAPI Tcl_Obj*	Tdbc_NewDoubleValue (double value);
+/* 7 */
+TDBCAPI Tcl_Obj*	Tdbc_NewBytesValue (const unsigned char* bytes,
+				int length);
+/* 8 */
+TDBCAPI Tcl_Obj*	Tdbc_NewDecimalValue (const char* digits, int length);
+/* 9 */
+TDBCAPI Tcl_Obj*	Tdbc_NewTimestampValue (int year, int month, int day,
+				int hour, int minute, int second,
+				int microseconds);
+/* 10 */
+TDBCAPI int		Tdbc_GetStreamParam (Tcl_Interp* interp,
+				Tcl_Obj* objPtr, Tcl_Channel* chanPtr,
+				Tcl_WideInt* lengthPtr);
+/* 11 */
+TDBCAPI int		Tdbc_ReadStreamParam (Tcl_Channel chan,
+				Tcl_WideInt* remainingPtr, char* buffer,
+				int bufSize);
+/* 12 */
+TDBCAPI Tcl_Obj*	Tdbc_ClassifySql (Tcl_Interp* interp,
+				Tcl_Obj* sqlObj);
+/* 13 */
+TDBCAPI void		Tdbc_SetCancelProc (Tcl_Object object,
+				Tdbc_CancelProc* proc, ClientData clientData);
+/* 14 */
+TDBCAPI void		Tdbc_InternRow (Tcl_Object object,
+				Tcl_Obj* columnsObj, int nColumns,
+				Tcl_Obj** values);
 
 typedef struct TdbcStubs {
     int magic;
@@ -44,6 +82,18 @@ typedef struct TdbcStubs {
     int (*tdbc_Init_) (Tcl_Interp* interp); /* 0 */
     Tcl_Obj* (*tdbc_TokenizeSql) (Tcl_Interp* interp, const char* statement); /* 1 */
     const char* (*tdbc_MapSqlState) (const char* sqlstate); /* 2 */
+    void (*tdbc_SetResultSetType) (Tcl_Object object, const Tdbc_ResultSetType* typePtr, ClientData clientData); /* 3 */
+    const Tdbc_ResultSetType* (*tdbc_GetResultSetType) (Tcl_Object object, ClientData* clientDataPtr); /* 4 */
+    Tcl_Obj* (*tdbc_NewInt64Value) (Tcl_WideInt value); /* 5 */
+    Tcl_Obj* (*tdbc_NewDoubleValue) (double value); /* 6 */
+    Tcl_Obj* (*tdbc_NewBytesValue) (const unsigned char* bytes, int length); /* 7 */
+    Tcl_Obj* (*tdbc_NewDecimalValue) (const char* digits, int length); /* 8 */
+    Tcl_Obj* (*tdbc_NewTimestampValue) (int year, int month, int day, int hour, int minute, int second, int microseconds); /* 9 */
+    int (*tdbc_GetStreamParam) (Tcl_Interp* interp, Tcl_Obj* objPtr, Tcl_Channel* chanPtr, Tcl_WideInt* lengthPtr); /* 10 */
+    int (*tdbc_ReadStreamParam) (Tcl_Channel chan, Tcl_WideInt* remainingPtr, char* buffer, int bufSize); /* 11 */
+    Tcl_Obj* (*tdbc_ClassifySql) (Tcl_Interp* interp, Tcl_Obj* sqlObj); /* 12 */
+    void (*tdbc_SetCancelProc) (Tcl_Object object, Tdbc_CancelProc* proc, ClientData clientData); /* 13 */
+    void (*tdbc_InternRow) (Tcl_Object object, Tcl_Obj* columnsObj, int nColumns, Tcl_Obj** values); /* 14 */
 } TdbcStubs;
 
 extern const TdbcStubs *tdbcStubsPtr;
@@ -64,6 +114,30 @@ extern const TdbcStubs *tdbcStubsPtr;
 	(tdbcStubsPtr->tdbc_TokenizeSql) /* 1 */
 #define Tdbc_MapSqlState \
 	(tdbcStubsPtr->tdbc_MapSqlState) /* 2 */
+#define Tdbc_SetResultSetType \
+	(tdbcStubsPtr->tdbc_SetResultSetType) /* 3 */
+#define Tdbc_GetResultSetType \
+	(tdbcStubsPtr->tdbc_GetResultSetType) /* 4 */
+#define Tdbc_NewInt64Value \
+	(tdbcStubsPtr->tdbc_NewInt64Value) /* 5 */
+#define Tdbc_NewDoubleValue \
+	(tdbcStubsPtr->tdbc_NewDoubleValue) /* 6 */
+#define Tdbc_NewBytesValue \
+	(tdbcStubsPtr->tdbc_NewBytesValue) /* 7 */
+#define Tdbc_NewDecimalValue \
+	(tdbcStubsPtr->tdbc_NewDecimalValue) /* 8 */
+#define Tdbc_NewTimestampValue \
+	(tdbcStubsPtr->tdbc_NewTimestampValue) /* 9 */
+#define Tdbc_GetStreamParam \
+	(tdbcStubsPtr->tdbc_GetStreamParam) /* 10 */
+#define Tdbc_ReadStreamParam \
+	(tdbcStubsPtr->tdbc_ReadStreamParam) /* 11 */
+#define Tdbc_ClassifySql \
+	(tdbcStubsPtr->tdbc_ClassifySql) /* 12 */
+#define Tdbc_SetCancelProc \
+	(tdbcStubsPtr->tdbc_SetCancelProc) /* 13 */
+#define Tdbc_InternRow \
+	(tdbcStubsPtr->tdbc_InternRow) /* 14 */
 
 #endif /* defined(USE_TDBC_STUBS) */
 
@@ -15,6 +15,15 @@
 #ifndef TDBCINT_H_INCLUDED
 #define TDBCINT_H_INCLUDED 1
 
+/*
+ * TDBC calls TclOO through its Stubs table whenever it calls Tcl through
+ * Tcl's.
+ */
+
+#if defined(USE_TCL_STUBS) && !defined(USE_TCLOO_STUBS)
+#   define USE_TCLOO_STUBS 1
+#endif
+
 #include "tdbc.h"
 
 /*
@@ -34,6 +43,58 @@
  * Linkage to procedures not exported from this module
  */
 
+MODULE_SCOPE int TdbcClassifyObjCmd(ClientData clientData, Tcl_Interp* interp,
+				    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcExpandStreamParamsObjCmd(ClientData clientData,
+					      Tcl_Interp* interp, int objc,
+					      Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcFetchAllObjCmd(ClientData clientData, Tcl_Interp* interp,
+				    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcFetchRowObjCmd(ClientData clientData, Tcl_Interp* interp,
+				    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcFingerprintObjCmd(ClientData clientData,
+				       Tcl_Interp* interp,
+				       int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcForeachVarsObjCmd(ClientData clientData,
+				       Tcl_Interp* interp,
+				       int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE const Tdbc_ResultSetType* TdbcGetResultSetTypeFromObj(
+				    Tcl_Interp* interp, Tcl_Obj* objPtr,
+				    ClientData* clientDataPtr);
+MODULE_SCOPE int TdbcInternObjCmd(ClientData clientData, Tcl_Interp* interp,
+				  int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcMaterializeObjCmd(ClientData clientData,
+				       Tcl_Interp* interp,
+				       int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcMemoryLimitError(Tcl_Interp* interp);
+MODULE_SCOPE size_t TdbcObjSize(Tcl_Obj* objPtr);
+MODULE_SCOPE int TdbcParameterizeObjCmd(ClientData clientData,
+					Tcl_Interp* interp,
+					int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcPrefetchObjCmd(ClientData clientData, Tcl_Interp* interp,
+				    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcQuerystatsObjCmd(ClientData clientData,
+				      Tcl_Interp* interp,
+				      int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcRecordQueryStatsObjCmd(ClientData clientData,
+					    Tcl_Interp* interp,
+					    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcResultSetTypeObjCmd(ClientData clientData,
+					 Tcl_Interp* interp,
+					 int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcSizeOfObjCmd(ClientData clientData, Tcl_Interp* interp,
+				  int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcStreamParamCountObjCmd(ClientData clientData,
+					    Tcl_Interp* interp, int objc,
+					    Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcStreamParamObjCmd(ClientData clientData,
+				       Tcl_Interp* interp,
+				       int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcWatchdogObjCmd(ClientData clientData, Tcl_Interp* interp,
+				    int objc, Tcl_Obj *const objv[]);
+MODULE_SCOPE int TdbcTestFetchTypeObjCmd(ClientData clientData,
+					 Tcl_Interp* interp,
+					 int objc, Tcl_Obj *const objv[]);
 MODULE_SCOPE int TdbcTokenizeObjCmd(ClientData clientData, Tcl_Interp* interp,
 				    int objc, Tcl_Obj *const objv[]);
 
@@ -0,0 +1,467 @@
+/*
+ * tdbcIntern.c --
+ *
+ *	Interning of the values of columns in the rows of a result set, so
+ *	that a value that repeats in a column with few distinct values,
+ *	such as a status or a country code, is a single Tcl_Obj shared by
+ *	all the rows instead of a copy in each.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Conversions between the counts kept in hash tables and the pointers
+ * that hold them, as in Tcl's internal headers.
+ */
+
+#ifndef INT2PTR
+#define INT2PTR(p) ((ClientData)(ptrdiff_t)(p))
+#endif
+#ifndef PTR2INT
+#define PTR2INT(p) ((int)(ptrdiff_t)(p))
+#endif
+
+/*
+ * When every column is interned, a column stops being interned once it
+ * has contributed PROBE_LIMIT distinct values, since it is then unlikely
+ * to have few enough of them for sharing to pay.
+ */
+
+#define PROBE_LIMIT 256
+
+/*
+ * Table of shared values, attached to a result set object by
+ * '::tdbc::Intern attach'.
+ */
+
+typedef struct InternTable {
+    Tcl_HashTable values;	/* Shared values, keyed by their strings */
+    Tcl_HashTable columns;	/* Columns that are interned, keyed by
+				 * name. The value is the number of distinct
+				 * values that the column has contributed,
+				 * or -1 once it is no longer interned. */
+    int allColumns;		/* 1 if every column is interned */
+    Tcl_Obj* mappedObj;		/* List of column names that 'map'
+				 * describes, or NULL */
+    int mappedCount;		/* Length of 'map' */
+    Tcl_HashEntry** map;	/* Entry in 'columns' of each column of
+				 * 'mappedObj', or NULL if the column is not
+				 * interned */
+} InternTable;
+
+/* Static procedures declared in this file */
+
+static void DeleteInternTable(ClientData clientData);
+static Tcl_HashEntry** MapColumns(InternTable* tablePtr,
+				  Tcl_Obj* columnsObj, int nColumns);
+static void InternValues(InternTable* tablePtr, Tcl_Obj* columnsObj,
+			 int nColumns, Tcl_Obj** values);
+
+/* Type of the metadata */
+
+static const Tcl_ObjectMetadataType internTableMetadata = {
+    TCL_OO_METADATA_VERSION_CURRENT,
+				/* version */
+    "TdbcInternTable",		/* name */
+    DeleteInternTable,		/* deleteProc */
+    NULL			/* cloneProc */
+};
+
+/* Subcommands of ::tdbc::Intern */
+
+static const char *const internSubcommands[] = {
+    "attach", "row", NULL
+};
+enum InternSubcommand {
+    INTERN_ATTACH, INTERN_ROW
+};
+
+/* Forms of rows */
+
+static const char *const asValues[] = {
+    "dicts", "lists", NULL
+};
+enum AsValues {
+    AS_DICTS, AS_LISTS
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_InternRow --
+ *
+ *	Replaces the values in a row of a result set with the shared
+ *	values of the result set's intern table.
+ *
+ * Parameters:
+ *	object -- Result set object
+ *	columnsObj -- List of the names of the columns of the row
+ *	nColumns -- Number of values in the row
+ *	values -- Values of the row, NULL for a SQL NULL. The caller owns a
+ *		  reference to each value.
+ *
+ * Side effects:
+ *	Does nothing unless interning has been requested for the result
+ *	set. Otherwise, each value of a column that is interned is either
+ *	added to the table or replaced by the equal value already in the
+ *	table. A replaced value's reference is released, and the caller
+ *	receives a reference to the shared value in its place.
+ *
+ * The procedure must be called from the thread that owns the result set.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI void
+Tdbc_InternRow(
+    Tcl_Object object,		/* Result set object */
+    Tcl_Obj* columnsObj,	/* Column names */
+    int nColumns,		/* Number of values */
+    Tcl_Obj** values		/* Values of the row */
+) {
+    InternTable* tablePtr = (InternTable*)
+	Tcl_ObjectGetMetadata(object, &internTableMetadata);
+
+    if (tablePtr != NULL) {
+	InternValues(tablePtr, columnsObj, nColumns, values);
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * InternValues --
+ *
+ *	Replaces the values in a row with the shared values of a table, as
+ *	described for Tdbc_InternRow.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+InternValues(
+    InternTable* tablePtr,	/* Table of shared values */
+    Tcl_Obj* columnsObj,	/* Column names */
+    int nColumns,		/* Number of values */
+    Tcl_Obj** values		/* Values of the row */
+) {
+    Tcl_HashEntry** map;
+    Tcl_HashEntry* entryPtr;
+    Tcl_Obj* sharedObj;
+    int count;
+    int isNew;
+    int i;
+
+    map = MapColumns(tablePtr, columnsObj, nColumns);
+    for (i = 0; i < nColumns; ++i) {
+	if (values[i] == NULL || map[i] == NULL) {
+	    continue;
+	}
+	count = PTR2INT(Tcl_GetHashValue(map[i]));
+	if (count < 0) {
+	    continue;
+	}
+	entryPtr = Tcl_CreateHashEntry(&tablePtr->values,
+				       Tcl_GetString(values[i]), &isNew);
+	if (isNew) {
+	    Tcl_IncrRefCount(values[i]);
+	    Tcl_SetHashValue(entryPtr, (ClientData) values[i]);
+	    if (++count >= PROBE_LIMIT && tablePtr->allColumns) {
+		count = -1;
+	    }
+	    Tcl_SetHashValue(map[i], INT2PTR(count));
+	} else {
+	    sharedObj = (Tcl_Obj*) Tcl_GetHashValue(entryPtr);
+	    if (sharedObj != values[i]) {
+		Tcl_IncrRefCount(sharedObj);
+		Tcl_DecrRefCount(values[i]);
+		values[i] = sharedObj;
+	    }
+	}
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * MapColumns --
+ *
+ *	Finds which columns of a row are interned.
+ *
+ * Results:
+ *	Returns an array of 'nColumns' elements, giving the entry of each
+ *	column in the table's 'columns', or NULL for a column that is not
+ *	interned. The array belongs to the table.
+ *
+ * The array is kept for as long as the rows have the same list of
+ * column names, so that it is computed once per set of results.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_HashEntry**
+MapColumns(
+    InternTable* tablePtr,	/* Table of shared values */
+    Tcl_Obj* columnsObj,	/* Column names */
+    int nColumns		/* Number of values in the row */
+) {
+    Tcl_Obj** columnv;
+    int columnc = 0;
+    int isNew;
+    int i;
+
+    if (tablePtr->mappedObj == columnsObj
+	&& tablePtr->mappedCount >= nColumns) {
+	return tablePtr->map;
+    }
+    if (tablePtr->mappedObj != NULL) {
+	Tcl_DecrRefCount(tablePtr->mappedObj);
+    }
+    tablePtr->mappedObj = columnsObj;
+    Tcl_IncrRefCount(columnsObj);
+    if (tablePtr->mappedCount < nColumns) {
+	tablePtr->map = (Tcl_HashEntry**)
+	    ckrealloc((char*) tablePtr->map,
+		      nColumns * sizeof(Tcl_HashEntry*));
+	tablePtr->mappedCount = nColumns;
+    }
+    if (Tcl_ListObjGetElements(NULL, columnsObj,
+			       &columnc, &columnv) != TCL_OK) {
+	columnc = 0;
+    }
+    for (i = 0; i < nColumns; ++i) {
+	if (i >= columnc) {
+	    tablePtr->map[i] = NULL;
+	} else if (tablePtr->allColumns) {
+	    tablePtr->map[i] =
+		Tcl_CreateHashEntry(&tablePtr->columns,
+				    Tcl_GetString(columnv[i]), &isNew);
+	    if (isNew) {
+		Tcl_SetHashValue(tablePtr->map[i], INT2PTR(0));
+	    }
+	} else {
+	    tablePtr->map[i] =
+		Tcl_FindHashEntry(&tablePtr->columns,
+				  Tcl_GetString(columnv[i]));
+	}
+    }
+    return tablePtr->map;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeleteInternTable --
+ *
+ *	Frees the intern table of a result set when the result set is
+ *	destroyed. The shared values live on in the rows that use them.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeleteInternTable(
+    ClientData clientData	/* Table to delete */
+) {
+    InternTable* tablePtr = (InternTable*) clientData;
+    Tcl_HashSearch search;
+    Tcl_HashEntry* entryPtr;
+
+    for (entryPtr = Tcl_FirstHashEntry(&tablePtr->values, &search);
+	 entryPtr != NULL;
+	 entryPtr = Tcl_NextHashEntry(&search)) {
+	Tcl_DecrRefCount((Tcl_Obj*) Tcl_GetHashValue(entryPtr));
+    }
+    Tcl_DeleteHashTable(&tablePtr->values);
+    Tcl_DeleteHashTable(&tablePtr->columns);
+    if (tablePtr->mappedObj != NULL) {
+	Tcl_DecrRefCount(tablePtr->mappedObj);
+    }
+    if (tablePtr->map != NULL) {
+	ckfree((char*) tablePtr->map);
+    }
+    ckfree((char*) tablePtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcInternObjCmd --
+ *
+ *	Requests interning for a result set, and interns the rows that the
+ *	base classes fetch through the result set's methods.
+ *
+ * Usage:
+ *	::tdbc::Intern attach resultSet columns
+ *	::tdbc::Intern row resultSet lists|dicts columns row
+ *
+ * Results:
+ *	'attach' gives the result set an empty intern table for the named
+ *	columns, or for every column if 'columns' is '*', replacing any
+ *	table that it had, and returns an empty result. 'row' returns the
+ *	row with its values replaced by the shared values of the result
+ *	set's table; the row is returned unchanged if the result set has no
+ *	table.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcInternObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Object object;		/* Result set object */
+    InternTable* tablePtr;	/* Its intern table */
+    Tcl_Obj* staticValues[16];	/* Values of narrow rows */
+    Tcl_Obj** values = staticValues;
+				/* Values of the row */
+    Tcl_Obj** columnv;		/* Column names */
+    int columnc;
+    Tcl_Obj** elemv;		/* Elements of a row that is a list */
+    int elemc;
+    Tcl_Obj* rowObj;		/* Row being interned */
+    int subcommand;
+    int asLists;
+    int status = TCL_OK;
+    int isNew;
+    int changed = 0;
+    int i;
+
+    if (objc < 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand resultSet ?arg...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], internSubcommands,
+			    "subcommand", 0, &subcommand) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    object = Tcl_GetObjectFromObj(interp, objv[2]);
+    if (object == NULL) {
+	return TCL_ERROR;
+    }
+
+    if (subcommand == INTERN_ATTACH) {
+	if (objc != 4) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "resultSet columns");
+	    return TCL_ERROR;
+	}
+	if (Tcl_ListObjGetElements(interp, objv[3],
+				   &columnc, &columnv) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	tablePtr = (InternTable*) ckalloc(sizeof(InternTable));
+	Tcl_InitHashTable(&tablePtr->values, TCL_STRING_KEYS);
+	Tcl_InitHashTable(&tablePtr->columns, TCL_STRING_KEYS);
+	tablePtr->allColumns =
+	    (columnc == 1 && !strcmp(Tcl_GetString(columnv[0]), "*"));
+	tablePtr->mappedObj = NULL;
+	tablePtr->mappedCount = 0;
+	tablePtr->map = NULL;
+	if (!tablePtr->allColumns) {
+	    for (i = 0; i < columnc; ++i) {
+		Tcl_SetHashValue(Tcl_CreateHashEntry(&tablePtr->columns,
+						     Tcl_GetString(columnv[i]),
+						     &isNew),
+				 INT2PTR(0));
+	    }
+	}
+	Tcl_ObjectSetMetadata(object, &internTableMetadata,
+			      (ClientData) tablePtr);
+	return TCL_OK;
+    }
+
+    if (objc != 6) {
+	Tcl_WrongNumArgs(interp, 2, objv, "resultSet lists|dicts columns row");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[3], asValues, "variable type",
+			    0, &asLists) != TCL_OK
+	|| Tcl_ListObjGetElements(interp, objv[4],
+				  &columnc, &columnv) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    rowObj = objv[5];
+    tablePtr = (InternTable*)
+	Tcl_ObjectGetMetadata(object, &internTableMetadata);
+    if (tablePtr == NULL) {
+	Tcl_SetObjResult(interp, rowObj);
+	return TCL_OK;
+    }
+
+    /* Gather the values of the row in the order of the columns */
+
+    if (asLists) {
+	if (Tcl_ListObjGetElements(interp, rowObj,
+				   &elemc, &elemv) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	columnc = elemc;
+    }
+    if (columnc > 16) {
+	values = (Tcl_Obj**) ckalloc(columnc * sizeof(Tcl_Obj*));
+    }
+    for (i = 0; i < columnc; ++i) {
+	if (asLists) {
+	    values[i] = elemv[i];
+	} else if (Tcl_DictObjGet(interp, rowObj, columnv[i],
+				  &values[i]) != TCL_OK) {
+	    status = TCL_ERROR;
+	    columnc = i;
+	    break;
+	}
+	if (values[i] != NULL) {
+	    Tcl_IncrRefCount(values[i]);
+	}
+    }
+    if (status == TCL_OK) {
+	InternValues(tablePtr, objv[4], columnc, values);
+
+	/* Put the shared values in the row */
+
+	if (asLists) {
+	    for (i = 0; i < columnc && !changed; ++i) {
+		changed = (values[i] != elemv[i]);
+	    }
+	    if (changed) {
+		rowObj = Tcl_NewListObj(columnc, values);
+	    }
+	} else {
+	    for (i = 0; i < columnc; ++i) {
+		Tcl_Obj* oldObj = NULL;
+
+		if (values[i] == NULL) {
+		    continue;
+		}
+		Tcl_DictObjGet(NULL, rowObj, columnv[i], &oldObj);
+		if (oldObj != values[i]) {
+		    if (Tcl_IsShared(rowObj)) {
+			rowObj = Tcl_DuplicateObj(rowObj);
+		    }
+		    Tcl_DictObjPut(NULL, rowObj, columnv[i], values[i]);
+		}
+	    }
+	}
+	Tcl_SetObjResult(interp, rowObj);
+    }
+    for (i = 0; i < columnc; ++i) {
+	if (values[i] != NULL) {
+	    Tcl_DecrRefCount(values[i]);
+	}
+    }
+    if (values != staticValues) {
+	ckfree((char*) values);
+    }
+    return status;
+}
@@ -0,0 +1,779 @@
+/*
+ * tdbcMaterialize.c --
+ *
+ *	Code for materialized result sets: the rows of a TDBC result set,
+ *	copied into a compact in-memory arena that supports random access.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <string.h>
+
+/*
+ * A materialized result set holds all the cells of a result in one
+ * contiguous character buffer. Cell 'k' (counting across rows, so that
+ * cell 'k' is column 'k % nColumns' of row 'k / nColumns') occupies the
+ * bytes from 'offsets[k]' up to 'offsets[k+1]'. A bit in 'nullBits' is
+ * set for each cell whose value is NULL. Tcl objects are created only
+ * when a row or column is actually requested.
+ */
+
+typedef struct MaterializedRows {
+    Tcl_Command cmd;		/* Command that represents the rows */
+    Tcl_Obj* columnNames;	/* List of the names of the columns */
+    int nColumns;		/* Number of columns */
+    Tcl_Obj* rowCount;		/* Row count reported by the result set */
+    int nRows;			/* Number of rows materialized */
+    size_t cellsAlloc;		/* Number of cells allocated in 'offsets' */
+    size_t* offsets;		/* Offsets of the cells in 'buffer'; there
+				 * are nRows * nColumns + 1 of them */
+    unsigned char* nullBits;	/* Bit map of the NULL cells */
+    char* buffer;		/* Values of the cells */
+    size_t bufferUsed;		/* Number of bytes in use in 'buffer' */
+    size_t bufferAlloc;		/* Number of bytes allocated to 'buffer' */
+} MaterializedRows;
+
+/* Options to the 'row' and 'range' subcommands */
+
+static const char *const asOptions[] = {
+    "-as", NULL
+};
+static const char *const asValues[] = {
+    "dicts", "lists", NULL
+};
+enum AsValues {
+    AS_DICTS, AS_LISTS
+};
+
+/* Static procedures declared in this file */
+
+static void AppendCell(MaterializedRows* rowsPtr, size_t cell,
+		       Tcl_Obj* valueObj);
+static void DeleteMaterializedRows(ClientData clientData);
+static int GetRowIndex(Tcl_Interp* interp, MaterializedRows* rowsPtr,
+		       Tcl_Obj* indexObj, int* indexPtr);
+static size_t MaterializedSize(MaterializedRows* rowsPtr);
+static Tcl_Obj* MakeRow(MaterializedRows* rowsPtr, int row, int asLists);
+static Tcl_Obj* MakeCell(MaterializedRows* rowsPtr, size_t cell);
+static int MaterializedRowsObjCmd(ClientData clientData, Tcl_Interp* interp,
+				  int objc, Tcl_Obj *const objv[]);
+static int ParseAsOption(Tcl_Interp* interp, int objc, Tcl_Obj *const objv[],
+			 int* skipPtr, int* asListsPtr);
+static void ReleaseCells(Tcl_Obj** values, int nColumns);
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * AppendCell --
+ *
+ *	Appends a single cell to a materialized result set.
+ *
+ * Parameters:
+ *	rowsPtr -- Materialized rows being accumulated
+ *	cell -- Index of the cell. Cells must be appended in order.
+ *	valueObj -- Value of the cell, or NULL if the cell is a SQL NULL.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+AppendCell(
+    MaterializedRows* rowsPtr,	/* Rows being accumulated */
+    size_t cell,		/* Index of the cell being appended */
+    Tcl_Obj* valueObj		/* Value to append, or NULL */
+) {
+    const char* bytes = "";
+    int length = 0;
+
+    if (valueObj == NULL) {
+	rowsPtr->nullBits[cell / 8] |= (unsigned char) (1 << (cell % 8));
+    } else {
+	bytes = Tcl_GetStringFromObj(valueObj, &length);
+    }
+
+    /* Grow the buffer geometrically to hold the value */
+
+    if (rowsPtr->bufferUsed + length > rowsPtr->bufferAlloc) {
+	size_t newAlloc = 2 * rowsPtr->bufferAlloc;
+	if (newAlloc < rowsPtr->bufferUsed + length) {
+	    newAlloc = rowsPtr->bufferUsed + length;
+	}
+	rowsPtr->buffer = ckrealloc(rowsPtr->buffer, newAlloc);
+	rowsPtr->bufferAlloc = newAlloc;
+    }
+    memcpy(rowsPtr->buffer + rowsPtr->bufferUsed, bytes, (size_t) length);
+    rowsPtr->bufferUsed += length;
+    rowsPtr->offsets[cell + 1] = rowsPtr->bufferUsed;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * MaterializedSize --
+ *
+ *	Returns the number of bytes allocated to a materialized result set.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static size_t
+MaterializedSize(
+    MaterializedRows* rowsPtr	/* Materialized rows */
+) {
+    size_t size = sizeof(MaterializedRows);
+
+    size += (rowsPtr->cellsAlloc + 1) * sizeof(size_t);
+    size += rowsPtr->cellsAlloc / 8 + 1;
+    size += rowsPtr->bufferAlloc;
+    if (rowsPtr->columnNames != NULL) {
+	size += TdbcObjSize(rowsPtr->columnNames);
+    }
+    return size;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcMaterializeObjCmd --
+ *
+ *	Reads all the rows of a result set into a compact arena, and
+ *	creates a command that gives random access to them.
+ *
+ * Usage:
+ *	::tdbc::Materialize name resultSet ?maxBytes?
+ *
+ * Parameters:
+ *	name -- Name of the command to create
+ *	resultSet -- Result set whose rows are to be read. Only the first
+ *		     set of results is read; the caller is responsible for
+ *		     closing the result set. If the driver has attached a
+ *		     Tdbc_ResultSetType to the result set, the rows are
+ *		     read through it rather than through the result set's
+ *		     methods.
+ *	maxBytes -- If given and positive, the size of the arena beyond
+ *		    which the rows are not read, and an error is raised.
+ *
+ * Results:
+ *	Returns the fully qualified name of the new command.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcMaterializeObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    MaterializedRows* rowsPtr;	/* Rows being accumulated */
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures, if any */
+    ClientData rsData = NULL;	/* Driver's data for the result set */
+    Tcl_Obj** values = NULL;	/* Cells fetched through 'typePtr' */
+    Tcl_WideInt rowCount;	/* Row count fetched through 'typePtr' */
+    Tcl_Obj* cmdObjs[3];	/* Command to fetch a row */
+    Tcl_Obj* rowVarObj;		/* Name of the variable receiving a row */
+    Tcl_Obj* rowObj;		/* Row returned from the result set */
+    Tcl_Obj** columnv;		/* Column names */
+    Tcl_Obj* valueObj;		/* Value of one cell */
+    Tcl_Obj* resultObj;		/* Fully qualified name of the command */
+    int more;			/* Flag == 1 if a row was fetched */
+    Tcl_WideInt maxBytes = 0;	/* Memory budget for the arena */
+    int status = TCL_OK;	/* Status return from Tcl */
+    int i;
+
+    if (objc != 3 && objc != 4) {
+	Tcl_WrongNumArgs(interp, 1, objv, "name resultSet ?maxBytes?");
+	return TCL_ERROR;
+    }
+    if (objc == 4
+	&& Tcl_GetWideIntFromObj(interp, objv[3], &maxBytes) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    rowsPtr = (MaterializedRows*) ckalloc(sizeof(MaterializedRows));
+    memset(rowsPtr, 0, sizeof(MaterializedRows));
+
+    /* Get the column names */
+
+    typePtr = TdbcGetResultSetTypeFromObj(interp, objv[2], &rsData);
+    cmdObjs[0] = objv[2];
+    if (typePtr != NULL) {
+	status = typePtr->columnsProc(interp, rsData, &rowsPtr->columnNames);
+    } else {
+	cmdObjs[1] = Tcl_NewStringObj("columns", -1);
+	Tcl_IncrRefCount(cmdObjs[1]);
+	status = Tcl_EvalObjv(interp, 2, cmdObjs, 0);
+	Tcl_DecrRefCount(cmdObjs[1]);
+	rowsPtr->columnNames = Tcl_GetObjResult(interp);
+    }
+    if (status != TCL_OK) {
+	ckfree((char*) rowsPtr);
+	return status;
+    }
+    Tcl_IncrRefCount(rowsPtr->columnNames);
+    if (Tcl_ListObjGetElements(interp, rowsPtr->columnNames,
+			       &rowsPtr->nColumns, &columnv) != TCL_OK) {
+	DeleteMaterializedRows((ClientData) rowsPtr);
+	return TCL_ERROR;
+    }
+
+    rowsPtr->cellsAlloc = 16 * (rowsPtr->nColumns + 1);
+    rowsPtr->offsets = (size_t*)
+	ckalloc((rowsPtr->cellsAlloc + 1) * sizeof(size_t));
+    rowsPtr->offsets[0] = 0;
+    rowsPtr->nullBits = (unsigned char*) ckalloc(rowsPtr->cellsAlloc / 8 + 1);
+    memset(rowsPtr->nullBits, 0, rowsPtr->cellsAlloc / 8 + 1);
+    rowsPtr->bufferAlloc = 256;
+    rowsPtr->buffer = ckalloc(rowsPtr->bufferAlloc);
+    if (typePtr != NULL) {
+	values = (Tcl_Obj**) ckalloc((rowsPtr->nColumns + 1)
+				     * sizeof(Tcl_Obj*));
+    }
+
+    /* Fetch the rows */
+
+    rowVarObj = Tcl_NewStringObj("::tdbc::MaterializeRow", -1);
+    Tcl_IncrRefCount(rowVarObj);
+    cmdObjs[1] = Tcl_NewStringObj("nextdict", -1);
+    cmdObjs[2] = rowVarObj;
+    Tcl_IncrRefCount(cmdObjs[1]);
+    for (;;) {
+	if (typePtr != NULL) {
+	    memset(values, 0, rowsPtr->nColumns * sizeof(Tcl_Obj*));
+	    status = typePtr->fetchRowProc(interp, rsData, rowsPtr->nColumns,
+					   values, &more);
+	    for (i = 0; i < rowsPtr->nColumns; ++i) {
+		if (values[i] != NULL) {
+		    Tcl_IncrRefCount(values[i]);
+		}
+	    }
+	    if (status != TCL_OK || !more) {
+		break;
+	    }
+	    rowObj = NULL;
+	} else {
+	    status = Tcl_EvalObjv(interp, 3, cmdObjs, 0);
+	    if (status != TCL_OK) {
+		break;
+	    }
+	    if ((status = Tcl_GetBooleanFromObj(interp,
+						Tcl_GetObjResult(interp),
+						&more)) != TCL_OK || !more) {
+		break;
+	    }
+	    rowObj = Tcl_ObjGetVar2(interp, rowVarObj, NULL,
+				    TCL_LEAVE_ERR_MSG);
+	    if (rowObj == NULL) {
+		status = TCL_ERROR;
+		break;
+	    }
+	}
+
+	/* Make room for one more row */
+
+	if ((size_t) (rowsPtr->nRows + 1) * rowsPtr->nColumns
+	    > rowsPtr->cellsAlloc) {
+	    size_t oldAlloc = rowsPtr->cellsAlloc;
+	    rowsPtr->cellsAlloc *= 2;
+	    rowsPtr->offsets = (size_t*)
+		ckrealloc((char*) rowsPtr->offsets,
+			  (rowsPtr->cellsAlloc + 1) * sizeof(size_t));
+	    rowsPtr->nullBits = (unsigned char*)
+		ckrealloc((char*) rowsPtr->nullBits,
+			  rowsPtr->cellsAlloc / 8 + 1);
+	    memset(rowsPtr->nullBits + oldAlloc / 8 + 1, 0,
+		   rowsPtr->cellsAlloc / 8 - oldAlloc / 8);
+	}
+
+	/* Copy the values. Columns missing from the dictionary are NULL. */
+
+	for (i = 0; i < rowsPtr->nColumns; ++i) {
+	    if (values != NULL) {
+		valueObj = values[i];
+	    } else if (Tcl_DictObjGet(interp, rowObj, columnv[i],
+				      &valueObj) != TCL_OK) {
+		status = TCL_ERROR;
+		break;
+	    }
+	    AppendCell(rowsPtr, (size_t) rowsPtr->nRows * rowsPtr->nColumns + i,
+		       valueObj);
+	}
+	if (values != NULL) {
+	    ReleaseCells(values, rowsPtr->nColumns);
+	}
+	if (status != TCL_OK) {
+	    break;
+	}
+	++rowsPtr->nRows;
+	if (maxBytes > 0 && (Tcl_WideInt) MaterializedSize(rowsPtr) > maxBytes) {
+	    status = TdbcMemoryLimitError(interp);
+	    break;
+	}
+    }
+    if (values != NULL) {
+	ReleaseCells(values, rowsPtr->nColumns);
+	ckfree((char*) values);
+    }
+    Tcl_UnsetVar(interp, Tcl_GetString(rowVarObj), 0);
+    Tcl_DecrRefCount(cmdObjs[1]);
+    Tcl_DecrRefCount(rowVarObj);
+
+    /* Retrieve the row count */
+
+    if (status == TCL_OK && typePtr != NULL) {
+	status = typePtr->rowCountProc(interp, rsData, &rowCount);
+	if (status == TCL_OK) {
+	    rowsPtr->rowCount = Tcl_NewWideIntObj(rowCount);
+	    Tcl_IncrRefCount(rowsPtr->rowCount);
+	}
+    } else if (status == TCL_OK) {
+	cmdObjs[1] = Tcl_NewStringObj("rowcount", -1);
+	Tcl_IncrRefCount(cmdObjs[1]);
+	status = Tcl_EvalObjv(interp, 2, cmdObjs, 0);
+	Tcl_DecrRefCount(cmdObjs[1]);
+	if (status == TCL_OK) {
+	    rowsPtr->rowCount = Tcl_GetObjResult(interp);
+	    Tcl_IncrRefCount(rowsPtr->rowCount);
+	}
+    }
+    if (status != TCL_OK) {
+	DeleteMaterializedRows((ClientData) rowsPtr);
+	return status;
+    }
+
+    /* Give back any excess space in the arena */
+
+    if (rowsPtr->bufferUsed > 0
+	&& rowsPtr->bufferUsed < rowsPtr->bufferAlloc) {
+	rowsPtr->buffer = ckrealloc(rowsPtr->buffer, rowsPtr->bufferUsed);
+	rowsPtr->bufferAlloc = rowsPtr->bufferUsed;
+    }
+
+    /* Make the command that accesses the rows */
+
+    rowsPtr->cmd = Tcl_CreateObjCommand(interp, Tcl_GetString(objv[1]),
+					MaterializedRowsObjCmd,
+					(ClientData) rowsPtr,
+					DeleteMaterializedRows);
+    resultObj = Tcl_NewObj();
+    Tcl_GetCommandFullName(interp, rowsPtr->cmd, resultObj);
+    Tcl_SetObjResult(interp, resultObj);
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * MaterializedRowsObjCmd --
+ *
+ *	Command that gives access to a materialized result set.
+ *
+ * Usage:
+ *	$rows close
+ *	$rows column name
+ *	$rows columns
+ *	$rows memory
+ *	$rows range ?-as lists|dicts? first last
+ *	$rows row ?-as lists|dicts? index
+ *	$rows rowcount
+ *	$rows size
+ *
+ * Results:
+ *	'column' returns a list of the values of a single column, with
+ *	NULLs replaced with empty strings. 'columns' returns the list of
+ *	column names. 'memory' returns the number of bytes that the rows
+ *	occupy. 'range' returns a list of rows, and 'row' returns
+ *	a single row, formatted as with 'nextdict' or 'nextlist'. 'rowcount'
+ *	returns the row count reported by the original result set, and
+ *	'size' returns the number of rows that were materialized.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+MaterializedRowsObjCmd(
+    ClientData clientData,	/* Materialized rows */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    MaterializedRows* rowsPtr = (MaterializedRows*) clientData;
+    static const char *const subcommands[] = {
+	"close", "column", "columns", "memory", "range", "row", "rowcount",
+	"size", NULL
+    };
+    enum Subcommands {
+	S_CLOSE, S_COLUMN, S_COLUMNS, S_MEMORY, S_RANGE, S_ROW, S_ROWCOUNT,
+	S_SIZE
+    };
+    int subcmd;
+    int skip;			/* Number of words consumed by options */
+    int asLists;		/* Flag == 1 if -as lists was requested */
+    int first, last;		/* Row indices */
+    int column;			/* Column index */
+    int nColumns;		/* Number of columns */
+    Tcl_Obj** columnv;		/* Column names */
+    Tcl_Obj* resultObj;		/* Result of the command */
+    int i;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], subcommands, "subcommand",
+			    0, &subcmd) != TCL_OK) {
+	return TCL_ERROR;
+    }
+
+    switch ((enum Subcommands) subcmd) {
+
+    case S_CLOSE:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_DeleteCommandFromToken(interp, rowsPtr->cmd);
+	return TCL_OK;
+
+    case S_COLUMN:
+	if (objc != 3) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "name");
+	    return TCL_ERROR;
+	}
+	Tcl_ListObjGetElements(NULL, rowsPtr->columnNames, &nColumns, &columnv);
+	for (column = 0; column < nColumns; ++column) {
+	    if (!strcmp(Tcl_GetString(columnv[column]),
+			Tcl_GetString(objv[2]))) {
+		break;
+	    }
+	}
+	if (column >= nColumns) {
+	    Tcl_AppendResult(interp, "no column named \"",
+			     Tcl_GetString(objv[2]), "\"", (char*) NULL);
+	    Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+			     "badColumn", Tcl_GetString(objv[2]),
+			     (char*) NULL);
+	    return TCL_ERROR;
+	}
+	resultObj = Tcl_NewListObj(0, NULL);
+	for (i = 0; i < rowsPtr->nRows; ++i) {
+	    Tcl_ListObjAppendElement(NULL, resultObj,
+				     MakeCell(rowsPtr,
+					      (size_t) i * rowsPtr->nColumns
+					      + column));
+	}
+	Tcl_SetObjResult(interp, resultObj);
+	return TCL_OK;
+
+    case S_COLUMNS:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, rowsPtr->columnNames);
+	return TCL_OK;
+
+    case S_MEMORY:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewWideIntObj((Tcl_WideInt)
+						   MaterializedSize(rowsPtr)));
+	return TCL_OK;
+
+    case S_RANGE:
+	if (ParseAsOption(interp, objc, objv, &skip, &asLists) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (objc - skip != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?-as lists|dicts? first last");
+	    return TCL_ERROR;
+	}
+	if (GetRowIndex(interp, rowsPtr, objv[skip], &first) != TCL_OK
+	    || GetRowIndex(interp, rowsPtr, objv[skip+1], &last) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (first < 0) {
+	    first = 0;
+	}
+	if (last >= rowsPtr->nRows) {
+	    last = rowsPtr->nRows - 1;
+	}
+	resultObj = Tcl_NewListObj(0, NULL);
+	for (i = first; i <= last; ++i) {
+	    Tcl_ListObjAppendElement(NULL, resultObj,
+				     MakeRow(rowsPtr, i, asLists));
+	}
+	Tcl_SetObjResult(interp, resultObj);
+	return TCL_OK;
+
+    case S_ROW:
+	if (ParseAsOption(interp, objc, objv, &skip, &asLists) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (objc - skip != 1) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "?-as lists|dicts? index");
+	    return TCL_ERROR;
+	}
+	if (GetRowIndex(interp, rowsPtr, objv[skip], &first) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (first < 0 || first >= rowsPtr->nRows) {
+	    Tcl_AppendResult(interp, "row index \"", Tcl_GetString(objv[skip]),
+			     "\" out of range", (char*) NULL);
+	    Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+			     "badIndex", Tcl_GetString(objv[skip]),
+			     (char*) NULL);
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, MakeRow(rowsPtr, first, asLists));
+	return TCL_OK;
+
+    case S_ROWCOUNT:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, rowsPtr->rowCount);
+	return TCL_OK;
+
+    case S_SIZE:
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewIntObj(rowsPtr->nRows));
+	return TCL_OK;
+    }
+
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ParseAsOption --
+ *
+ *	Parses the optional '-as lists|dicts' option to 'row' and 'range'
+ *
+ * Results:
+ *	Returns a standard Tcl result. Stores in *skipPtr the index of the
+ *	first argument following the options, and in *asListsPtr a flag
+ *	that is 1 if the rows are to be formatted as lists.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+ParseAsOption(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[],	/* Parameter vector */
+    int* skipPtr,		/* OUTPUT: Index of first non-option */
+    int* asListsPtr		/* OUTPUT: 1 if rows are lists */
+) {
+    int i = 2;
+    int optIndex;
+    int asValue;
+
+    *asListsPtr = 0;
+    while (i < objc && Tcl_GetString(objv[i])[0] == '-') {
+	if (!strcmp(Tcl_GetString(objv[i]), "--")) {
+	    ++i;
+	    break;
+	}
+	if (Tcl_GetIndexFromObj(interp, objv[i], asOptions, "option",
+				0, &optIndex) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (i + 1 >= objc) {
+	    Tcl_AppendResult(interp, "missing value for \"",
+			     Tcl_GetString(objv[i]), "\" option",
+			     (char*) NULL);
+	    return TCL_ERROR;
+	}
+	if (Tcl_GetIndexFromObj(interp, objv[i+1], asValues, "variable type",
+				0, &asValue) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	*asListsPtr = (asValue == AS_LISTS);
+	i += 2;
+    }
+    *skipPtr = i;
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * GetRowIndex --
+ *
+ *	Interprets a row index, which may be an integer, 'end', or
+ *	'end-integer'.
+ *
+ * Results:
+ *	Returns a standard Tcl result, and stores the index in *indexPtr.
+ *	The index is not checked against the size of the result.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+GetRowIndex(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    MaterializedRows* rowsPtr,	/* Materialized rows */
+    Tcl_Obj* indexObj,		/* Index to interpret */
+    int* indexPtr		/* OUTPUT: Interpreted index */
+) {
+    const char* index = Tcl_GetString(indexObj);
+    int offset = 0;
+
+    if (!strncmp(index, "end", 3)) {
+	if (index[3] == '\0'
+	    || (index[3] == '-'
+		&& Tcl_GetInt(NULL, index + 4, &offset) == TCL_OK)) {
+	    *indexPtr = rowsPtr->nRows - 1 - offset;
+	    return TCL_OK;
+	}
+    } else if (Tcl_GetIntFromObj(NULL, indexObj, indexPtr) == TCL_OK) {
+	return TCL_OK;
+    }
+    Tcl_AppendResult(interp, "bad index \"", index,
+		     "\": must be integer, end or end-integer", (char*) NULL);
+    Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+		     "badIndex", index, (char*) NULL);
+    return TCL_ERROR;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * MakeCell --
+ *
+ *	Makes a Tcl object holding the value of a single cell.
+ *
+ * Results:
+ *	Returns a zero-reference object. NULLs become empty strings.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+MakeCell(
+    MaterializedRows* rowsPtr,	/* Materialized rows */
+    size_t cell			/* Index of the cell */
+) {
+    size_t start = rowsPtr->offsets[cell];
+    return Tcl_NewStringObj(rowsPtr->buffer + start,
+			    (int) (rowsPtr->offsets[cell + 1] - start));
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * MakeRow --
+ *
+ *	Makes a Tcl object holding a row of a materialized result.
+ *
+ * Results:
+ *	Returns a zero-reference object containing the row, formatted as a
+ *	list (as with 'nextlist') or a dictionary (as with 'nextdict').
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+MakeRow(
+    MaterializedRows* rowsPtr,	/* Materialized rows */
+    int row,			/* Index of the row */
+    int asLists			/* 1 to make a list, 0 to make a dict */
+) {
+    Tcl_Obj** columnv;
+    Tcl_Obj* rowObj;
+    size_t cell = (size_t) row * rowsPtr->nColumns;
+    int nColumns;
+    int i;
+
+    Tcl_ListObjGetElements(NULL, rowsPtr->columnNames, &nColumns, &columnv);
+    rowObj = asLists ? Tcl_NewListObj(0, NULL) : Tcl_NewDictObj();
+    for (i = 0; i < rowsPtr->nColumns; ++i, ++cell) {
+	if (rowsPtr->nullBits[cell / 8] & (1 << (cell % 8))) {
+	    if (asLists) {
+		Tcl_ListObjAppendElement(NULL, rowObj, Tcl_NewObj());
+	    }
+	} else if (asLists) {
+	    Tcl_ListObjAppendElement(NULL, rowObj, MakeCell(rowsPtr, cell));
+	} else {
+	    Tcl_DictObjPut(NULL, rowObj, columnv[i], MakeCell(rowsPtr, cell));
+	}
+    }
+    return rowObj;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeleteMaterializedRows --
+ *
+ *	Frees a materialized result set when its command is deleted.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeleteMaterializedRows(
+    ClientData clientData	/* Materialized rows */
+) {
+    MaterializedRows* rowsPtr = (MaterializedRows*) clientData;
+    if (rowsPtr->columnNames != NULL) {
+	Tcl_DecrRefCount(rowsPtr->columnNames);
+    }
+    if (rowsPtr->rowCount != NULL) {
+	Tcl_DecrRefCount(rowsPtr->rowCount);
+    }
+    if (rowsPtr->offsets != NULL) {
+	ckfree((char*) rowsPtr->offsets);
+    }
+    if (rowsPtr->nullBits != NULL) {
+	ckfree((char*) rowsPtr->nullBits);
+    }
+    if (rowsPtr->buffer != NULL) {
+	ckfree(rowsPtr->buffer);
+    }
+    ckfree((char*) rowsPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ReleaseCells --
+ *
+ *	Releases the cell values fetched through a driver's
+ *	Tdbc_ResultSetType, and clears the array that holds them.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+ReleaseCells(
+    Tcl_Obj** values,		/* Cell values */
+    int nColumns		/* Number of cells */
+) {
+    int i;
+
+    for (i = 0; i < nColumns; ++i) {
+	if (values[i] != NULL) {
+	    Tcl_DecrRefCount(values[i]);
+	    values[i] = NULL;
+	}
+    }
+}
@@ -0,0 +1,171 @@
+/*
+ * tdbcMemory.c --
+ *
+ *	Estimates of the memory that TDBC objects hold, and the error that
+ *	is raised when a fetch exceeds a connection's '-maxmemory' budget.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+
+/*
+ * Depth below which the elements of lists and dictionaries are examined.
+ * Deeper values are counted by the length of their string representation.
+ */
+
+#define SIZEOF_MAX_DEPTH 8
+
+/*
+ * Approximate bytes of overhead for each element of a list and each entry
+ * of a dictionary, beyond the values themselves.
+ */
+
+#define LIST_ELEMENT_OVERHEAD sizeof(Tcl_Obj*)
+#define DICT_ENTRY_OVERHEAD (4 * sizeof(void*))
+
+/* Static functions defined in this file */
+
+static size_t ObjSize(Tcl_Obj* objPtr, int depth);
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ObjSize --
+ *
+ *	Estimates the number of bytes that a Tcl value occupies.
+ *
+ * Results:
+ *	Returns the estimate.
+ *
+ * The estimate is made without generating string representations or
+ * changing the internal representation of any value. Values that are
+ * shared among several lists are counted once for each list.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static size_t
+ObjSize(
+    Tcl_Obj* objPtr,		/* Value to examine */
+    int depth			/* Depth of nesting of the value */
+) {
+    static const Tcl_ObjType* listTypePtr = NULL;
+    static const Tcl_ObjType* dictTypePtr = NULL;
+    size_t size = sizeof(Tcl_Obj);
+    Tcl_Obj** elemv;
+    int elemc;
+    Tcl_DictSearch search;
+    Tcl_Obj* keyObj;
+    Tcl_Obj* valueObj;
+    int done;
+    int i;
+
+    if (listTypePtr == NULL) {
+	listTypePtr = Tcl_GetObjType("list");
+	dictTypePtr = Tcl_GetObjType("dict");
+    }
+    if (objPtr->bytes != NULL) {
+	size += objPtr->length + 1;
+    }
+    if (depth >= SIZEOF_MAX_DEPTH) {
+	return size;
+    }
+    if (objPtr->typePtr == listTypePtr && listTypePtr != NULL) {
+	Tcl_ListObjGetElements(NULL, objPtr, &elemc, &elemv);
+	for (i = 0; i < elemc; ++i) {
+	    size += LIST_ELEMENT_OVERHEAD + ObjSize(elemv[i], depth + 1);
+	}
+    } else if (objPtr->typePtr == dictTypePtr && dictTypePtr != NULL) {
+	if (Tcl_DictObjFirst(NULL, objPtr, &search, &keyObj, &valueObj,
+			     &done) == TCL_OK) {
+	    for (; !done; Tcl_DictObjNext(&search, &keyObj, &valueObj, &done)) {
+		size += DICT_ENTRY_OVERHEAD + ObjSize(keyObj, depth + 1)
+		    + ObjSize(valueObj, depth + 1);
+	    }
+	    Tcl_DictObjDone(&search);
+	}
+    }
+    return size;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcObjSize --
+ *
+ *	Estimates the number of bytes that a Tcl value occupies, including
+ *	the elements of lists and dictionaries.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE size_t
+TdbcObjSize(
+    Tcl_Obj* objPtr		/* Value to examine */
+) {
+    return ObjSize(objPtr, 0);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcSizeOfObjCmd --
+ *
+ *	Estimates the number of bytes that a Tcl value occupies.
+ *
+ * Usage:
+ *	::tdbc::SizeOf value
+ *
+ * Results:
+ *	Returns the estimate.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcSizeOfObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "value");
+	return TCL_ERROR;
+    }
+    Tcl_SetObjResult(interp, Tcl_NewWideIntObj((Tcl_WideInt)
+					       TdbcObjSize(objv[1])));
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcMemoryLimitError --
+ *
+ *	Reports that a fetch has exceeded the memory budget of its
+ *	connection.
+ *
+ * Results:
+ *	Returns TCL_ERROR, with the message and error code in the
+ *	interpreter.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcMemoryLimitError(
+    Tcl_Interp* interp		/* Tcl interpreter */
+) {
+    Tcl_SetObjResult(interp, Tcl_NewStringObj(
+	"result exceeds the memory budget of the connection", -1));
+    Tcl_SetErrorCode(interp, "TDBC", "INSUFFICIENT_RESOURCES", "53200", "",
+		     "maxmemory", NULL);
+    return TCL_ERROR;
+}
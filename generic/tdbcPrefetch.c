@@ -0,0 +1,668 @@
+/*
+ * tdbcPrefetch.c --
+ *
+ *	Read-ahead for result sets whose driver fetches rows through a
+ *	Tdbc_ResultSetType that is marked TDBC_FETCH_THREADSAFE. A thread
+ *	that TDBC owns fetches rows into a bounded queue while the
+ *	interpreter's thread processes the rows already fetched.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <string.h>
+
+/*
+ * State of the thread that fetches rows
+ */
+
+enum PrefetchState {
+    PREFETCH_IDLE,		/* No thread is running */
+    PREFETCH_RUNNING,		/* The thread is fetching rows */
+    PREFETCH_STOPPING,		/* The thread has been asked to stop */
+    PREFETCH_END,		/* The thread reached the end of the rows */
+    PREFETCH_ERROR		/* The driver reported an error */
+};
+
+/*
+ * Structure that describes the read-ahead for a result set. While it is
+ * in effect, it replaces the driver's Tdbc_ResultSetType on the result set
+ * object, and the driver's table and data are kept here.
+ */
+
+typedef struct Prefetch {
+    Tcl_Object object;		/* Result set */
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures */
+    ClientData clientData;	/* Driver's data for the result set */
+    Tcl_Obj* columnsObj;	/* Names of the columns of the current set
+				 * of results */
+    int nColumns;		/* Number of columns */
+    int capacity;		/* Number of rows that the queue holds */
+    Tcl_Obj** queue;		/* Cells of the queued rows, 'nColumns' per
+				 * row, with reference counts of zero */
+    int head;			/* Index of the first queued row */
+    int count;			/* Number of queued rows */
+    int state;			/* State of the thread */
+    int joinable;		/* 1 if the thread has been created and has
+				 * not yet been joined */
+    Tcl_Obj* errorObj;		/* Error message reported by the driver */
+    Tcl_Obj* errorCodeObj;	/* Error code reported by the driver */
+    Tcl_ThreadId thread;	/* Thread that fetches rows */
+    Tcl_Mutex mutex;		/* Mutex that protects the queue and state */
+    Tcl_Condition changed;	/* Condition notified when the queue or the
+				 * state changes */
+} Prefetch;
+
+/* Static procedures declared in this file */
+
+static int PrefetchColumns(Tcl_Interp* interp, ClientData clientData,
+			   Tcl_Obj** columnsPtr);
+static int PrefetchFetchRow(Tcl_Interp* interp, ClientData clientData,
+			    int nColumns, Tcl_Obj** values, int* gotRowPtr);
+static int PrefetchNextResults(Tcl_Interp* interp, ClientData clientData,
+			       int* moreResultsPtr);
+static int PrefetchRowCount(Tcl_Interp* interp, ClientData clientData,
+			    Tcl_WideInt* rowCountPtr);
+static Tcl_ThreadCreateType PrefetchThread(ClientData clientData);
+static int StartThread(Tcl_Interp* interp, Prefetch* pfPtr);
+static void StopThread(Prefetch* pfPtr);
+static void DiscardQueue(Prefetch* pfPtr);
+static void FreeValues(Tcl_Obj** values, int n);
+static void DeletePrefetch(ClientData clientData);
+
+/*
+ * Table of procedures that stands in for the driver's while read-ahead is
+ * in effect.
+ */
+
+static const Tdbc_ResultSetType prefetchType = {
+    "prefetch",			/* name */
+    TDBC_RESULTSETTYPE_VERSION_2,
+				/* version */
+    PrefetchColumns,		/* columnsProc */
+    PrefetchFetchRow,		/* fetchRowProc */
+    PrefetchNextResults,	/* nextResultsProc */
+    PrefetchRowCount,		/* rowCountProc */
+    0				/* flags */
+};
+
+/*
+ * The read-ahead state is attached to the result set object as metadata,
+ * so that the thread is stopped and the state freed however the object is
+ * destroyed. The base class's destructor stops the thread earlier, before
+ * a driver's destructor may free the driver's data; the metadata is only
+ * the last resort, since the order in which an object's metadata are
+ * deleted is not defined.
+ */
+
+static const Tcl_ObjectMetadataType prefetchMetadata = {
+    TCL_OO_METADATA_VERSION_CURRENT,
+				/* version */
+    "TdbcPrefetch",		/* name */
+    DeletePrefetch,		/* deleteProc */
+    NULL			/* cloneProc */
+};
+
+/* Subcommands of ::tdbc::Prefetch */
+
+static const char *const prefetchSubcommands[] = {
+    "columns", "nextresults", "rowcount", "start", "stop", NULL
+};
+enum PrefetchSubcommand {
+    PF_COLUMNS, PF_NEXTRESULTS, PF_ROWCOUNT, PF_START, PF_STOP
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcPrefetchObjCmd --
+ *
+ *	Controls read-ahead on a result set.
+ *
+ * Usage:
+ *	::tdbc::Prefetch resultSet start n
+ *		Starts reading up to 'n' rows ahead. Returns 1 if read-ahead
+ *		has started, or 0 if the result set's driver does not
+ *		permit rows to be fetched in another thread.
+ *	::tdbc::Prefetch resultSet columns
+ *	::tdbc::Prefetch resultSet nextresults
+ *	::tdbc::Prefetch resultSet rowcount
+ *		Do as the result set methods of the same names.
+ *	::tdbc::Prefetch resultSet stop
+ *		Stops the read-ahead, discarding any rows that have been
+ *		read, and gives the result set back to its driver.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcPrefetchObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Object object;
+    const Tdbc_ResultSetType* typePtr;
+    ClientData rsData;
+    Prefetch* pfPtr;
+    Tcl_Obj* columnsObj;
+    Tcl_WideInt rowCount;
+    int capacity;
+    int more;
+    int index;
+
+    if (objc < 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "resultSet subcommand ?arg?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[2], prefetchSubcommands,
+			    "subcommand", 0, &index) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if ((index == PF_START && objc != 4) || (index != PF_START && objc != 3)) {
+	Tcl_WrongNumArgs(interp, 3, objv, index == PF_START ? "n" : "");
+	return TCL_ERROR;
+    }
+    object = Tcl_GetObjectFromObj(interp, objv[1]);
+    if (object == NULL) {
+	return TCL_ERROR;
+    }
+    typePtr = Tdbc_GetResultSetType(object, &rsData);
+
+    if (index == PF_START) {
+	if (Tcl_GetIntFromObj(interp, objv[3], &capacity) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (capacity < 1) {
+	    Tcl_SetObjResult(interp,
+			     Tcl_ObjPrintf("bad value \"%s\" for option "
+					   "\"-prefetch\"",
+					   Tcl_GetString(objv[3])));
+	    Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+			     "badOptionValue", "-prefetch",
+			     Tcl_GetString(objv[3]), NULL);
+	    return TCL_ERROR;
+	}
+	if (typePtr == NULL || typePtr == &prefetchType
+	        || typePtr->version < TDBC_RESULTSETTYPE_VERSION_2
+	        || !(typePtr->flags & TDBC_FETCH_THREADSAFE)) {
+	    Tcl_SetObjResult(interp, Tcl_NewBooleanObj(0));
+	    return TCL_OK;
+	}
+	if (typePtr->columnsProc(interp, rsData, &columnsObj) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	pfPtr = (Prefetch*) ckalloc(sizeof(Prefetch));
+	memset(pfPtr, 0, sizeof(Prefetch));
+	pfPtr->object = object;
+	pfPtr->typePtr = typePtr;
+	pfPtr->clientData = rsData;
+	pfPtr->columnsObj = columnsObj;
+	Tcl_IncrRefCount(columnsObj);
+	Tcl_ListObjLength(NULL, columnsObj, &pfPtr->nColumns);
+	pfPtr->capacity = capacity;
+	pfPtr->queue = (Tcl_Obj**) ckalloc(capacity * (pfPtr->nColumns + 1)
+					   * sizeof(Tcl_Obj*));
+	pfPtr->state = PREFETCH_IDLE;
+	if (StartThread(interp, pfPtr) != TCL_OK) {
+
+	    /* No threads in this build: fetch in the interpreter's thread */
+
+	    Tcl_DecrRefCount(pfPtr->columnsObj);
+	    ckfree((char*) pfPtr->queue);
+	    ckfree((char*) pfPtr);
+	    Tcl_SetObjResult(interp, Tcl_NewBooleanObj(0));
+	    return TCL_OK;
+	}
+	Tcl_ObjectSetMetadata(object, &prefetchMetadata, (ClientData) pfPtr);
+	Tdbc_SetResultSetType(object, &prefetchType, (ClientData) pfPtr);
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(1));
+	return TCL_OK;
+    }
+
+    if (typePtr != &prefetchType) {
+	Tcl_SetObjResult(interp, Tcl_ObjPrintf("\"%s\" is not reading ahead",
+					       Tcl_GetString(objv[1])));
+	return TCL_ERROR;
+    }
+    pfPtr = (Prefetch*) rsData;
+
+    switch ((enum PrefetchSubcommand) index) {
+    case PF_COLUMNS:
+	Tcl_SetObjResult(interp, pfPtr->columnsObj);
+	return TCL_OK;
+    case PF_NEXTRESULTS:
+	if (PrefetchNextResults(interp, rsData, &more) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(more));
+	return TCL_OK;
+    case PF_ROWCOUNT:
+	if (PrefetchRowCount(interp, rsData, &rowCount) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	Tcl_SetObjResult(interp, Tcl_NewWideIntObj(rowCount));
+	return TCL_OK;
+    case PF_STOP:
+	StopThread(pfPtr);
+	Tdbc_SetResultSetType(object, pfPtr->typePtr, pfPtr->clientData);
+	Tcl_ObjectSetMetadata(object, &prefetchMetadata, NULL);
+	return TCL_OK;
+    default:
+	return TCL_OK;
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * PrefetchThread --
+ *
+ *	Body of the thread that fetches rows ahead of the interpreter.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_ThreadCreateType
+PrefetchThread(
+    ClientData clientData	/* Read-ahead state */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+    Tcl_Obj* staticValues[16];
+    Tcl_Obj** values = staticValues;
+    int nColumns = pfPtr->nColumns;
+    int gotRow;
+    int status;
+    int tail;
+
+    if (nColumns + 1 > 16) {
+	values = (Tcl_Obj**) ckalloc((nColumns + 1) * sizeof(Tcl_Obj*));
+    }
+    for (;;) {
+
+	/* Wait for room in the queue */
+
+	Tcl_MutexLock(&pfPtr->mutex);
+	while (pfPtr->state == PREFETCH_RUNNING
+	       && pfPtr->count == pfPtr->capacity) {
+	    Tcl_ConditionWait(&pfPtr->changed, &pfPtr->mutex, NULL);
+	}
+	if (pfPtr->state != PREFETCH_RUNNING) {
+	    Tcl_MutexUnlock(&pfPtr->mutex);
+	    break;
+	}
+	Tcl_MutexUnlock(&pfPtr->mutex);
+
+	/*
+	 * Fetch a row without holding the mutex, so that the interpreter's
+	 * thread can take rows from the queue meanwhile.
+	 */
+
+	memset(values, 0, (nColumns + 1) * sizeof(Tcl_Obj*));
+	gotRow = 0;
+	status = pfPtr->typePtr->fetchRowProc(NULL, pfPtr->clientData,
+					      nColumns, values, &gotRow);
+
+	Tcl_MutexLock(&pfPtr->mutex);
+	if (status != TCL_OK) {
+	    pfPtr->errorObj = values[0] ? values[0]
+		: Tcl_NewStringObj("error fetching a row", -1);
+	    Tcl_IncrRefCount(pfPtr->errorObj);
+	    pfPtr->errorCodeObj = values[1];
+	    if (pfPtr->errorCodeObj != NULL) {
+		Tcl_IncrRefCount(pfPtr->errorCodeObj);
+	    }
+	    pfPtr->state = PREFETCH_ERROR;
+	} else if (!gotRow) {
+	    pfPtr->state = PREFETCH_END;
+	} else {
+	    tail = (pfPtr->head + pfPtr->count) % pfPtr->capacity;
+	    memcpy(pfPtr->queue + tail * nColumns, values,
+		   nColumns * sizeof(Tcl_Obj*));
+	    ++pfPtr->count;
+	}
+	Tcl_ConditionNotify(&pfPtr->changed);
+	Tcl_MutexUnlock(&pfPtr->mutex);
+	if (status != TCL_OK || !gotRow) {
+	    break;
+	}
+    }
+    if (values != staticValues) {
+	ckfree((char*) values);
+    }
+    Tcl_ExitThread(TCL_OK);
+    TCL_THREAD_CREATE_RETURN;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * StartThread --
+ *
+ *	Starts the thread that fetches rows, unless the end of the current
+ *	set of results has been reached.
+ *
+ * Results:
+ *	Returns TCL_ERROR if the thread cannot be created.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+StartThread(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    Prefetch* pfPtr		/* Read-ahead state */
+) {
+#ifndef TCL_THREADS
+    /* Without threads, the mutex and condition calls do nothing */
+
+    return TCL_ERROR;
+#else
+    if (pfPtr->state == PREFETCH_END || pfPtr->state == PREFETCH_ERROR) {
+	return TCL_OK;
+    }
+    pfPtr->state = PREFETCH_RUNNING;
+    if (Tcl_CreateThread(&pfPtr->thread, PrefetchThread, (ClientData) pfPtr,
+			 TCL_THREAD_STACK_DEFAULT,
+			 TCL_THREAD_JOINABLE) != TCL_OK) {
+	pfPtr->state = PREFETCH_IDLE;
+	return TCL_ERROR;
+    }
+    pfPtr->joinable = 1;
+    return TCL_OK;
+#endif
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * StopThread --
+ *
+ *	Stops the thread that fetches rows and waits for it to exit, so
+ *	that the driver may be called from the interpreter's thread. Rows
+ *	already in the queue are kept. A thread that has reached the end of
+ *	the rows or an error has exited by itself, but must still be joined,
+ *	once.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+StopThread(
+    Prefetch* pfPtr		/* Read-ahead state */
+) {
+    int result;
+
+    if (!pfPtr->joinable) {
+	return;
+    }
+    Tcl_MutexLock(&pfPtr->mutex);
+    if (pfPtr->state == PREFETCH_RUNNING) {
+	pfPtr->state = PREFETCH_STOPPING;
+	Tcl_ConditionNotify(&pfPtr->changed);
+    }
+    Tcl_MutexUnlock(&pfPtr->mutex);
+    Tcl_JoinThread(pfPtr->thread, &result);
+    pfPtr->joinable = 0;
+    if (pfPtr->state == PREFETCH_STOPPING) {
+	pfPtr->state = PREFETCH_IDLE;
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DiscardQueue --
+ *
+ *	Frees the rows in the queue. The thread must not be running.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DiscardQueue(
+    Prefetch* pfPtr		/* Read-ahead state */
+) {
+    while (pfPtr->count > 0) {
+	FreeValues(pfPtr->queue + pfPtr->head * pfPtr->nColumns,
+		   pfPtr->nColumns);
+	pfPtr->head = (pfPtr->head + 1) % pfPtr->capacity;
+	--pfPtr->count;
+    }
+    pfPtr->head = 0;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeletePrefetch --
+ *
+ *	Stops the read-ahead and frees its state, when it is stopped or the
+ *	result set is destroyed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeletePrefetch(
+    ClientData clientData	/* Read-ahead state */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+
+    StopThread(pfPtr);
+    DiscardQueue(pfPtr);
+    Tcl_DecrRefCount(pfPtr->columnsObj);
+    if (pfPtr->errorObj != NULL) {
+	Tcl_DecrRefCount(pfPtr->errorObj);
+    }
+    if (pfPtr->errorCodeObj != NULL) {
+	Tcl_DecrRefCount(pfPtr->errorCodeObj);
+    }
+    Tcl_MutexFinalize(&pfPtr->mutex);
+    Tcl_ConditionFinalize(&pfPtr->changed);
+    ckfree((char*) pfPtr->queue);
+    ckfree((char*) pfPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * PrefetchColumns --
+ *
+ *	Returns the names of the columns of the current set of results,
+ *	which were read when the set was begun.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+PrefetchColumns(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Read-ahead state */
+    Tcl_Obj** columnsPtr	/* OUTPUT: Column names */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+
+    *columnsPtr = pfPtr->columnsObj;
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * PrefetchFetchRow --
+ *
+ *	Takes the next row from the queue, waiting for the thread to fetch
+ *	it if need be.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+PrefetchFetchRow(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Read-ahead state */
+    int nColumns,		/* Number of columns wanted */
+    Tcl_Obj** values,		/* OUTPUT: Cells of the row */
+    int* gotRowPtr		/* OUTPUT: 1 if a row was fetched */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+    Tcl_Obj** rowPtr;
+    int n = (nColumns < pfPtr->nColumns) ? nColumns : pfPtr->nColumns;
+    int status = TCL_OK;
+
+    *gotRowPtr = 0;
+    Tcl_MutexLock(&pfPtr->mutex);
+    while (pfPtr->count == 0 && pfPtr->state == PREFETCH_RUNNING) {
+	Tcl_ConditionWait(&pfPtr->changed, &pfPtr->mutex, NULL);
+    }
+    if (pfPtr->count > 0) {
+	rowPtr = pfPtr->queue + pfPtr->head * pfPtr->nColumns;
+	memcpy(values, rowPtr, n * sizeof(Tcl_Obj*));
+	FreeValues(rowPtr + n, pfPtr->nColumns - n);
+	pfPtr->head = (pfPtr->head + 1) % pfPtr->capacity;
+	--pfPtr->count;
+	*gotRowPtr = 1;
+	Tcl_ConditionNotify(&pfPtr->changed);
+    } else if (pfPtr->state == PREFETCH_ERROR) {
+	Tcl_SetObjResult(interp, pfPtr->errorObj);
+	if (pfPtr->errorCodeObj != NULL) {
+	    Tcl_SetObjErrorCode(interp, pfPtr->errorCodeObj);
+	}
+	status = TCL_ERROR;
+    }
+    Tcl_MutexUnlock(&pfPtr->mutex);
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * PrefetchNextResults --
+ *
+ *	Advances to the next set of results, discarding the rows of the
+ *	current set that have been read ahead, and resumes reading ahead.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+PrefetchNextResults(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Read-ahead state */
+    int* moreResultsPtr		/* OUTPUT: 1 if there is another set */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+    Tcl_Obj* columnsObj;
+    int nColumns;
+
+    StopThread(pfPtr);
+    DiscardQueue(pfPtr);
+    if (pfPtr->state == PREFETCH_ERROR) {
+	Tcl_SetObjResult(interp, pfPtr->errorObj);
+	if (pfPtr->errorCodeObj != NULL) {
+	    Tcl_SetObjErrorCode(interp, pfPtr->errorCodeObj);
+	}
+	return TCL_ERROR;
+    }
+    *moreResultsPtr = 0;
+    if (pfPtr->typePtr->nextResultsProc == NULL) {
+	return TCL_OK;
+    }
+    if (pfPtr->typePtr->nextResultsProc(interp, pfPtr->clientData,
+					moreResultsPtr) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (!*moreResultsPtr) {
+	return TCL_OK;
+    }
+
+    /* Size the queue for the new set of results, and resume */
+
+    if (pfPtr->typePtr->columnsProc(interp, pfPtr->clientData,
+				    &columnsObj) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    Tcl_IncrRefCount(columnsObj);
+    Tcl_DecrRefCount(pfPtr->columnsObj);
+    pfPtr->columnsObj = columnsObj;
+    Tcl_ListObjLength(NULL, columnsObj, &nColumns);
+    if (nColumns > pfPtr->nColumns) {
+	ckfree((char*) pfPtr->queue);
+	pfPtr->queue = (Tcl_Obj**) ckalloc(pfPtr->capacity * (nColumns + 1)
+					   * sizeof(Tcl_Obj*));
+    }
+    pfPtr->nColumns = nColumns;
+    pfPtr->state = PREFETCH_IDLE;
+    if (StartThread(interp, pfPtr) != TCL_OK) {
+	Tcl_SetObjResult(interp,
+			 Tcl_NewStringObj("can't create a thread to read "
+					  "ahead", -1));
+	return TCL_ERROR;
+    }
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * PrefetchRowCount --
+ *
+ *	Asks the driver for the row count, pausing the read-ahead while it
+ *	does so.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+PrefetchRowCount(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Read-ahead state */
+    Tcl_WideInt* rowCountPtr	/* OUTPUT: Row count */
+) {
+    Prefetch* pfPtr = (Prefetch*) clientData;
+    int status;
+
+    StopThread(pfPtr);
+    status = pfPtr->typePtr->rowCountProc(interp, pfPtr->clientData,
+					  rowCountPtr);
+    if (StartThread(interp, pfPtr) != TCL_OK) {
+	Tcl_SetObjResult(interp,
+			 Tcl_NewStringObj("can't create a thread to read "
+					  "ahead", -1));
+	return TCL_ERROR;
+    }
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FreeValues --
+ *
+ *	Frees cells that were fetched but not handed out.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+FreeValues(
+    Tcl_Obj** values,		/* Cells, with reference counts of zero */
+    int n			/* Number of cells */
+) {
+    int i;
+
+    for (i = 0; i < n; ++i) {
+	if (values[i] != NULL) {
+	    Tcl_IncrRefCount(values[i]);
+	    Tcl_DecrRefCount(values[i]);
+	}
+    }
+}
@@ -0,0 +1,782 @@
+/*
+ * tdbcResultSet.c --
+ *
+ *	Code that lets drivers written in C attach a table of procedures to
+ *	their result sets, and that lets the framework fetch rows through
+ *	it without dispatching to the result sets' methods.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <string.h>
+
+/*
+ * Metadata attached to a result set object by Tdbc_SetResultSetType.
+ */
+
+typedef struct ResultSetTypeData {
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures */
+    ClientData clientData;	/* Driver's data for the result set */
+} ResultSetTypeData;
+
+/* Options to the commands that fetch rows */
+
+static const char *const asValues[] = {
+    "dicts", "lists", NULL
+};
+enum AsValues {
+    AS_DICTS, AS_LISTS
+};
+
+/* Static procedures declared in this file */
+
+static int CloneResultSetTypeData(Tcl_Interp* interp, ClientData oldData,
+				  ClientData* newDataPtr);
+static void DeleteResultSetTypeData(ClientData clientData);
+static int FetchCells(Tcl_Interp* interp, Tcl_Object object,
+		      const Tdbc_ResultSetType* typePtr,
+		      ClientData clientData, Tcl_Obj* columnsObj,
+		      int nColumns, Tcl_Obj** values, int* gotRowPtr);
+static int FetchRow(Tcl_Interp* interp, Tcl_Object object,
+		    const Tdbc_ResultSetType* typePtr,
+		    ClientData clientData, Tcl_Obj* columnsObj, int asLists,
+		    Tcl_Obj** rowPtr);
+
+/* Type of the metadata */
+
+static const Tcl_ObjectMetadataType resultSetTypeMetadata = {
+    TCL_OO_METADATA_VERSION_CURRENT,
+				/* version */
+    "TdbcResultSetType",	/* name */
+    DeleteResultSetTypeData,	/* deleteProc */
+    CloneResultSetTypeData	/* cloneProc */
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_SetResultSetType --
+ *
+ *	Attaches a driver's table of procedures to a result set object.
+ *
+ * Parameters:
+ *	object -- Result set object
+ *	typePtr -- Table of procedures, which must remain valid as long as
+ *		   the object exists; or NULL to detach any table.
+ *	clientData -- Data passed to the procedures. The driver remains
+ *		      responsible for freeing it.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI void
+Tdbc_SetResultSetType(
+    Tcl_Object object,		/* Result set object */
+    const Tdbc_ResultSetType* typePtr,
+				/* Table of procedures */
+    ClientData clientData	/* Data for the procedures */
+) {
+    ResultSetTypeData* dataPtr = NULL;
+
+    if (typePtr != NULL) {
+	dataPtr = (ResultSetTypeData*) ckalloc(sizeof(ResultSetTypeData));
+	dataPtr->typePtr = typePtr;
+	dataPtr->clientData = clientData;
+    }
+    Tcl_ObjectSetMetadata(object, &resultSetTypeMetadata,
+			  (ClientData) dataPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_GetResultSetType --
+ *
+ *	Retrieves the table of procedures attached to a result set object.
+ *
+ * Parameters:
+ *	object -- Result set object
+ *	clientDataPtr -- Receives the data for the procedures
+ *
+ * Results:
+ *	Returns the table of procedures, or NULL if none is attached.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI const Tdbc_ResultSetType*
+Tdbc_GetResultSetType(
+    Tcl_Object object,		/* Result set object */
+    ClientData* clientDataPtr	/* OUTPUT: Data for the procedures */
+) {
+    ResultSetTypeData* dataPtr = (ResultSetTypeData*)
+	Tcl_ObjectGetMetadata(object, &resultSetTypeMetadata);
+
+    if (dataPtr == NULL) {
+	return NULL;
+    }
+    *clientDataPtr = dataPtr->clientData;
+    return dataPtr->typePtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcGetResultSetTypeFromObj --
+ *
+ *	Retrieves the table of procedures attached to a result set, given
+ *	the name of the result set.
+ *
+ * Results:
+ *	Returns the table of procedures, or NULL if the name does not
+ *	designate an object or the object has no table attached. The
+ *	interpreter result is left unchanged.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE const Tdbc_ResultSetType*
+TdbcGetResultSetTypeFromObj(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    Tcl_Obj* objPtr,		/* Name of the result set */
+    ClientData* clientDataPtr	/* OUTPUT: Data for the procedures */
+) {
+    Tcl_Command cmd = Tcl_GetCommandFromObj(interp, objPtr);
+    Tcl_InterpState state;
+    Tcl_Object object;
+
+    if (cmd == NULL) {
+	return NULL;
+    }
+
+    /*
+     * Tcl_GetObjectFromObj leaves an error message when the command is
+     * not an object; restore the result that the caller had.
+     */
+
+    state = Tcl_SaveInterpState(interp, TCL_OK);
+    object = Tcl_GetObjectFromObj(interp, objPtr);
+    Tcl_RestoreInterpState(interp, state);
+    if (object == NULL) {
+	return NULL;
+    }
+    return Tdbc_GetResultSetType(object, clientDataPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FetchCells --
+ *
+ *	Fetches the cells of one row from a result set through its table of
+ *	procedures.
+ *
+ * Parameters:
+ *	object -- Result set object, whose intern table, if any, supplies
+ *		  shared values for the row
+ *	columnsObj -- List of the names of the columns
+ *	nColumns -- Number of columns
+ *	values -- Array of 'nColumns' elements that receives the cells, NULL
+ *		  for a SQL NULL. The caller must decrement the reference
+ *		  count of each non-NULL cell, even if an error is returned.
+ *	gotRowPtr -- Receives 1 if a row was fetched, 0 if there are no
+ *		     more rows
+ *
+ * Results:
+ *	Returns a standard Tcl result.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+FetchCells(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    Tcl_Object object,		/* Result set object */
+    const Tdbc_ResultSetType* typePtr,
+				/* Driver's table of procedures */
+    ClientData clientData,	/* Driver's data for the result set */
+    Tcl_Obj* columnsObj,	/* Column names */
+    int nColumns,		/* Number of columns */
+    Tcl_Obj** values,		/* OUTPUT: Cells of the row */
+    int* gotRowPtr		/* OUTPUT: Flag == 1 if a row was fetched */
+) {
+    int status;
+    int i;
+
+    *gotRowPtr = 0;
+    memset(values, 0, nColumns * sizeof(Tcl_Obj*));
+    status = typePtr->fetchRowProc(interp, clientData, nColumns, values,
+				   gotRowPtr);
+    for (i = 0; i < nColumns; ++i) {
+	if (values[i] != NULL) {
+	    Tcl_IncrRefCount(values[i]);
+	}
+    }
+    if (status == TCL_OK && *gotRowPtr) {
+	Tdbc_InternRow(object, columnsObj, nColumns, values);
+    }
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FetchRow --
+ *
+ *	Fetches one row from a result set through its table of procedures.
+ *
+ * Parameters:
+ *	object -- Result set object, whose intern table, if any, supplies
+ *		  shared values for the row
+ *	columnsObj -- List of the names of the columns
+ *	asLists -- 1 to make the row a list, 0 to make it a dictionary
+ *	rowPtr -- Receives the row, or NULL if there are no more rows
+ *
+ * Results:
+ *	Returns a standard Tcl result.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+FetchRow(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    Tcl_Object object,		/* Result set object */
+    const Tdbc_ResultSetType* typePtr,
+				/* Driver's table of procedures */
+    ClientData clientData,	/* Driver's data for the result set */
+    Tcl_Obj* columnsObj,	/* Column names */
+    int asLists,		/* Flag == 1 to make a list */
+    Tcl_Obj** rowPtr		/* OUTPUT: Row fetched */
+) {
+    Tcl_Obj* staticValues[16];	/* Cell values for narrow rows */
+    Tcl_Obj** values = staticValues;
+				/* Cell values */
+    Tcl_Obj** columnv;		/* Column names */
+    Tcl_Obj* rowObj;		/* Row being built */
+    int nColumns;		/* Number of columns */
+    int gotRow;			/* Flag == 1 if a row was fetched */
+    int status;			/* Status return */
+    int i;
+
+    *rowPtr = NULL;
+    if (Tcl_ListObjGetElements(interp, columnsObj,
+			       &nColumns, &columnv) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (nColumns > 16) {
+	values = (Tcl_Obj**) ckalloc(nColumns * sizeof(Tcl_Obj*));
+    }
+    status = FetchCells(interp, object, typePtr, clientData, columnsObj,
+			nColumns, values, &gotRow);
+    if (status == TCL_OK && gotRow) {
+	rowObj = Tcl_NewObj();
+	for (i = 0; i < nColumns; ++i) {
+	    if (asLists) {
+		Tcl_ListObjAppendElement(NULL, rowObj,
+					 values[i] ? values[i] : Tcl_NewObj());
+	    } else if (values[i] != NULL) {
+		Tcl_DictObjPut(NULL, rowObj, columnv[i], values[i]);
+	    }
+	}
+	*rowPtr = rowObj;
+    }
+    for (i = 0; i < nColumns; ++i) {
+	if (values[i] != NULL) {
+	    Tcl_DecrRefCount(values[i]);
+	}
+    }
+    if (values != staticValues) {
+	ckfree((char*) values);
+    }
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcFetchAllObjCmd --
+ *
+ *	Fetches all the rows of a result set through its table of
+ *	procedures.
+ *
+ * Usage:
+ *	::tdbc::FetchAll resultSet lists|dicts ?maxBytes?
+ *
+ * Results:
+ *	Returns a two-element list: the names of the columns of the last
+ *	set of results, and the rows of all the sets of results.
+ *
+ * If 'maxBytes' is given and positive, the fetch fails as soon as the
+ * estimated size of the rows exceeds it.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcFetchAllObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures */
+    ClientData rsData;		/* Driver's data for the result set */
+    Tcl_Object object;		/* Result set object */
+    Tcl_Obj* columnsObj = NULL;	/* Column names */
+    Tcl_Obj* rowsObj;		/* Rows fetched */
+    Tcl_Obj* rowObj;		/* One row */
+    Tcl_Obj* resultObj;		/* Result of the command */
+    int asLists;		/* Flag == 1 to make rows lists */
+    int more = 1;		/* Flag == 1 if there are more results */
+    Tcl_WideInt maxBytes = 0;	/* Memory budget for the rows */
+    Tcl_WideInt size = 0;	/* Estimated size of the rows */
+    int status = TCL_OK;
+
+    if (objc != 3 && objc != 4) {
+	Tcl_WrongNumArgs(interp, 1, objv, "resultSet lists|dicts ?maxBytes?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[2], asValues, "variable type",
+			    0, &asLists) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (objc == 4
+	&& Tcl_GetWideIntFromObj(interp, objv[3], &maxBytes) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    typePtr = TdbcGetResultSetTypeFromObj(interp, objv[1], &rsData);
+    if (typePtr == NULL) {
+	Tcl_SetObjResult(interp,
+			 Tcl_ObjPrintf("\"%s\" has no result set type",
+				       Tcl_GetString(objv[1])));
+	Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+			 "noResultSetType", NULL);
+	return TCL_ERROR;
+    }
+    object = Tcl_GetObjectFromObj(interp, objv[1]);
+
+    rowsObj = Tcl_NewObj();
+    Tcl_IncrRefCount(rowsObj);
+    while (more) {
+	if (columnsObj != NULL) {
+	    Tcl_DecrRefCount(columnsObj);
+	    columnsObj = NULL;
+	}
+	if ((status = typePtr->columnsProc(interp, rsData,
+					   &columnsObj)) != TCL_OK) {
+	    columnsObj = NULL;
+	    break;
+	}
+	Tcl_IncrRefCount(columnsObj);
+	for (;;) {
+	    status = FetchRow(interp, object, typePtr, rsData, columnsObj,
+			      asLists, &rowObj);
+	    if (status != TCL_OK || rowObj == NULL) {
+		break;
+	    }
+	    if (maxBytes > 0) {
+		size += (Tcl_WideInt) (TdbcObjSize(rowObj) + sizeof(Tcl_Obj*));
+		if (size > maxBytes) {
+		    Tcl_IncrRefCount(rowObj);
+		    Tcl_DecrRefCount(rowObj);
+		    status = TdbcMemoryLimitError(interp);
+		    break;
+		}
+	    }
+	    Tcl_ListObjAppendElement(NULL, rowsObj, rowObj);
+	}
+	if (status != TCL_OK) {
+	    break;
+	}
+	if (typePtr->nextResultsProc == NULL) {
+	    more = 0;
+	} else if ((status = typePtr->nextResultsProc(interp, rsData,
+						      &more)) != TCL_OK) {
+	    break;
+	}
+    }
+
+    if (status == TCL_OK) {
+	resultObj = Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, resultObj, columnsObj);
+	Tcl_ListObjAppendElement(NULL, resultObj, rowsObj);
+	Tcl_SetObjResult(interp, resultObj);
+    }
+    if (columnsObj != NULL) {
+	Tcl_DecrRefCount(columnsObj);
+    }
+    Tcl_DecrRefCount(rowsObj);
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcFetchRowObjCmd --
+ *
+ *	Fetches one row of a result set through its table of procedures.
+ *
+ * Usage:
+ *	::tdbc::FetchRow resultSet lists|dicts varName
+ *
+ * Results:
+ *	Stores the row in the given variable and returns 1, or returns 0
+ *	if there are no more rows in the current set of results.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcFetchRowObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures */
+    ClientData rsData;		/* Driver's data for the result set */
+    Tcl_Object object;		/* Result set object */
+    Tcl_Obj* columnsObj;	/* Column names */
+    Tcl_Obj* rowObj;		/* Row fetched */
+    int asLists;		/* Flag == 1 to make rows lists */
+    int status;
+
+    if (objc != 4) {
+	Tcl_WrongNumArgs(interp, 1, objv, "resultSet lists|dicts varName");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[2], asValues, "variable type",
+			    0, &asLists) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    typePtr = TdbcGetResultSetTypeFromObj(interp, objv[1], &rsData);
+    if (typePtr == NULL) {
+	Tcl_SetObjResult(interp,
+			 Tcl_ObjPrintf("\"%s\" has no result set type",
+				       Tcl_GetString(objv[1])));
+	Tcl_SetErrorCode(interp, "TDBC", "GENERAL_ERROR", "HY000", "",
+			 "noResultSetType", NULL);
+	return TCL_ERROR;
+    }
+    object = Tcl_GetObjectFromObj(interp, objv[1]);
+
+    if (typePtr->columnsProc(interp, rsData, &columnsObj) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    Tcl_IncrRefCount(columnsObj);
+    status = FetchRow(interp, object, typePtr, rsData, columnsObj,
+		      asLists, &rowObj);
+    Tcl_DecrRefCount(columnsObj);
+    if (status != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (rowObj == NULL) {
+	Tcl_SetObjResult(interp, Tcl_NewBooleanObj(0));
+	return TCL_OK;
+    }
+    if (Tcl_ObjSetVar2(interp, objv[3], NULL, rowObj,
+		       TCL_LEAVE_ERR_MSG) == NULL) {
+	return TCL_ERROR;
+    }
+    Tcl_SetObjResult(interp, Tcl_NewBooleanObj(1));
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcForeachVarsObjCmd --
+ *
+ *	Runs a script on each row of a result set, fetching the rows
+ *	through its table of procedures and storing their cells in
+ *	variables rather than in a list or dictionary.
+ *
+ * Usage:
+ *	::tdbc::ForeachVars resultSet lists|dicts ?-variables varNames?
+ *		columnsVar script
+ *
+ * Parameters:
+ *	varNames -- Variables that receive the cells of the columns in the
+ *		    same positions. Without '-variables', each cell is
+ *		    stored in the variable named after its column.
+ *	columnsVar -- Variable that receives the names of the columns of
+ *		      each set of results, or an empty string.
+ *
+ * Results:
+ *	Returns a standard Tcl result. A variable whose cell is NULL, or
+ *	that has no column, is unset for 'dicts' and set to the empty
+ *	string for 'lists'.
+ *
+ * The command is meant to be evaluated in the scope of the caller of
+ * 'foreach', where it sets the variables and runs the script. The
+ * result set is looked up again for each row, so that the script may
+ * close it; iteration then stops.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcForeachVarsObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    const Tdbc_ResultSetType* typePtr;
+				/* Driver's table of procedures */
+    ClientData rsData;		/* Driver's data for the result set */
+    Tcl_Object object;		/* Result set object */
+    Tcl_Obj* columnsObj = NULL;	/* Column names */
+    Tcl_Obj* staticValues[16];	/* Cell values for narrow rows */
+    Tcl_Obj** values = staticValues;
+				/* Cell values */
+    int valuesSize = 16;	/* Number of elements in 'values' */
+    Tcl_Obj* namesObj;		/* Copy of the variable names, or NULL to
+				 * use the column names */
+    Tcl_Obj** varv;		/* Variable names */
+    int varc;
+    Tcl_Obj* columnsVarObj;	/* Variable that receives the column
+				 * names, or NULL */
+    Tcl_Obj* scriptObj;		/* Script to run on each row */
+    int nColumns = 0;		/* Number of columns */
+    int asLists;		/* Flag == 1 to store NULLs as empty */
+    int gotRow;			/* Flag == 1 if a row was fetched */
+    int more = 1;		/* Flag == 1 if there are more results */
+    int status = TCL_OK;
+    int i;
+
+    if (objc != 5 && !(objc == 7
+		       && !strcmp(Tcl_GetString(objv[3]), "-variables"))) {
+	Tcl_WrongNumArgs(interp, 1, objv,
+			 "resultSet lists|dicts ?-variables varNames?"
+			 " columnsVar script");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[2], asValues, "variable type",
+			    0, &asLists) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    namesObj = NULL;
+    if (objc == 7) {
+	if (Tcl_ListObjLength(interp, objv[4], &varc) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	namesObj = Tcl_DuplicateObj(objv[4]);
+	Tcl_IncrRefCount(namesObj);
+    }
+    columnsVarObj = objv[objc-2];
+    if (Tcl_GetCharLength(columnsVarObj) == 0) {
+	columnsVarObj = NULL;
+    }
+    scriptObj = objv[objc-1];
+    Tcl_IncrRefCount(scriptObj);
+
+    while (more) {
+
+	/* Look up the result set, which the script may have closed */
+
+	typePtr = TdbcGetResultSetTypeFromObj(interp, objv[1], &rsData);
+	if (typePtr == NULL) {
+	    break;
+	}
+	object = Tcl_GetObjectFromObj(interp, objv[1]);
+
+	/* Get the columns of the set of results */
+
+	if (columnsObj != NULL) {
+	    Tcl_DecrRefCount(columnsObj);
+	    columnsObj = NULL;
+	}
+	if ((status = typePtr->columnsProc(interp, rsData,
+					   &columnsObj)) != TCL_OK) {
+	    columnsObj = NULL;
+	    break;
+	}
+	Tcl_IncrRefCount(columnsObj);
+	if ((status = Tcl_ListObjLength(interp, columnsObj,
+					&nColumns)) != TCL_OK) {
+	    break;
+	}
+	if (columnsVarObj != NULL
+	    && Tcl_ObjSetVar2(interp, columnsVarObj, NULL, columnsObj,
+			      TCL_LEAVE_ERR_MSG) == NULL) {
+	    status = TCL_ERROR;
+	    break;
+	}
+	if (nColumns > valuesSize) {
+	    if (values != staticValues) {
+		ckfree((char*) values);
+	    }
+	    values = (Tcl_Obj**) ckalloc(nColumns * sizeof(Tcl_Obj*));
+	    valuesSize = nColumns;
+	}
+
+	/* Run the script on each row */
+
+	for (;;) {
+	    status = FetchCells(interp, object, typePtr, rsData, columnsObj,
+				nColumns, values, &gotRow);
+
+	    /*
+	     * The script may have changed the representation of the list
+	     * of column names, so its elements are retrieved for each row.
+	     * The list of variable names is a private copy.
+	     */
+
+	    if (status == TCL_OK && gotRow) {
+		status = Tcl_ListObjGetElements(interp,
+						namesObj ? namesObj : columnsObj,
+						&varc, &varv);
+	    }
+	    for (i = 0; status == TCL_OK && gotRow && i < varc; ++i) {
+		Tcl_Obj* valueObj = (i < nColumns) ? values[i] : NULL;
+
+		if (valueObj == NULL && !asLists) {
+		    Tcl_UnsetVar2(interp, Tcl_GetString(varv[i]), NULL, 0);
+		} else if (Tcl_ObjSetVar2(interp, varv[i], NULL,
+					  valueObj ? valueObj : Tcl_NewObj(),
+					  TCL_LEAVE_ERR_MSG) == NULL) {
+		    status = TCL_ERROR;
+		}
+	    }
+	    for (i = 0; i < nColumns; ++i) {
+		if (values[i] != NULL) {
+		    Tcl_DecrRefCount(values[i]);
+		}
+	    }
+	    if (status != TCL_OK || !gotRow) {
+		break;
+	    }
+	    status = Tcl_EvalObjEx(interp, scriptObj, 0);
+	    if (status == TCL_CONTINUE) {
+		status = TCL_OK;
+	    }
+	    if (status != TCL_OK) {
+		break;
+	    }
+	    typePtr = TdbcGetResultSetTypeFromObj(interp, objv[1], &rsData);
+	    if (typePtr == NULL) {
+		more = 0;
+		break;
+	    }
+	    object = Tcl_GetObjectFromObj(interp, objv[1]);
+	}
+	if (status != TCL_OK || !more) {
+	    break;
+	}
+
+	/* Advance to the next set of results */
+
+	if (typePtr->nextResultsProc == NULL) {
+	    more = 0;
+	} else if ((status = typePtr->nextResultsProc(interp, rsData,
+						      &more)) != TCL_OK) {
+	    break;
+	}
+    }
+
+    if (columnsObj != NULL) {
+	Tcl_DecrRefCount(columnsObj);
+    }
+    if (namesObj != NULL) {
+	Tcl_DecrRefCount(namesObj);
+    }
+    Tcl_DecrRefCount(scriptObj);
+    if (values != staticValues) {
+	ckfree((char*) values);
+    }
+    if (status == TCL_BREAK) {
+	status = TCL_OK;
+    }
+    if (status == TCL_OK) {
+	Tcl_ResetResult(interp);
+    }
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcResultSetTypeObjCmd --
+ *
+ *	Reports the type of a result set.
+ *
+ * Usage:
+ *	::tdbc::ResultSetType resultSet
+ *
+ * Results:
+ *	Returns the name of the table of procedures attached to the
+ *	result set, or an empty string if there is none.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcResultSetTypeObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    const Tdbc_ResultSetType* typePtr;
+    ClientData rsData;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "resultSet");
+	return TCL_ERROR;
+    }
+    typePtr = TdbcGetResultSetTypeFromObj(interp, objv[1], &rsData);
+    if (typePtr != NULL) {
+	Tcl_SetObjResult(interp, Tcl_NewStringObj(typePtr->name, -1));
+    }
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * CloneResultSetTypeData --
+ *
+ *	Called when a result set object is copied. The copy does not
+ *	share the driver's data, so the table of procedures is not copied.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+CloneResultSetTypeData(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData oldData,		/* Metadata of the original object */
+    ClientData* newDataPtr	/* OUTPUT: Metadata of the copy */
+) {
+    *newDataPtr = NULL;
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeleteResultSetTypeData --
+ *
+ *	Frees the metadata when a result set object is destroyed or its
+ *	table of procedures is replaced.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeleteResultSetTypeData(
+    ClientData clientData	/* Metadata to free */
+) {
+    ckfree((char*) clientData);
+}
@@ -0,0 +1,908 @@
+/*
+ * tdbcStats.c --
+ *
+ *	Statistics of the statements that TDBC executes. Each statement is
+ *	reduced to a fingerprint, in which literals are replaced by '?'
+ *	and whitespace and comments are collapsed, and the executions of
+ *	all the statements with the same fingerprint are counted together,
+ *	with a histogram of their latencies.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Latencies are counted in a histogram with four buckets for each power
+ * of two microseconds, so that a bucket spans at most a quarter of its
+ * lower bound. Values below four microseconds have a bucket each, and
+ * values of 2**MAX_LATENCY_BITS microseconds (about twelve days) or more
+ * fall in the last bucket.
+ */
+
+#define MAX_LATENCY_BITS 40
+#define BUCKET_COUNT (4 * (MAX_LATENCY_BITS - 1))
+
+/*
+ * Maximum number of fingerprints that are kept. Once the table is full,
+ * statements with new fingerprints are counted under OTHER_FINGERPRINT.
+ */
+
+#define MAX_FINGERPRINTS 5000
+#define OTHER_FINGERPRINT "(other)"
+
+/*
+ * Statistics of one fingerprint
+ */
+
+typedef struct QueryStats {
+    Tcl_WideInt calls;		/* Number of executions */
+    Tcl_WideInt rows;		/* Number of rows returned or affected */
+    Tcl_WideInt errors;		/* Number of executions that failed */
+    Tcl_WideInt totalTime;	/* Sum of the latencies, in microseconds */
+    Tcl_WideInt minTime;	/* Least latency */
+    Tcl_WideInt maxTime;	/* Greatest latency */
+    Tcl_WideInt buckets[BUCKET_COUNT];
+				/* Histogram of the latencies */
+} QueryStats;
+
+/*
+ * A copy of the statistics of one fingerprint, taken to report them
+ */
+
+typedef struct StatsSnapshot {
+    const char* fingerprint;	/* Fingerprint */
+    QueryStats stats;		/* Its statistics */
+} StatsSnapshot;
+
+/*
+ * The statistics are shared by all interpreters in the process, so that
+ * they describe everything that the process does with its databases. The
+ * mutex protects the table of fingerprints.
+ */
+
+TCL_DECLARE_MUTEX(statsMutex)
+static Tcl_HashTable statsTable;
+static int statsInitialized = 0;
+
+/* Quantiles that are reported */
+
+static const struct {
+    const char* name;		/* Key in the dictionary */
+    const char* label;		/* Prometheus label */
+    double fraction;		/* Fraction of the executions */
+} quantiles[] = {
+    { "p50", "0.5", 0.50 },
+    { "p95", "0.95", 0.95 },
+    { "p99", "0.99", 0.99 },
+    { NULL, NULL, 0.0 }
+};
+
+/* Static procedures declared in this file */
+
+static void AppendLabelValue(Tcl_Obj* outPtr, const char* value);
+static void AppendPrometheus(Tcl_Obj* outPtr, StatsSnapshot* snapshots,
+			     int count);
+static int BucketIndex(Tcl_WideInt latency);
+static Tcl_WideInt BucketUpperBound(int index);
+static int CompareSnapshots(const void* a, const void* b);
+static void FinalizeStats(ClientData dummy);
+static QueryStats* FindStats(const char* fingerprint);
+static Tcl_Obj* FingerprintSql(const char* p, const char* end);
+static void FreeSnapshots(StatsSnapshot* snapshots, int count);
+static Tcl_WideInt Quantile(const QueryStats* statsPtr, double fraction);
+static StatsSnapshot* TakeSnapshots(int reset, int* countPtr);
+
+/* Subcommands of ::tdbc::RecordQueryStats */
+
+static const char *const recordSubcommands[] = {
+    "record", "rows", NULL
+};
+enum RecordSubcommand {
+    QS_RECORD, QS_ROWS
+};
+
+/* Options of ::tdbc::querystats */
+
+static const char *const querystatsOptions[] = {
+    "-prometheus", "-reset", NULL
+};
+enum QuerystatsOption {
+    OPT_PROMETHEUS, OPT_RESET
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FingerprintSql --
+ *
+ *	Reduces SQL code to its fingerprint.
+ *
+ * Results:
+ *	Returns the fingerprint, with a reference count of zero.
+ *
+ * String and numeric literals are replaced by '?', and a list of
+ * consecutive literals, such as the values of an IN list or the rows of
+ * a multiple-row INSERT, is reduced to a single one. Comments are
+ * removed, and every run of whitespace becomes a single space, except
+ * after an opening parenthesis or before a closing parenthesis or a
+ * comma, where it is removed; a comma is always followed by a space.
+ * Bound variables, identifiers and keywords are kept as they are, and
+ * trailing semicolons are removed.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+FingerprintSql(
+    const char* p,		/* Start of the SQL code */
+    const char* end		/* End of the SQL code */
+) {
+    Tcl_Obj* resultPtr = Tcl_NewObj();
+    const char* start;
+    const char* q;
+    const char* out;
+    unsigned char c;
+    int length;
+    int space = 0;		/* 1 if whitespace precedes the token */
+    int literal;		/* 1 if the token is a literal */
+
+    while (p < end) {
+	c = (unsigned char) *p;
+	start = p;
+	literal = 0;
+
+	/* Whitespace and comments */
+
+	if (isspace(c)) {
+	    ++p;
+	    space = 1;
+	    continue;
+	} else if (c == '-' && p + 1 < end && p[1] == '-') {
+	    while (p < end && *p != '\n') {
+		++p;
+	    }
+	    space = 1;
+	    continue;
+	} else if (c == '/' && p + 1 < end && p[1] == '*') {
+	    for (q = p + 2; q + 1 < end && (q[0] != '*' || q[1] != '/'); ++q) {
+		/* do nothing */
+	    }
+	    p = (q + 1 < end) ? q + 2 : end;
+	    space = 1;
+	    continue;
+	}
+
+	/* String literals, including E'...', N'...', X'...' and B'...' */
+
+	if (c == '\''
+	    || (strchr("EeNnXxBb", c) != NULL && c != '\0'
+		&& p + 1 < end && p[1] == '\'')) {
+	    for (q = (c == '\'') ? p + 1 : p + 2; q < end; ++q) {
+		if (*q == '\\' && c != '\'' && q + 1 < end) {
+		    ++q;
+		} else if (*q == '\'') {
+		    if (q + 1 < end && q[1] == '\'') {
+			++q;
+		    } else {
+			break;
+		    }
+		}
+	    }
+	    p = (q < end) ? q + 1 : end;
+	    literal = 1;
+	}
+
+	/* Numeric literals */
+
+	else if (isdigit(c)
+		 || (c == '.' && p + 1 < end && isdigit((unsigned char) p[1]))) {
+	    while (p < end && (isalnum((unsigned char) *p) || *p == '.'
+			       || ((*p == '+' || *p == '-')
+				   && (p[-1] == 'e' || p[-1] == 'E')))) {
+		++p;
+	    }
+	    literal = 1;
+	}
+
+	/* Quoted identifiers */
+
+	else if (c == '"' || c == '[' || c == '`') {
+	    q = memchr(p + 1, (c == '[') ? ']' : c, end - p - 1);
+	    p = (q != NULL) ? q + 1 : end;
+	}
+
+	/* Words and bound variables */
+
+	else if (isalpha(c) || c == '_' || c >= 0x80
+		 || ((c == ':' || c == '$' || c == '@') && p + 1 < end
+		     && (isalnum((unsigned char) p[1]) || p[1] == '_'))) {
+	    ++p;
+	    while (p < end && (isalnum((unsigned char) *p) || *p == '_'
+			       || *p == '$' || (unsigned char) *p >= 0x80)) {
+		++p;
+	    }
+	}
+
+	/* Anything else is a character by itself */
+
+	else {
+	    ++p;
+	}
+
+	/* Append the token, with a space before it if needed */
+
+	out = Tcl_GetStringFromObj(resultPtr, &length);
+	if (space && length > 0 && out[length-1] != '('
+	    && *start != ')' && *start != ',') {
+	    Tcl_AppendToObj(resultPtr, " ", 1);
+	}
+	if (literal) {
+	    Tcl_AppendToObj(resultPtr, "?", 1);
+	} else {
+	    Tcl_AppendToObj(resultPtr, start, p - start);
+	}
+	space = (*start == ',');
+
+	/* Reduce '?, ?' to '?' and '(?), (?)' to '(?)' */
+
+	out = Tcl_GetStringFromObj(resultPtr, &length);
+	if (literal && length >= 4 && !strcmp(out + length - 4, "?, ?")) {
+	    Tcl_SetObjLength(resultPtr, length - 3);
+	} else if (*start == ')' && length >= 8
+		   && !strcmp(out + length - 8, "(?), (?)")) {
+	    Tcl_SetObjLength(resultPtr, length - 5);
+	}
+    }
+
+    /* Remove trailing semicolons */
+
+    out = Tcl_GetStringFromObj(resultPtr, &length);
+    while (length > 0 && (out[length-1] == ';' || out[length-1] == ' ')) {
+	--length;
+    }
+    Tcl_SetObjLength(resultPtr, length);
+    return resultPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * BucketIndex --
+ *
+ *	Finds the bucket of the latency histogram that counts a latency.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+BucketIndex(
+    Tcl_WideInt latency		/* Latency in microseconds */
+) {
+    int bits = 0;
+
+    if (latency < 4) {
+	return (latency < 0) ? 0 : (int) latency;
+    }
+    while (bits < MAX_LATENCY_BITS - 1 && (latency >> (bits + 1)) != 0) {
+	++bits;
+    }
+    if ((latency >> (bits + 1)) != 0) {
+	return BUCKET_COUNT - 1;
+    }
+    return 4 * (bits - 1) + (int) ((latency >> (bits - 2)) & 3);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * BucketUpperBound --
+ *
+ *	Returns the greatest latency that a bucket of the histogram counts.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_WideInt
+BucketUpperBound(
+    int index			/* Index of the bucket */
+) {
+    int bits;
+
+    ++index;
+    if (index < 4) {
+	return index - 1;
+    }
+    bits = index / 4 + 1;
+    return ((Tcl_WideInt) (4 + index % 4) << (bits - 2)) - 1;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Quantile --
+ *
+ *	Estimates a quantile of the latencies of a fingerprint.
+ *
+ * Results:
+ *	Returns the upper bound of the bucket that holds the quantile,
+ *	limited to the range of the latencies that were seen, or 0 if
+ *	there were no executions.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_WideInt
+Quantile(
+    const QueryStats* statsPtr,	/* Statistics of the fingerprint */
+    double fraction		/* Fraction of executions, 0 to 1 */
+) {
+    Tcl_WideInt rank;
+    Tcl_WideInt seen = 0;
+    Tcl_WideInt bound;
+    int i;
+
+    if (statsPtr->calls == 0) {
+	return 0;
+    }
+    rank = (Tcl_WideInt) (fraction * statsPtr->calls);
+    if (rank < fraction * statsPtr->calls) {
+	++rank;
+    }
+    if (rank < 1) {
+	rank = 1;
+    }
+    for (i = 0; i < BUCKET_COUNT - 1; ++i) {
+	seen += statsPtr->buckets[i];
+	if (seen >= rank) {
+	    break;
+	}
+    }
+    bound = BucketUpperBound(i);
+    if (i == BUCKET_COUNT - 1 || bound > statsPtr->maxTime) {
+	bound = statsPtr->maxTime;
+    }
+    if (bound < statsPtr->minTime) {
+	bound = statsPtr->minTime;
+    }
+    return bound;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FindStats --
+ *
+ *	Finds the statistics of a fingerprint, creating them if needed.
+ *	The caller must hold statsMutex.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static QueryStats*
+FindStats(
+    const char* fingerprint	/* Fingerprint */
+) {
+    Tcl_HashEntry* entryPtr;
+    QueryStats* statsPtr;
+    int isNew;
+
+    if (!statsInitialized) {
+	Tcl_InitHashTable(&statsTable, TCL_STRING_KEYS);
+	Tcl_CreateExitHandler(FinalizeStats, NULL);
+	statsInitialized = 1;
+    }
+    entryPtr = Tcl_FindHashEntry(&statsTable, fingerprint);
+    if (entryPtr != NULL) {
+	return (QueryStats*) Tcl_GetHashValue(entryPtr);
+    }
+    if (statsTable.numEntries >= MAX_FINGERPRINTS) {
+	fingerprint = OTHER_FINGERPRINT;
+    }
+    entryPtr = Tcl_CreateHashEntry(&statsTable, fingerprint, &isNew);
+    if (!isNew) {
+	return (QueryStats*) Tcl_GetHashValue(entryPtr);
+    }
+    statsPtr = (QueryStats*) ckalloc(sizeof(QueryStats));
+    memset(statsPtr, 0, sizeof(QueryStats));
+    Tcl_SetHashValue(entryPtr, (ClientData) statsPtr);
+    return statsPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TakeSnapshots --
+ *
+ *	Copies the statistics of every fingerprint, optionally clearing
+ *	them.
+ *
+ * Results:
+ *	Returns an array of snapshots in decreasing order of total time,
+ *	and stores their number in '*countPtr'. The caller must free the
+ *	array with FreeSnapshots.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static StatsSnapshot*
+TakeSnapshots(
+    int reset,			/* 1 to clear the statistics */
+    int* countPtr		/* Number of snapshots */
+) {
+    StatsSnapshot* snapshots = NULL;
+    Tcl_HashEntry* entryPtr;
+    Tcl_HashSearch search;
+    const char* fingerprint;
+    int count = 0;
+
+    Tcl_MutexLock(&statsMutex);
+    if (statsInitialized && statsTable.numEntries > 0) {
+	snapshots = (StatsSnapshot*)
+	    ckalloc(statsTable.numEntries * sizeof(StatsSnapshot));
+	for (entryPtr = Tcl_FirstHashEntry(&statsTable, &search);
+	     entryPtr != NULL;
+	     entryPtr = Tcl_NextHashEntry(&search)) {
+	    fingerprint = (const char*) Tcl_GetHashKey(&statsTable, entryPtr);
+	    snapshots[count].fingerprint =
+		strcpy(ckalloc(strlen(fingerprint) + 1), fingerprint);
+	    memcpy(&snapshots[count].stats, Tcl_GetHashValue(entryPtr),
+		   sizeof(QueryStats));
+	    ++count;
+	    if (reset) {
+		ckfree((char*) Tcl_GetHashValue(entryPtr));
+		Tcl_DeleteHashEntry(entryPtr);
+	    }
+	}
+    }
+    Tcl_MutexUnlock(&statsMutex);
+    if (count > 1) {
+	qsort(snapshots, count, sizeof(StatsSnapshot), CompareSnapshots);
+    }
+    *countPtr = count;
+    return snapshots;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * CompareSnapshots --
+ *
+ *	Orders snapshots by decreasing total time, and then by fingerprint.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+CompareSnapshots(
+    const void* a,		/* First snapshot */
+    const void* b		/* Second snapshot */
+) {
+    const StatsSnapshot* aPtr = (const StatsSnapshot*) a;
+    const StatsSnapshot* bPtr = (const StatsSnapshot*) b;
+
+    if (aPtr->stats.totalTime != bPtr->stats.totalTime) {
+	return (aPtr->stats.totalTime > bPtr->stats.totalTime) ? -1 : 1;
+    }
+    return strcmp(aPtr->fingerprint, bPtr->fingerprint);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FreeSnapshots --
+ *
+ *	Frees an array of snapshots made by TakeSnapshots.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+FreeSnapshots(
+    StatsSnapshot* snapshots,	/* Array of snapshots, or NULL */
+    int count			/* Number of snapshots */
+) {
+    int i;
+
+    for (i = 0; i < count; ++i) {
+	ckfree((char*) snapshots[i].fingerprint);
+    }
+    if (snapshots != NULL) {
+	ckfree((char*) snapshots);
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * AppendPrometheus --
+ *
+ *	Formats snapshots of the statistics in the Prometheus text
+ *	exposition format.
+ *
+ * The calls, rows and errors are counters, and the latencies are a
+ * summary with the 0.5, 0.95 and 0.99 quantiles, in seconds. Each
+ * fingerprint is identified by the label 'query'.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+AppendPrometheus(
+    Tcl_Obj* outPtr,		/* Value to append to */
+    StatsSnapshot* snapshots,	/* Snapshots of the statistics */
+    int count			/* Number of snapshots */
+) {
+    static const struct {
+	const char* name;	/* Name of the metric */
+	const char* help;	/* Description */
+	size_t offset;		/* Offset of the counter in QueryStats */
+    } counters[] = {
+	{ "tdbc_query_calls_total", "Number of executions of the query.",
+	  offsetof(QueryStats, calls) },
+	{ "tdbc_query_rows_total",
+	  "Number of rows that the query returned or affected.",
+	  offsetof(QueryStats, rows) },
+	{ "tdbc_query_errors_total",
+	  "Number of executions of the query that failed.",
+	  offsetof(QueryStats, errors) },
+	{ NULL, NULL, 0 }
+    };
+    char buffer[TCL_DOUBLE_SPACE];
+    Tcl_WideInt value;
+    int i, j;
+
+    for (j = 0; counters[j].name != NULL; ++j) {
+	Tcl_AppendStringsToObj(outPtr, "# HELP ", counters[j].name, " ",
+			       counters[j].help, "\n# TYPE ",
+			       counters[j].name, " counter\n", NULL);
+	for (i = 0; i < count; ++i) {
+	    value = *(Tcl_WideInt*) ((char*) &snapshots[i].stats
+				     + counters[j].offset);
+	    Tcl_AppendToObj(outPtr, counters[j].name, -1);
+	    AppendLabelValue(outPtr, snapshots[i].fingerprint);
+	    Tcl_AppendPrintfToObj(outPtr, "} %" TCL_LL_MODIFIER "d\n", value);
+	}
+    }
+    Tcl_AppendToObj(outPtr,
+		    "# HELP tdbc_query_duration_seconds"
+		    " Latency of the executions of the query.\n"
+		    "# TYPE tdbc_query_duration_seconds summary\n", -1);
+    for (i = 0; i < count; ++i) {
+	for (j = 0; quantiles[j].name != NULL; ++j) {
+	    Tcl_AppendToObj(outPtr, "tdbc_query_duration_seconds", -1);
+	    AppendLabelValue(outPtr, snapshots[i].fingerprint);
+	    Tcl_PrintDouble(NULL, Quantile(&snapshots[i].stats,
+					   quantiles[j].fraction) * 1.0e-6,
+			    buffer);
+	    Tcl_AppendStringsToObj(outPtr, ",quantile=\"", quantiles[j].label,
+				   "\"} ", buffer, "\n", NULL);
+	}
+	Tcl_AppendToObj(outPtr, "tdbc_query_duration_seconds_sum", -1);
+	AppendLabelValue(outPtr, snapshots[i].fingerprint);
+	Tcl_PrintDouble(NULL, snapshots[i].stats.totalTime * 1.0e-6, buffer);
+	Tcl_AppendStringsToObj(outPtr, "} ", buffer, "\n", NULL);
+	Tcl_AppendToObj(outPtr, "tdbc_query_duration_seconds_count", -1);
+	AppendLabelValue(outPtr, snapshots[i].fingerprint);
+	Tcl_AppendPrintfToObj(outPtr, "} %" TCL_LL_MODIFIER "d\n",
+			      snapshots[i].stats.calls);
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * AppendLabelValue --
+ *
+ *	Appends the opening of a Prometheus label set with the 'query'
+ *	label, escaping its value. The caller appends the closing brace.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+AppendLabelValue(
+    Tcl_Obj* outPtr,		/* Value to append to */
+    const char* value		/* Value of the label */
+) {
+    const char* p;
+
+    Tcl_AppendToObj(outPtr, "{query=\"", -1);
+    for (p = value; *p != '\0'; ++p) {
+	switch (*p) {
+	case '\\':
+	    Tcl_AppendToObj(outPtr, "\\\\", 2);
+	    break;
+	case '"':
+	    Tcl_AppendToObj(outPtr, "\\\"", 2);
+	    break;
+	case '\n':
+	    Tcl_AppendToObj(outPtr, "\\n", 2);
+	    break;
+	default:
+	    Tcl_AppendToObj(outPtr, p, 1);
+	    break;
+	}
+    }
+    Tcl_AppendToObj(outPtr, "\"", 1);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FinalizeStats --
+ *
+ *	Frees the statistics when the process exits.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+FinalizeStats(
+    ClientData dummy		/* Not used */
+) {
+    Tcl_HashEntry* entryPtr;
+    Tcl_HashSearch search;
+
+    Tcl_MutexLock(&statsMutex);
+    if (statsInitialized) {
+	for (entryPtr = Tcl_FirstHashEntry(&statsTable, &search);
+	     entryPtr != NULL;
+	     entryPtr = Tcl_NextHashEntry(&search)) {
+	    ckfree((char*) Tcl_GetHashValue(entryPtr));
+	}
+	Tcl_DeleteHashTable(&statsTable);
+	statsInitialized = 0;
+    }
+    Tcl_MutexUnlock(&statsMutex);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcFingerprintObjCmd --
+ *
+ *	Tcl command to reduce SQL code to its fingerprint.
+ *
+ * Usage:
+ *	::tdbc::fingerprint sqlcode
+ *
+ * Results:
+ *	Returns the fingerprint described for FingerprintSql.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcFingerprintObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    const char* sql;
+    int length;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "sqlcode");
+	return TCL_ERROR;
+    }
+    sql = Tcl_GetStringFromObj(objv[1], &length);
+    Tcl_SetObjResult(interp, FingerprintSql(sql, sql + length));
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcRecordQueryStatsObjCmd --
+ *
+ *	Records the executions of statements.
+ *
+ * Usage:
+ *	::tdbc::RecordQueryStats record fingerprint microseconds failed ?rows?
+ *		Counts an execution of a statement with the given
+ *		fingerprint that took the given time, failed if 'failed'
+ *		is true, and returned or affected 'rows' rows.
+ *	::tdbc::RecordQueryStats rows fingerprint rows ?failed?
+ *		Adds to the rows of the fingerprint, and to its errors if
+ *		'failed' is true, without counting an execution, for
+ *		results that are read after the execution was counted.
+ *
+ * A row count that is not an integer, such as an unknown count from a
+ * driver, is taken as zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcRecordQueryStatsObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    QueryStats* statsPtr;
+    Tcl_Obj* rowsPtr;
+    Tcl_WideInt latency = 0;
+    Tcl_WideInt rows = 0;
+    int failed = 0;
+    int index;
+
+    if (objc < 4) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand fingerprint ?arg...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], recordSubcommands,
+			    "subcommand", 0, &index) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (index == QS_RECORD) {
+	if (objc != 5 && objc != 6) {
+	    Tcl_WrongNumArgs(interp, 2, objv,
+			     "fingerprint microseconds failed ?rows?");
+	    return TCL_ERROR;
+	}
+	if (Tcl_GetWideIntFromObj(interp, objv[3], &latency) != TCL_OK
+	    || Tcl_GetBooleanFromObj(interp, objv[4], &failed) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	rowsPtr = (objc == 6) ? objv[5] : NULL;
+    } else {
+	if (objc != 4 && objc != 5) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "fingerprint rows ?failed?");
+	    return TCL_ERROR;
+	}
+	if (objc == 5
+	    && Tcl_GetBooleanFromObj(interp, objv[4], &failed) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	rowsPtr = objv[3];
+    }
+    if (rowsPtr != NULL
+	&& (Tcl_GetWideIntFromObj(NULL, rowsPtr, &rows) != TCL_OK
+	    || rows < 0)) {
+	rows = 0;
+    }
+    if (latency < 0) {
+	latency = 0;
+    }
+
+    Tcl_MutexLock(&statsMutex);
+    statsPtr = FindStats(Tcl_GetString(objv[2]));
+    statsPtr->rows += rows;
+    statsPtr->errors += (failed != 0);
+    if (index == QS_RECORD) {
+	if (statsPtr->calls == 0 || latency < statsPtr->minTime) {
+	    statsPtr->minTime = latency;
+	}
+	if (latency > statsPtr->maxTime) {
+	    statsPtr->maxTime = latency;
+	}
+	++statsPtr->calls;
+	statsPtr->totalTime += latency;
+	++statsPtr->buckets[BucketIndex(latency)];
+    }
+    Tcl_MutexUnlock(&statsMutex);
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcQuerystatsObjCmd --
+ *
+ *	Tcl command to report the statistics of the statements executed
+ *	in the process.
+ *
+ * Usage:
+ *	::tdbc::querystats ?-reset? ?-prometheus channel?
+ *
+ * Results:
+ *	Without '-prometheus', returns a dictionary whose keys are the
+ *	fingerprints, in decreasing order of total time, and whose values
+ *	are dictionaries with the keys 'calls', 'rows', 'errors',
+ *	'totaltime', 'mintime', 'maxtime', 'p50', 'p95' and 'p99', giving
+ *	times in microseconds. With '-prometheus', writes the statistics
+ *	to the channel in the Prometheus text exposition format and
+ *	returns an empty result. With '-reset', the statistics are
+ *	cleared once they have been reported.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcQuerystatsObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    StatsSnapshot* snapshots;
+    QueryStats* statsPtr;
+    Tcl_Channel chan = NULL;
+    Tcl_Obj* resultPtr;
+    Tcl_Obj* entryPtr;
+    int reset = 0;
+    int mode;
+    int count;
+    int index;
+    int status = TCL_OK;
+    int i, j;
+
+    for (i = 1; i < objc; ++i) {
+	if (Tcl_GetIndexFromObj(interp, objv[i], querystatsOptions,
+				"option", 0, &index) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (index == OPT_RESET) {
+	    reset = 1;
+	} else if (++i >= objc) {
+	    Tcl_WrongNumArgs(interp, 1, objv, "?-reset? ?-prometheus channel?");
+	    return TCL_ERROR;
+	} else {
+	    chan = Tcl_GetChannel(interp, Tcl_GetString(objv[i]), &mode);
+	    if (chan == NULL) {
+		return TCL_ERROR;
+	    }
+	    if (!(mode & TCL_WRITABLE)) {
+		Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+			"channel \"%s\" wasn't opened for writing",
+			Tcl_GetString(objv[i])));
+		return TCL_ERROR;
+	    }
+	}
+    }
+
+    snapshots = TakeSnapshots(reset, &count);
+    resultPtr = Tcl_NewObj();
+    Tcl_IncrRefCount(resultPtr);
+    if (chan != NULL) {
+	AppendPrometheus(resultPtr, snapshots, count);
+	if (Tcl_WriteObj(chan, resultPtr) < 0) {
+	    Tcl_SetObjResult(interp, Tcl_ObjPrintf(
+		    "error writing \"%s\": %s",
+		    Tcl_GetChannelName(chan), Tcl_PosixError(interp)));
+	    status = TCL_ERROR;
+	}
+    } else {
+	for (i = 0; i < count; ++i) {
+	    statsPtr = &snapshots[i].stats;
+	    entryPtr = Tcl_NewObj();
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("calls", -1),
+			   Tcl_NewWideIntObj(statsPtr->calls));
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("rows", -1),
+			   Tcl_NewWideIntObj(statsPtr->rows));
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("errors", -1),
+			   Tcl_NewWideIntObj(statsPtr->errors));
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("totaltime", -1),
+			   Tcl_NewWideIntObj(statsPtr->totalTime));
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("mintime", -1),
+			   Tcl_NewWideIntObj(statsPtr->minTime));
+	    Tcl_DictObjPut(NULL, entryPtr, Tcl_NewStringObj("maxtime", -1),
+			   Tcl_NewWideIntObj(statsPtr->maxTime));
+	    for (j = 0; quantiles[j].name != NULL; ++j) {
+		Tcl_DictObjPut(NULL, entryPtr,
+			       Tcl_NewStringObj(quantiles[j].name, -1),
+			       Tcl_NewWideIntObj(
+				   Quantile(statsPtr, quantiles[j].fraction)));
+	    }
+	    Tcl_DictObjPut(NULL, resultPtr,
+			   Tcl_NewStringObj(snapshots[i].fingerprint, -1),
+			   entryPtr);
+	}
+	Tcl_SetObjResult(interp, resultPtr);
+    }
+    Tcl_DecrRefCount(resultPtr);
+    FreeSnapshots(snapshots, count);
+    return status;
+}
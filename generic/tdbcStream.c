@@ -0,0 +1,458 @@
+/*
+ * tdbcStream.c --
+ *
+ *	Tokens that stand for the contents of a channel in the bound values
+ *	of a statement, so that drivers can send large parameters to the
+ *	database a chunk at a time rather than as one string.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Structure that describes a stream parameter. It is shared among the
+ * duplicates of the token that made it.
+ */
+
+typedef struct StreamParam {
+    size_t refCount;		/* Number of tokens that refer to this
+				 * structure */
+    Tcl_Obj* channelName;	/* Name of the channel to read */
+    Tcl_WideInt length;		/* Number of bytes to read, or -1 to read
+				 * to end of file */
+} StreamParam;
+
+/*
+ * Number of bytes that 'tdbc::ExpandStreamParams' reads at a time
+ */
+
+#define STREAM_CHUNK 65536
+
+/*
+ * Count of the stream parameters that exist in the process, so that the
+ * base classes can skip looking for tokens when there are none.
+ */
+
+TCL_DECLARE_MUTEX(streamMutex);
+static size_t streamParamCount = 0;
+
+/* Static functions defined in this file */
+
+static void DupStreamParamInternalRep(Tcl_Obj* srcPtr, Tcl_Obj* dupPtr);
+static void FreeStreamParamInternalRep(Tcl_Obj* objPtr);
+static void UpdateStreamParamString(Tcl_Obj* objPtr);
+static int SetStreamParamFromAny(Tcl_Interp* interp, Tcl_Obj* objPtr);
+
+/*
+ * Type of a stream parameter token. A token cannot be made from a string,
+ * so that a value that merely looks like one never reads a channel.
+ */
+
+static const Tcl_ObjType streamParamType = {
+    "tdbc::streamparam",	/* name */
+    FreeStreamParamInternalRep,	/* freeIntRepProc */
+    DupStreamParamInternalRep,	/* dupIntRepProc */
+    UpdateStreamParamString,	/* updateStringProc */
+    SetStreamParamFromAny	/* setFromAnyProc */
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcStreamParamObjCmd --
+ *
+ *	Makes a token that binds the contents of a channel to a parameter.
+ *
+ * Usage:
+ *	tdbc::streamparam channel ?length?
+ *
+ * Results:
+ *	Returns the token.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcStreamParamObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    int mode;
+    Tcl_WideInt length = -1;
+    StreamParam* paramPtr;
+    Tcl_Obj* tokenPtr;
+
+    if (objc != 2 && objc != 3) {
+	Tcl_WrongNumArgs(interp, 1, objv, "channel ?length?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetChannel(interp, Tcl_GetString(objv[1]), &mode) == NULL) {
+	return TCL_ERROR;
+    }
+    if (!(mode & TCL_READABLE)) {
+	Tcl_AppendResult(interp, "channel \"", Tcl_GetString(objv[1]),
+			 "\" wasn't opened for reading", NULL);
+	return TCL_ERROR;
+    }
+    if (objc == 3) {
+	if (Tcl_GetWideIntFromObj(interp, objv[2], &length) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+	if (length < 0) {
+	    Tcl_SetObjResult(interp,
+			     Tcl_ObjPrintf("bad length \"%s\": must be a "
+					   "non-negative integer",
+					   Tcl_GetString(objv[2])));
+	    return TCL_ERROR;
+	}
+    }
+
+    paramPtr = (StreamParam*) ckalloc(sizeof(StreamParam));
+    paramPtr->refCount = 1;
+    paramPtr->channelName = objv[1];
+    Tcl_IncrRefCount(paramPtr->channelName);
+    paramPtr->length = length;
+    Tcl_MutexLock(&streamMutex);
+    ++streamParamCount;
+    Tcl_MutexUnlock(&streamMutex);
+
+    tokenPtr = Tcl_NewObj();
+    Tcl_InvalidateStringRep(tokenPtr);
+    tokenPtr->internalRep.otherValuePtr = paramPtr;
+    tokenPtr->typePtr = &streamParamType;
+    Tcl_SetObjResult(interp, tokenPtr);
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcStreamParamCountObjCmd --
+ *
+ *	Reports whether any stream parameters exist.
+ *
+ * Usage:
+ *	tdbc::StreamParamCount
+ *
+ * Results:
+ *	Returns the number of stream parameters in the process.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcStreamParamCountObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    size_t count;
+
+    if (objc != 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, "");
+	return TCL_ERROR;
+    }
+    Tcl_MutexLock(&streamMutex);
+    count = streamParamCount;
+    Tcl_MutexUnlock(&streamMutex);
+    Tcl_SetObjResult(interp, Tcl_NewWideIntObj((Tcl_WideInt) count));
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcExpandStreamParamsObjCmd --
+ *
+ *	Replaces the stream parameter tokens in a dictionary of bound values
+ *	with the contents of their channels, for drivers that cannot read
+ *	the channels themselves.
+ *
+ * Usage:
+ *	tdbc::ExpandStreamParams dictionary
+ *
+ * Results:
+ *	Returns the dictionary with each token replaced by a byte array.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcExpandStreamParamsObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Obj* dictPtr;
+    Tcl_Obj* keyPtr;
+    Tcl_Obj* valuePtr;
+    Tcl_Obj* bytesPtr;
+    Tcl_DictSearch search;
+    Tcl_Channel chan;
+    Tcl_WideInt remaining;
+    unsigned char* buffer = NULL;
+    int allocated;
+    int done;
+    int got;
+    int used;
+    int status = TCL_OK;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "dictionary");
+	return TCL_ERROR;
+    }
+    dictPtr = objv[1];
+    Tcl_IncrRefCount(dictPtr);
+    if (Tcl_DictObjFirst(interp, objv[1], &search,
+			 &keyPtr, &valuePtr, &done) != TCL_OK) {
+	Tcl_DecrRefCount(dictPtr);
+	return TCL_ERROR;
+    }
+    for (; !done; Tcl_DictObjNext(&search, &keyPtr, &valuePtr, &done)) {
+	if (valuePtr->typePtr != &streamParamType) {
+	    continue;
+	}
+	if (Tdbc_GetStreamParam(interp, valuePtr, &chan,
+				&remaining) != TCL_OK) {
+	    status = TCL_ERROR;
+	    break;
+	}
+
+	/* Read the channel into a byte array */
+
+	bytesPtr = Tcl_NewByteArrayObj(NULL, 0);
+	used = 0;
+	allocated = 0;
+	do {
+	    if (used + STREAM_CHUNK > allocated) {
+		allocated = 2 * (used + STREAM_CHUNK);
+		buffer = Tcl_SetByteArrayLength(bytesPtr, allocated);
+	    }
+	    got = Tdbc_ReadStreamParam(chan, &remaining,
+				       (char*) buffer + used, STREAM_CHUNK);
+	    if (got > 0) {
+		used += got;
+	    }
+	} while (got > 0);
+	Tcl_SetByteArrayLength(bytesPtr, used);
+	if (got < 0) {
+	    Tcl_SetObjResult(interp,
+			     Tcl_ObjPrintf("error reading \"%s\": %s",
+					   Tcl_GetChannelName(chan),
+					   Tcl_PosixError(interp)));
+	    Tcl_DecrRefCount(bytesPtr);
+	    status = TCL_ERROR;
+	    break;
+	}
+	if (Tcl_IsShared(dictPtr)) {
+	    Tcl_Obj* copyPtr = Tcl_DuplicateObj(dictPtr);
+	    Tcl_DecrRefCount(dictPtr);
+	    dictPtr = copyPtr;
+	    Tcl_IncrRefCount(dictPtr);
+	}
+	Tcl_DictObjPut(NULL, dictPtr, keyPtr, bytesPtr);
+    }
+    Tcl_DictObjDone(&search);
+    if (status == TCL_OK) {
+	Tcl_SetObjResult(interp, dictPtr);
+    }
+    Tcl_DecrRefCount(dictPtr);
+    return status;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_GetStreamParam --
+ *
+ *	Determines whether a bound value is a stream parameter token.
+ *
+ * Results:
+ *	Returns a standard Tcl result. If the value is a token, stores the
+ *	channel to read in '*chanPtr' and the number of bytes to read, or
+ *	-1 to read to end of file, in '*lengthPtr'. If the value is not a
+ *	token, stores NULL in '*chanPtr'. If the token's channel has been
+ *	closed, returns TCL_ERROR with a message in the interpreter.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI int
+Tdbc_GetStreamParam(
+    Tcl_Interp* interp,		/* Interpreter in which the channel is open */
+    Tcl_Obj* objPtr,		/* Bound value */
+    Tcl_Channel* chanPtr,	/* OUTPUT: Channel to read */
+    Tcl_WideInt* lengthPtr	/* OUTPUT: Number of bytes to read */
+) {
+    StreamParam* paramPtr;
+    int mode;
+
+    *chanPtr = NULL;
+    if (objPtr->typePtr != &streamParamType) {
+	return TCL_OK;
+    }
+    paramPtr = (StreamParam*) objPtr->internalRep.otherValuePtr;
+    *chanPtr = Tcl_GetChannel(interp, Tcl_GetString(paramPtr->channelName),
+			      &mode);
+    if (*chanPtr == NULL) {
+	return TCL_ERROR;
+    }
+    *lengthPtr = paramPtr->length;
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_ReadStreamParam --
+ *
+ *	Reads the next chunk of a stream parameter.
+ *
+ * Results:
+ *	Returns the number of bytes read into 'buffer', which is at most
+ *	'bufSize', 0 at the end of the parameter, or -1 if an error occurred,
+ *	in which case Tcl_GetErrno gives the reason.
+ *
+ * Side effects:
+ *	Decreases '*remainingPtr', which holds the number of bytes of the
+ *	parameter still to be read, or -1 if the parameter extends to end of
+ *	file, by the number of bytes read.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI int
+Tdbc_ReadStreamParam(
+    Tcl_Channel chan,		/* Channel from Tdbc_GetStreamParam */
+    Tcl_WideInt* remainingPtr,	/* IN/OUT: Bytes still to read */
+    char* buffer,		/* Buffer that receives the bytes */
+    int bufSize			/* Size of the buffer */
+) {
+    int toRead = bufSize;
+    int got;
+
+    if (*remainingPtr >= 0 && *remainingPtr < toRead) {
+	toRead = (int) *remainingPtr;
+    }
+    if (toRead == 0) {
+	return 0;
+    }
+    got = Tcl_Read(chan, buffer, toRead);
+    if (got > 0 && *remainingPtr > 0) {
+	*remainingPtr -= got;
+    }
+    return got;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DupStreamParamInternalRep --
+ *
+ *	Duplicates a stream parameter token.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DupStreamParamInternalRep(
+    Tcl_Obj* srcPtr,		/* Token to copy */
+    Tcl_Obj* dupPtr		/* Copy */
+) {
+    StreamParam* paramPtr = (StreamParam*) srcPtr->internalRep.otherValuePtr;
+
+    ++paramPtr->refCount;
+    dupPtr->internalRep.otherValuePtr = paramPtr;
+    dupPtr->typePtr = &streamParamType;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FreeStreamParamInternalRep --
+ *
+ *	Releases a token's reference to its stream parameter.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+FreeStreamParamInternalRep(
+    Tcl_Obj* objPtr		/* Token being freed */
+) {
+    StreamParam* paramPtr = (StreamParam*) objPtr->internalRep.otherValuePtr;
+
+    if (--paramPtr->refCount == 0) {
+	Tcl_DecrRefCount(paramPtr->channelName);
+	ckfree((char*) paramPtr);
+	Tcl_MutexLock(&streamMutex);
+	--streamParamCount;
+	Tcl_MutexUnlock(&streamMutex);
+    }
+    objPtr->typePtr = NULL;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * UpdateStreamParamString --
+ *
+ *	Makes the string representation of a token, which names the
+ *	channel and length for the benefit of a human reader.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+UpdateStreamParamString(
+    Tcl_Obj* objPtr		/* Token */
+) {
+    StreamParam* paramPtr = (StreamParam*) objPtr->internalRep.otherValuePtr;
+    Tcl_Obj* stringPtr;
+    const char* bytes;
+    int length;
+
+    stringPtr = Tcl_ObjPrintf("tdbc::streamparam %s %" TCL_LL_MODIFIER "d",
+			      Tcl_GetString(paramPtr->channelName),
+			      paramPtr->length);
+    bytes = Tcl_GetStringFromObj(stringPtr, &length);
+    objPtr->bytes = ckalloc(length + 1);
+    memcpy(objPtr->bytes, bytes, length + 1);
+    objPtr->length = length;
+    Tcl_DecrRefCount(stringPtr);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * SetStreamParamFromAny --
+ *
+ *	Refuses to make a token from any other value.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+SetStreamParamFromAny(
+    Tcl_Interp* interp,		/* Interpreter for error reporting */
+    Tcl_Obj* objPtr		/* Value to convert */
+) {
+    if (interp != NULL) {
+	Tcl_SetObjResult(interp,
+			 Tcl_NewStringObj("only tdbc::streamparam can make "
+					  "a stream parameter", -1));
+    }
+    return TCL_ERROR;
+}
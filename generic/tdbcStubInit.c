@@ -29,6 +29,18 @@ const TdbcStubs tdbcStubs = {
     Tdbc_Init_, /* 0 */
     Tdbc_TokenizeSql, /* 1 */
     Tdbc_MapSqlState, /* 2 */
+    Tdbc_SetResultSetType, /* 3 */
+    Tdbc_GetResultSetType, /* 4 */
+    Tdbc_NewInt64Value, /* 5 */
+    Tdbc_NewDoubleValue, /* 6 */
+    Tdbc_NewBytesValue, /* 7 */
+    Tdbc_NewDecimalValue, /* 8 */
+    Tdbc_NewTimestampValue, /* 9 */
+    Tdbc_GetStreamParam, /* 10 */
+    Tdbc_ReadStreamParam, /* 11 */
+    Tdbc_ClassifySql, /* 12 */
+    Tdbc_SetCancelProc, /* 13 */
+    Tdbc_InternRow, /* 14 */
 };
 
 /* !END!: Do not edit above this line. */
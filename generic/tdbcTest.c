@@ -0,0 +1,321 @@
+/*
+ * tdbcTest.c --
+ *
+ *	A Tdbc_ResultSetType that the test suite attaches to result sets, so
+ *	that the code which drivers written in C reach, such as read-ahead
+ *	in another thread, can be tested without a database.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <string.h>
+
+/*
+ * Structure that describes the rows of a test result set. The rows of the
+ * set of results 'set' are the numbers 100*set+1 to 100*set+rows, in a
+ * single column named 'n' for the first set and 'n<set>' for the others.
+ */
+
+typedef struct TestFetch {
+    int rows;			/* Number of rows in each set of results */
+    int sets;			/* Number of sets of results */
+    int errorRow;		/* Row whose fetch fails, counting from 1,
+				 * or 0 if none fails */
+    int delay;			/* Milliseconds that each fetch takes */
+    int set;			/* Index of the current set of results */
+    int row;			/* Number of rows fetched from the set */
+    int fetching;		/* 1 while a fetch is in progress */
+    int deleted;		/* 1 if the result set was destroyed while
+				 * a fetch was in progress */
+} TestFetch;
+
+/*
+ * Counts, shared by all threads, of the test result sets that exist and of
+ * those that were destroyed while a fetch was in progress. The mutex also
+ * protects the fields of every TestFetch.
+ */
+
+TCL_DECLARE_MUTEX(testMutex)
+static int liveCount = 0;
+static int unsafeCount = 0;
+
+/* Static procedures declared in this file */
+
+static int TestColumns(Tcl_Interp* interp, ClientData clientData,
+		       Tcl_Obj** columnsPtr);
+static int TestFetchRow(Tcl_Interp* interp, ClientData clientData,
+			int nColumns, Tcl_Obj** values, int* gotRowPtr);
+static int TestNextResults(Tcl_Interp* interp, ClientData clientData,
+			   int* moreResultsPtr);
+static int TestRowCount(Tcl_Interp* interp, ClientData clientData,
+			Tcl_WideInt* rowCountPtr);
+static void DeleteTestFetch(ClientData clientData);
+
+static const Tdbc_ResultSetType testType = {
+    "test",			/* name */
+    TDBC_RESULTSETTYPE_VERSION_2,
+				/* version */
+    TestColumns,		/* columnsProc */
+    TestFetchRow,		/* fetchRowProc */
+    TestNextResults,		/* nextResultsProc */
+    TestRowCount,		/* rowCountProc */
+    TDBC_FETCH_THREADSAFE	/* flags */
+};
+
+/*
+ * The TestFetch is freed with the object, as a driver's data would be.
+ */
+
+static const Tcl_ObjectMetadataType testFetchMetadata = {
+    TCL_OO_METADATA_VERSION_CURRENT,
+				/* version */
+    "TdbcTestFetch",		/* name */
+    DeleteTestFetch,		/* deleteProc */
+    NULL			/* cloneProc */
+};
+
+/* Subcommands of ::tdbc::TestFetchType */
+
+static const char *const testSubcommands[] = {
+    "attach", "report", NULL
+};
+enum TestSubcommand {
+    TF_ATTACH, TF_REPORT
+};
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcTestFetchTypeObjCmd --
+ *
+ *	Attaches test rows to result sets, for the test suite.
+ *
+ * Usage:
+ *	::tdbc::TestFetchType attach resultSet rows ?sets? ?errorRow? ?delay?
+ *		Attaches a table of procedures, marked TDBC_FETCH_THREADSAFE,
+ *		that returns 'rows' rows in each of 'sets' sets of results.
+ *		If 'errorRow' is not 0, fetching that row fails. Each fetch
+ *		takes 'delay' milliseconds.
+ *	::tdbc::TestFetchType report
+ *		Returns a list of the number of test result sets that exist
+ *		and the number that were destroyed while a row was being
+ *		fetched from them.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcTestFetchTypeObjCmd(
+    ClientData dummy,		/* Not used */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Object object;
+    TestFetch* testPtr;
+    Tcl_Obj* resultObj;
+    int params[4] = { 0, 1, 0, 0 };
+    int index;
+    int i;
+
+    if (objc < 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "subcommand ?arg...?");
+	return TCL_ERROR;
+    }
+    if (Tcl_GetIndexFromObj(interp, objv[1], testSubcommands,
+			    "subcommand", 0, &index) != TCL_OK) {
+	return TCL_ERROR;
+    }
+    if (index == TF_REPORT) {
+	if (objc != 2) {
+	    Tcl_WrongNumArgs(interp, 2, objv, "");
+	    return TCL_ERROR;
+	}
+	Tcl_MutexLock(&testMutex);
+	resultObj = Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewIntObj(liveCount));
+	Tcl_ListObjAppendElement(NULL, resultObj, Tcl_NewIntObj(unsafeCount));
+	Tcl_MutexUnlock(&testMutex);
+	Tcl_SetObjResult(interp, resultObj);
+	return TCL_OK;
+    }
+
+    if (objc < 4 || objc > 7) {
+	Tcl_WrongNumArgs(interp, 2, objv,
+			 "resultSet rows ?sets? ?errorRow? ?delay?");
+	return TCL_ERROR;
+    }
+    object = Tcl_GetObjectFromObj(interp, objv[2]);
+    if (object == NULL) {
+	return TCL_ERROR;
+    }
+    for (i = 3; i < objc; ++i) {
+	if (Tcl_GetIntFromObj(interp, objv[i], params + i - 3) != TCL_OK) {
+	    return TCL_ERROR;
+	}
+    }
+    testPtr = (TestFetch*) ckalloc(sizeof(TestFetch));
+    memset(testPtr, 0, sizeof(TestFetch));
+    testPtr->rows = params[0];
+    testPtr->sets = params[1];
+    testPtr->errorRow = params[2];
+    testPtr->delay = params[3];
+    Tcl_MutexLock(&testMutex);
+    ++liveCount;
+    Tcl_MutexUnlock(&testMutex);
+    Tcl_ObjectSetMetadata(object, &testFetchMetadata, (ClientData) testPtr);
+    Tdbc_SetResultSetType(object, &testType, (ClientData) testPtr);
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DeleteTestFetch --
+ *
+ *	Frees the rows of a test result set when it is destroyed. If a row
+ *	is being fetched meanwhile, which a driver could not survive, the
+ *	fact is counted and the fetch frees the structure when it returns.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DeleteTestFetch(
+    ClientData clientData	/* Rows of the result set */
+) {
+    TestFetch* testPtr = (TestFetch*) clientData;
+
+    Tcl_MutexLock(&testMutex);
+    --liveCount;
+    if (testPtr->fetching) {
+	++unsafeCount;
+	testPtr->deleted = 1;
+	testPtr = NULL;
+    }
+    Tcl_MutexUnlock(&testMutex);
+    if (testPtr != NULL) {
+	ckfree((char*) testPtr);
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TestColumns, TestFetchRow, TestNextResults, TestRowCount --
+ *
+ *	Procedures of the test result set type.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+TestColumns(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Rows of the result set */
+    Tcl_Obj** columnsPtr	/* OUTPUT: Column names */
+) {
+    TestFetch* testPtr = (TestFetch*) clientData;
+    Tcl_Obj* nameObj;
+
+    if (testPtr->set == 0) {
+	nameObj = Tcl_NewStringObj("n", -1);
+    } else {
+	nameObj = Tcl_ObjPrintf("n%d", testPtr->set);
+    }
+    *columnsPtr = Tcl_NewListObj(1, &nameObj);
+    return TCL_OK;
+}
+
+static int
+TestFetchRow(
+    Tcl_Interp* interp,		/* Tcl interpreter, or NULL in a thread
+				 * that reads ahead */
+    ClientData clientData,	/* Rows of the result set */
+    int nColumns,		/* Number of columns wanted */
+    Tcl_Obj** values,		/* OUTPUT: Cells of the row */
+    int* gotRowPtr		/* OUTPUT: 1 if a row was fetched */
+) {
+    TestFetch* testPtr = (TestFetch*) clientData;
+    Tcl_Obj* messageObj;
+    Tcl_Obj* codeObj;
+    int i;
+
+    *gotRowPtr = 0;
+    Tcl_MutexLock(&testMutex);
+    testPtr->fetching = 1;
+    Tcl_MutexUnlock(&testMutex);
+    if (testPtr->delay > 0) {
+	Tcl_Sleep(testPtr->delay);
+    }
+    Tcl_MutexLock(&testMutex);
+    testPtr->fetching = 0;
+    if (testPtr->deleted) {
+	Tcl_MutexUnlock(&testMutex);
+	ckfree((char*) testPtr);
+	return TCL_OK;
+    }
+    Tcl_MutexUnlock(&testMutex);
+
+    if (testPtr->row >= testPtr->rows) {
+	return TCL_OK;
+    }
+    if (testPtr->row + 1 == testPtr->errorRow) {
+	messageObj = Tcl_ObjPrintf("error fetching row %d", testPtr->errorRow);
+	codeObj = Tcl_NewStringObj("TDBC GENERAL_ERROR HY000 {} testFetch",
+				   -1);
+	if (interp != NULL) {
+	    Tcl_SetObjResult(interp, messageObj);
+	    Tcl_SetObjErrorCode(interp, codeObj);
+	} else {
+	    values[0] = messageObj;
+	    values[1] = codeObj;
+	}
+	return TCL_ERROR;
+    }
+    ++testPtr->row;
+    for (i = 0; i < nColumns; ++i) {
+	values[i] = NULL;
+    }
+    if (nColumns > 0) {
+	values[0] = Tcl_NewIntObj(100 * testPtr->set + testPtr->row);
+    }
+    *gotRowPtr = 1;
+    return TCL_OK;
+}
+
+static int
+TestNextResults(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Rows of the result set */
+    int* moreResultsPtr		/* OUTPUT: 1 if there is another set */
+) {
+    TestFetch* testPtr = (TestFetch*) clientData;
+
+    *moreResultsPtr = 0;
+    if (testPtr->set + 1 < testPtr->sets) {
+	++testPtr->set;
+	testPtr->row = 0;
+	*moreResultsPtr = 1;
+    }
+    return TCL_OK;
+}
+
+static int
+TestRowCount(
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    ClientData clientData,	/* Rows of the result set */
+    Tcl_WideInt* rowCountPtr	/* OUTPUT: Row count */
+) {
+    TestFetch* testPtr = (TestFetch*) clientData;
+
+    *rowCountPtr = testPtr->rows;
+    return TCL_OK;
+}
+
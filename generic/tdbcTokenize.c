@@ -2,7 +2,9 @@
  * tdbcTokenize.c --
  *
  *	Code for a Tcl command that will extract subsitutable parameters
- *	from a SQL statement.
+ *	from a SQL statement, for classifying statements by what they do
+ *	and what tables they refer to, and for replacing the literals in a
+ *	statement with bound variables.
  *
  * Copyright (c) 2007 by D. Richard Hipp.
  * Copyright (c) 2010, 2011 by Kevin B. Kenny.
@@ -17,6 +19,123 @@
 
 #include "tdbcInt.h"
 #include <ctype.h>
+#include <string.h>
+
+/*
+ * Keywords that the classifier recognizes. Each table is terminated by
+ * NULL.
+ */
+
+static const char *const readOnlyKinds[] = {
+    "SELECT", "VALUES", "SHOW", "EXPLAIN", "DESCRIBE", NULL
+};
+static const char *const writeKinds[] = {
+    "INSERT", "UPDATE", "DELETE", "MERGE", "REPLACE", "UPSERT", NULL
+};
+static const char *const ddlKinds[] = {
+    "CREATE", "ALTER", "DROP", "RENAME", "TRUNCATE", "COMMENT", "GRANT",
+    "REVOKE", NULL
+};
+static const char *const transactionKinds[] = {
+    "BEGIN", "START", "COMMIT", "ROLLBACK", "SAVEPOINT", "RELEASE", "END",
+    NULL
+};
+
+/* Keywords after which a table name is expected */
+
+static const char *const tableIntroducers[] = {
+    "FROM", "JOIN", "UPDATE", "INTO", "TABLE", NULL
+};
+
+/* Keywords that make a statement write, wherever they appear */
+
+static const char *const writeKeywords[] = {
+    "INSERT", "DELETE", "MERGE", "REPLACE", NULL
+};
+
+/* Keywords and punctuation that end a list of table names */
+
+static const char *const tableTerminators[] = {
+    "SELECT", "WHERE", "ON", "USING", "SET", "VALUES", "GROUP", "ORDER",
+    "HAVING", "LIMIT", "UNION", "EXCEPT", "INTERSECT", "INNER", "LEFT",
+    "RIGHT", "FULL", "OUTER", "CROSS", "NATURAL", "ONLY", "IF", "NOT",
+    "EXISTS", "(", ")", ";", NULL
+};
+
+/* Kinds of statement whose literals may be replaced by bound variables */
+
+static const char *const parameterizedKinds[] = {
+    "SELECT", "VALUES", "WITH", "INSERT", "UPDATE", "DELETE", "MERGE",
+    "REPLACE", "UPSERT", NULL
+};
+
+/*
+ * Keywords after which a list of numeric literals stays inline, because
+ * databases require constants there (LIMIT 10, 20; FETCH FIRST 5 ROWS)
+ */
+
+static const char *const inlineListIntroducers[] = {
+    "LIMIT", "OFFSET", "TOP", "FETCH", "FIRST", "NEXT", NULL
+};
+
+/* Keywords that make the literal following them a typed constant */
+
+static const char *const typedLiteralIntroducers[] = {
+    "DATE", "TIME", "TIMESTAMP", "INTERVAL", NULL
+};
+
+/* Type names whose parenthesized arguments are constants */
+
+static const char *const parameterizedTypes[] = {
+    "CHAR", "CHARACTER", "VARCHAR", "VARCHAR2", "NCHAR", "NVARCHAR",
+    "NVARCHAR2", "VARYING", "BINARY", "VARBINARY", "RAW", "BIT", "DEC",
+    "DECIMAL", "NUMERIC", "NUMBER", "FLOAT", "TIME", "TIMESTAMP",
+    "DATETIME2", "DATETIMEOFFSET", NULL
+};
+
+/* Keywords that end the list of an ORDER BY or GROUP BY clause */
+
+static const char *const orderByTerminators[] = {
+    "LIMIT", "OFFSET", "FETCH", "HAVING", "WINDOW", "UNION", "EXCEPT",
+    "INTERSECT", "FOR", NULL
+};
+
+/*
+ * State of a level of parentheses when literals are replaced. Deeper
+ * levels than MAX_PARAMETERIZE_DEPTH share the state of the deepest.
+ */
+
+#define MAX_PARAMETERIZE_DEPTH 64
+enum ParameterizeState {
+    IN_SELECT_LIST = 1,		/* Between SELECT and FROM */
+    IN_ORDER_BY = 2,		/* In an ORDER BY or GROUP BY clause */
+    IN_TYPE_ARGS = 4		/* Arguments of a type such as VARCHAR(20) */
+};
+
+/* Static functions defined in this file */
+
+static Tcl_Obj* ClassifySql(Tcl_Obj* sqlObj);
+static void DupSqlClassInternalRep(Tcl_Obj* srcPtr, Tcl_Obj* dupPtr);
+static void FreeSqlClassInternalRep(Tcl_Obj* objPtr);
+static int IsKeyword(const char* word, const char *const table[]);
+static Tcl_Obj* NewCaseObj(const char* bytes, int length, int upper);
+static Tcl_Obj* ParameterizeSql(Tcl_Obj* sqlObj, Tcl_Obj* valuesPtr);
+static void SplitWords(const char* p, const char* end, Tcl_Obj* wordsPtr);
+
+/*
+ * Type of the classification that Tdbc_ClassifySql caches on the SQL
+ * code. The internal representation is a pointer to the dictionary that
+ * it returns. The string representation is never discarded, so no
+ * procedure to regenerate it is needed.
+ */
+
+static const Tcl_ObjType sqlClassType = {
+    "tdbc::sqlclass",		/* name */
+    FreeSqlClassInternalRep,	/* freeIntRepProc */
+    DupSqlClassInternalRep,	/* dupIntRepProc */
+    NULL,			/* updateStringProc */
+    NULL			/* setFromAnyProc */
+};
 
 /*
  *-----------------------------------------------------------------------------
@@ -216,3 +335,821 @@ TdbcTokenizeObjCmd(
     return TCL_OK;
     
 }
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_ClassifySql --
+ *
+ *	Determines what kind of statement a piece of SQL code is, and what
+ *	tables it refers to.
+ *
+ * Results:
+ *	Returns a dictionary with the keys:
+ *	    kind     - The leading keyword of the statement, in upper case
+ *	    category - 'query', 'dml', 'ddl', 'transaction' or 'other'
+ *	    readonly - 1 if the statement only reads from the database
+ *	    tables   - Names of the tables that the statement refers to,
+ *		       in lower case unless quoted, without schema names
+ *	    params   - Names of the bound variables in the statement
+ *
+ *	The dictionary is cached in the internal representation of
+ *	'sqlObj', so that classifying the same value again costs nothing.
+ *	It belongs to 'sqlObj', and remains valid only while 'sqlObj' keeps
+ *	that representation; a caller that keeps it must increment its
+ *	reference count.
+ *
+ * Only the common subset of SQL is understood. Statements that cannot be
+ * analyzed are reported as not being read-only, and so are SELECT
+ * statements that lock rows with FOR UPDATE or FOR SHARE.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_ClassifySql(
+    Tcl_Interp* interp,		/* Tcl interpreter, unused */
+    Tcl_Obj* sqlObj		/* SQL code to classify */
+) {
+    Tcl_Obj* classPtr;
+
+    if (sqlObj->typePtr == &sqlClassType) {
+	return (Tcl_Obj*) sqlObj->internalRep.otherValuePtr;
+    }
+    classPtr = ClassifySql(sqlObj);
+    Tcl_IncrRefCount(classPtr);
+
+    /*
+     * Make sure that the string representation exists before discarding
+     * the old internal representation.
+     */
+
+    Tcl_GetString(sqlObj);
+    if (sqlObj->typePtr != NULL && sqlObj->typePtr->freeIntRepProc != NULL) {
+	sqlObj->typePtr->freeIntRepProc(sqlObj);
+    }
+    sqlObj->internalRep.otherValuePtr = classPtr;
+    sqlObj->typePtr = &sqlClassType;
+    return classPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ClassifySql --
+ *
+ *	Classifies a piece of SQL code, as described for Tdbc_ClassifySql.
+ *
+ * Results:
+ *	Returns the dictionary, with a reference count of zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+ClassifySql(
+    Tcl_Obj* sqlObj		/* SQL code to classify */
+) {
+    Tcl_Obj* tokensPtr;		/* Tokens of the SQL code */
+    Tcl_Obj** tokenv;
+    int tokenc;
+    Tcl_Obj* wordsPtr;		/* Keywords, identifiers and punctuation */
+    Tcl_Obj** wordv;
+    int wordc;
+    Tcl_Obj* paramsPtr;		/* Names of bound variables */
+    Tcl_Obj* tablesPtr;		/* Names of tables */
+    Tcl_Obj* kindPtr;		/* Leading keyword, in upper case */
+    Tcl_Obj* upperPtr = NULL;	/* Current word, in upper case */
+    Tcl_Obj* previousPtr = NULL;	/* Previous word, in upper case */
+    Tcl_Obj* namePtr;
+    Tcl_Obj** namev;
+    int namec;
+    Tcl_Obj* resultPtr;
+    const char* category;
+    const char* token;
+    const char* word;
+    const char* upper;
+    const char* kind;
+    const char* previous;
+    const char* dot;
+    int length;
+    int readOnly;
+    int expect = 0;		/* 1 if a table name is expected next,
+				 * 2 if one has just been seen */
+    int sawSelect = 0;		/* 1 if SELECT appears anywhere */
+    int sawWrite = 0;		/* 1 if INSERT, UPDATE or DELETE appears */
+    int found;
+    int i, j;
+
+    /*
+     * Replace bound variables with placeholders, and split the rest of
+     * the statement into words, discarding comments and string literals.
+     */
+
+    tokensPtr = Tdbc_TokenizeSql(NULL, Tcl_GetString(sqlObj));
+    Tcl_IncrRefCount(tokensPtr);
+    Tcl_ListObjGetElements(NULL, tokensPtr, &tokenc, &tokenv);
+    wordsPtr = Tcl_NewObj();
+    Tcl_IncrRefCount(wordsPtr);
+    paramsPtr = Tcl_NewObj();
+    for (i = 0; i < tokenc; ++i) {
+	token = Tcl_GetStringFromObj(tokenv[i], &length);
+	if (length >= 2 && strchr(":$@", token[0]) != NULL) {
+	    for (j = 1; j < length; ++j) {
+		if (!isalnum((unsigned char) token[j]) && token[j] != '_') {
+		    break;
+		}
+	    }
+	    if (j == length) {
+		Tcl_ListObjGetElements(NULL, paramsPtr, &namec, &namev);
+		for (found = 0, j = 0; j < namec && !found; ++j) {
+		    found = !strcmp(Tcl_GetString(namev[j]), token + 1);
+		}
+		if (!found) {
+		    Tcl_ListObjAppendElement(NULL, paramsPtr,
+			    Tcl_NewStringObj(token + 1, length - 1));
+		}
+		Tcl_ListObjAppendElement(NULL, wordsPtr,
+					 Tcl_NewStringObj("?", 1));
+		continue;
+	    }
+	}
+	SplitWords(token, token + length, wordsPtr);
+    }
+    Tcl_DecrRefCount(tokensPtr);
+
+    /* The leading keyword tells what kind of statement it is */
+
+    Tcl_ListObjGetElements(NULL, wordsPtr, &wordc, &wordv);
+    if (wordc > 0) {
+	word = Tcl_GetStringFromObj(wordv[0], &length);
+	kindPtr = NewCaseObj(word, length, 1);
+    } else {
+	kindPtr = Tcl_NewObj();
+    }
+    Tcl_IncrRefCount(kindPtr);
+    kind = Tcl_GetString(kindPtr);
+    readOnly = IsKeyword(kind, readOnlyKinds);
+
+    /*
+     * Look for table names, which follow FROM, JOIN, UPDATE, INTO and
+     * TABLE, and continue in a comma-separated list that may give each
+     * table an alias. Look also for the keywords that make a statement
+     * write to the database.
+     */
+
+    tablesPtr = Tcl_NewObj();
+    for (i = 0; i < wordc; ++i) {
+	word = Tcl_GetStringFromObj(wordv[i], &length);
+	if (previousPtr != NULL) {
+	    Tcl_DecrRefCount(previousPtr);
+	}
+	previousPtr = upperPtr;
+	previous = (previousPtr != NULL) ? Tcl_GetString(previousPtr) : "";
+	upperPtr = NewCaseObj(word, length, 1);
+	Tcl_IncrRefCount(upperPtr);
+	upper = Tcl_GetString(upperPtr);
+	if (!strcmp(upper, "SELECT")) {
+	    sawSelect = 1;
+	} else if (!strcmp(upper, "INSERT") || !strcmp(upper, "UPDATE")
+		   || !strcmp(upper, "DELETE")) {
+	    sawWrite = 1;
+	}
+	if (!strcmp(previous, "FOR")
+	    && (!strcmp(upper, "UPDATE") || !strcmp(upper, "SHARE"))) {
+	    readOnly = 0;
+	    expect = 0;
+	} else if (IsKeyword(upper, tableIntroducers)) {
+	    expect = 1;
+	} else if (IsKeyword(upper, writeKeywords)) {
+	    readOnly = 0;
+	    expect = 0;
+	} else if (IsKeyword(upper, tableTerminators)) {
+	    expect = 0;
+	} else if (!strcmp(upper, ",")) {
+	    if (expect == 2) {
+		expect = 1;
+	    }
+	} else if (expect == 1) {
+	    if (word[0] == '"' || word[0] == '[') {
+		namePtr = Tcl_NewStringObj(word + 1, length - 2);
+	    } else {
+		dot = strrchr(word, '.');
+		if (dot != NULL) {
+		    length -= (int) (dot + 1 - word);
+		    word = dot + 1;
+		}
+		namePtr = NewCaseObj(word, length, 0);
+	    }
+	    Tcl_ListObjGetElements(NULL, tablesPtr, &namec, &namev);
+	    for (found = 0, j = 0; j < namec && !found; ++j) {
+		found = !strcmp(Tcl_GetString(namev[j]),
+				Tcl_GetString(namePtr));
+	    }
+	    if (found) {
+		Tcl_DecrRefCount(namePtr);
+	    } else {
+		Tcl_ListObjAppendElement(NULL, tablesPtr, namePtr);
+	    }
+	    expect = 2;
+	}
+    }
+    if (previousPtr != NULL) {
+	Tcl_DecrRefCount(previousPtr);
+    }
+    if (upperPtr != NULL) {
+	Tcl_DecrRefCount(upperPtr);
+    }
+    Tcl_DecrRefCount(wordsPtr);
+
+    /* A WITH statement reads only if it is a SELECT that writes nothing */
+
+    if (!strcmp(kind, "WITH")) {
+	readOnly = sawSelect && !sawWrite;
+    }
+
+    if (IsKeyword(kind, readOnlyKinds)
+	|| (!strcmp(kind, "WITH") && readOnly)) {
+	category = "query";
+    } else if (IsKeyword(kind, writeKinds) || !strcmp(kind, "WITH")) {
+	category = "dml";
+    } else if (IsKeyword(kind, ddlKinds)) {
+	category = "ddl";
+    } else if (IsKeyword(kind, transactionKinds)) {
+	category = "transaction";
+    } else {
+	category = "other";
+    }
+
+    resultPtr = Tcl_NewDictObj();
+    Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("kind", -1), kindPtr);
+    Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("category", -1),
+		   Tcl_NewStringObj(category, -1));
+    Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("readonly", -1),
+		   Tcl_NewIntObj(readOnly));
+    Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("tables", -1),
+		   tablesPtr);
+    Tcl_DictObjPut(NULL, resultPtr, Tcl_NewStringObj("params", -1),
+		   paramsPtr);
+    Tcl_DecrRefCount(kindPtr);
+    return resultPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * SplitWords --
+ *
+ *	Splits text from a SQL statement into the words that the classifier
+ *	examines.
+ *
+ * Side effects:
+ *	Appends to 'wordsPtr' each identifier or keyword, each quoted
+ *	identifier ("..." or [...]), and each of the characters ( ) , ; ?.
+ *	Comments and string literals are skipped, and so is any other
+ *	character.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+SplitWords(
+    const char* p,		/* Start of the text */
+    const char* end,		/* End of the text */
+    Tcl_Obj* wordsPtr		/* List of words to append to */
+) {
+    const char* start;
+    const char* q;
+    unsigned char c;
+
+    while (p < end) {
+	c = (unsigned char) *p;
+	start = p;
+	if (c == '-' && p + 1 < end && p[1] == '-') {
+	    while (p < end && *p != '\n') {
+		++p;
+	    }
+	} else if (c == '/' && p + 1 < end && p[1] == '*') {
+	    for (q = p + 2; q + 1 < end && (q[0] != '*' || q[1] != '/'); ++q) {
+		/* do nothing */
+	    }
+	    p = (q + 1 < end) ? q + 2 : p + 1;
+	} else if (c == '\'') {
+	    for (q = p + 1; q < end; ++q) {
+		if (*q == '\'') {
+		    if (q + 1 < end && q[1] == '\'') {
+			++q;
+		    } else {
+			break;
+		    }
+		}
+	    }
+	    p = (q < end) ? q + 1 : p + 1;
+	} else if (c == '"' || c == '[') {
+	    q = memchr(p + 1, (c == '"') ? '"' : ']', end - p - 1);
+	    if (q != NULL) {
+		p = q + 1;
+		Tcl_ListObjAppendElement(NULL, wordsPtr,
+					 Tcl_NewStringObj(start, p - start));
+	    } else {
+		++p;
+	    }
+	} else if (isalpha(c) || c == '_' || c >= 0x80) {
+	    while (p < end && (isalnum((unsigned char) *p) || *p == '_'
+			       || *p == '$' || *p == '.'
+			       || (unsigned char) *p >= 0x80)) {
+		++p;
+	    }
+	    Tcl_ListObjAppendElement(NULL, wordsPtr,
+				     Tcl_NewStringObj(start, p - start));
+	} else {
+	    ++p;
+	    if (strchr("(),;?", c) != NULL && c != '\0') {
+		Tcl_ListObjAppendElement(NULL, wordsPtr,
+					 Tcl_NewStringObj(start, 1));
+	    }
+	}
+    }
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * IsKeyword --
+ *
+ *	Tests whether a word, in upper case, is in a table of keywords.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static int
+IsKeyword(
+    const char* word,		/* Word to look for */
+    const char *const table[]	/* Keywords, terminated by NULL */
+) {
+    int i;
+
+    for (i = 0; table[i] != NULL; ++i) {
+	if (!strcmp(word, table[i])) {
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * NewCaseObj --
+ *
+ *	Makes a Tcl value holding a copy of a string converted to upper or
+ *	lower case.
+ *
+ * Results:
+ *	Returns the value, with a reference count of zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+NewCaseObj(
+    const char* bytes,		/* String to convert */
+    int length,			/* Length of the string in bytes */
+    int upper			/* 1 for upper case, 0 for lower */
+) {
+    Tcl_Obj* objPtr = Tcl_NewStringObj(bytes, length);
+    char* copy = Tcl_GetString(objPtr);
+
+    length = upper ? Tcl_UtfToUpper(copy) : Tcl_UtfToLower(copy);
+    Tcl_SetObjLength(objPtr, length);
+    return objPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * DupSqlClassInternalRep --
+ *
+ *	Duplicates the cached classification of SQL code.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+DupSqlClassInternalRep(
+    Tcl_Obj* srcPtr,		/* Value to copy */
+    Tcl_Obj* dupPtr		/* Copy */
+) {
+    Tcl_Obj* classPtr = (Tcl_Obj*) srcPtr->internalRep.otherValuePtr;
+
+    Tcl_IncrRefCount(classPtr);
+    dupPtr->internalRep.otherValuePtr = classPtr;
+    dupPtr->typePtr = &sqlClassType;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * FreeSqlClassInternalRep --
+ *
+ *	Releases the cached classification of SQL code.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static void
+FreeSqlClassInternalRep(
+    Tcl_Obj* objPtr		/* Value being freed or converted */
+) {
+    Tcl_DecrRefCount((Tcl_Obj*) objPtr->internalRep.otherValuePtr);
+    objPtr->typePtr = NULL;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcClassifyObjCmd --
+ *
+ *	Tcl command to classify a SQL statement.
+ *
+ * Usage:
+ *	::tdbc::classify sqlcode
+ *
+ * Results:
+ *	Returns the dictionary described for Tdbc_ClassifySql.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcClassifyObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Obj* classPtr;
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "sqlcode");
+	return TCL_ERROR;
+    }
+    classPtr = Tdbc_ClassifySql(interp, objv[1]);
+    if (classPtr == NULL) {
+	return TCL_ERROR;
+    }
+    Tcl_SetObjResult(interp, classPtr);
+    return TCL_OK;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * ParameterizeSql --
+ *
+ *	Replaces the literals in a SQL statement with bound variables, so
+ *	that statements that differ only in their constants have the same
+ *	SQL code.
+ *
+ * Results:
+ *	Returns the rewritten SQL code, or 'sqlObj' itself if no literal
+ *	was replaced.
+ *
+ * Side effects:
+ *	Stores in the dictionary 'valuesPtr' the value of each literal that
+ *	is replaced, under the name of its variable.
+ *
+ * Only SELECT, VALUES, WITH and data manipulation statements are
+ * rewritten. Plain string literals without backslashes, and decimal
+ * numbers, are replaced by variables named ':tdbc_1', ':tdbc_2', ...,
+ * skipping the names of the statement's own variables. Literals stay
+ * inline where databases require constants or cannot infer the type of
+ * a variable: after LIMIT, OFFSET, TOP, FETCH, FIRST and NEXT; after
+ * DATE, TIME, TIMESTAMP and INTERVAL; in the arguments of types such as
+ * VARCHAR(20); in the select list; and as the items of ORDER BY and
+ * GROUP BY lists, where numbers are column ordinals.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+static Tcl_Obj*
+ParameterizeSql(
+    Tcl_Obj* sqlObj,		/* SQL code */
+    Tcl_Obj* valuesPtr		/* Dictionary of the values of the
+				 * literals that are replaced */
+) {
+    Tcl_Obj* classPtr;		/* Classification of the statement */
+    Tcl_Obj* keyPtr;
+    Tcl_Obj* kindPtr;
+    Tcl_Obj* paramsPtr;
+    Tcl_Obj** paramv;
+    int paramc;
+    Tcl_Obj* resultPtr = NULL;	/* Rewritten SQL code */
+    Tcl_Obj* valuePtr;
+    const char* sql;
+    const char* p;
+    const char* end;
+    const char* start;
+    const char* copied;		/* End of the text copied to 'resultPtr' */
+    const char* q;
+    char previous[16];		/* Previous keyword in upper case, or the
+				 * previous punctuation character */
+    char word[16];		/* Current keyword in upper case */
+    char name[TCL_INTEGER_SPACE + 6];
+    unsigned char state[MAX_PARAMETERIZE_DEPTH];
+    unsigned char c;
+    int length;
+    int depth = 0;		/* Depth of parentheses */
+    int level;			/* Index in 'state' of the current level */
+    int keepList = 0;		/* 1 after LIMIT, OFFSET, ... */
+    int keepNext = 0;		/* 1 after DATE, TIME, ... */
+    int literal;		/* 1 for a literal that may be replaced,
+				 * -1 for one that may not */
+    int liftable;
+    int counter = 0;
+    int found;
+    int i;
+
+    /* Only queries and data manipulation are rewritten */
+
+    classPtr = Tdbc_ClassifySql(NULL, sqlObj);
+    Tcl_IncrRefCount(classPtr);
+    keyPtr = Tcl_NewStringObj("kind", -1);
+    Tcl_IncrRefCount(keyPtr);
+    Tcl_DictObjGet(NULL, classPtr, keyPtr, &kindPtr);
+    Tcl_DecrRefCount(keyPtr);
+    if (kindPtr == NULL
+	|| !IsKeyword(Tcl_GetString(kindPtr), parameterizedKinds)) {
+	Tcl_DecrRefCount(classPtr);
+	return sqlObj;
+    }
+    keyPtr = Tcl_NewStringObj("params", -1);
+    Tcl_IncrRefCount(keyPtr);
+    Tcl_DictObjGet(NULL, classPtr, keyPtr, &paramsPtr);
+    Tcl_DecrRefCount(keyPtr);
+    Tcl_ListObjGetElements(NULL, paramsPtr, &paramc, &paramv);
+
+    sql = Tcl_GetStringFromObj(sqlObj, &length);
+    p = copied = sql;
+    end = sql + length;
+    previous[0] = '\0';
+    state[0] = 0;
+
+    while (p < end) {
+	c = (unsigned char) *p;
+	start = p;
+	literal = 0;
+	word[0] = '\0';
+	level = (depth < MAX_PARAMETERIZE_DEPTH)
+	    ? depth : MAX_PARAMETERIZE_DEPTH - 1;
+
+	/* Whitespace and comments */
+
+	if (isspace(c)) {
+	    ++p;
+	    continue;
+	} else if (c == '-' && p + 1 < end && p[1] == '-') {
+	    while (p < end && *p != '\n') {
+		++p;
+	    }
+	    continue;
+	} else if (c == '/' && p + 1 < end && p[1] == '*') {
+	    for (q = p + 2; q + 1 < end && (q[0] != '*' || q[1] != '/'); ++q) {
+		/* do nothing */
+	    }
+	    p = (q + 1 < end) ? q + 2 : end;
+	    continue;
+	}
+
+	/*
+	 * String literals. Only plain strings without backslashes may be
+	 * replaced, because the meaning of the others varies by database.
+	 */
+
+	if (c == '\''
+	    || (strchr("EeNnXxBb", c) != NULL && c != '\0'
+		&& p + 1 < end && p[1] == '\'')) {
+	    literal = (c == '\'') ? 1 : -1;
+	    for (q = (c == '\'') ? p + 1 : p + 2; q < end; ++q) {
+		if (*q == '\\') {
+		    literal = -1;
+		    if (c != '\'' && q + 1 < end) {
+			++q;
+		    }
+		} else if (*q == '\'') {
+		    if (q + 1 < end && q[1] == '\'') {
+			++q;
+		    } else {
+			break;
+		    }
+		}
+	    }
+	    if (q < end) {
+		p = q + 1;
+	    } else {
+		p = end;
+		literal = -1;
+	    }
+	}
+
+	/*
+	 * Numeric literals. Only decimal numbers without leading zeroes
+	 * may be replaced.
+	 */
+
+	else if (isdigit(c)
+		 || (c == '.' && p + 1 < end && isdigit((unsigned char) p[1]))) {
+	    while (p < end && (isalnum((unsigned char) *p) || *p == '.'
+			       || ((*p == '+' || *p == '-')
+				   && (p[-1] == 'e' || p[-1] == 'E')))) {
+		++p;
+	    }
+	    q = start;
+	    while (q < p && isdigit((unsigned char) *q)) {
+		++q;
+	    }
+	    found = (q > start);
+	    if (q < p && *q == '.') {
+		for (++q; q < p && isdigit((unsigned char) *q); ++q) {
+		    found = 1;
+		}
+	    }
+	    if (found && q < p && (*q == 'e' || *q == 'E')) {
+		++q;
+		if (q < p && (*q == '+' || *q == '-')) {
+		    ++q;
+		}
+		found = (q < p && isdigit((unsigned char) *q));
+		while (q < p && isdigit((unsigned char) *q)) {
+		    ++q;
+		}
+	    }
+	    literal = (found && q == p
+		       && !(c == '0' && p - start > 1
+			    && isdigit((unsigned char) start[1]))) ? 1 : -1;
+	}
+
+	/* Quoted identifiers */
+
+	else if (c == '"' || c == '[' || c == '`') {
+	    q = memchr(p + 1, (c == '[') ? ']' : c, end - p - 1);
+	    p = (q != NULL) ? q + 1 : end;
+	}
+
+	/* Keywords, identifiers and bound variables */
+
+	else if (isalpha(c) || c == '_' || c >= 0x80
+		 || ((c == ':' || c == '$' || c == '@') && p + 1 < end
+		     && (isalnum((unsigned char) p[1]) || p[1] == '_'))) {
+	    ++p;
+	    while (p < end && (isalnum((unsigned char) *p) || *p == '_'
+			       || *p == '$' || (unsigned char) *p >= 0x80)) {
+		++p;
+	    }
+	    if (isalpha(c) && p - start < (int) sizeof(word)) {
+		for (i = 0; i < p - start; ++i) {
+		    word[i] = (char) toupper((unsigned char) start[i]);
+		}
+		word[i] = '\0';
+	    }
+	}
+
+	/* Anything else is a character by itself */
+
+	else {
+	    ++p;
+	}
+
+	/* Decide whether to replace a literal */
+
+	if (literal != 0) {
+	    liftable = (literal > 0 && !keepList && !keepNext
+			&& !(state[level] & (IN_SELECT_LIST | IN_TYPE_ARGS))
+			&& !((state[level] & IN_ORDER_BY)
+			     && (!strcmp(previous, "BY")
+				 || !strcmp(previous, ","))));
+	    if (liftable) {
+		if (resultPtr == NULL) {
+		    resultPtr = Tcl_NewObj();
+		}
+		Tcl_AppendToObj(resultPtr, copied, start - copied);
+		do {
+		    sprintf(name, "tdbc_%d", ++counter);
+		    for (found = 0, i = 0; i < paramc && !found; ++i) {
+			found = !strcmp(Tcl_GetString(paramv[i]), name);
+		    }
+		} while (found);
+		Tcl_AppendStringsToObj(resultPtr, ":", name, NULL);
+		if (c == '\'') {
+		    valuePtr = Tcl_NewObj();
+		    for (q = start + 1; q < p - 1; ++q) {
+			Tcl_AppendToObj(valuePtr, q, 1);
+			if (*q == '\'') {
+			    ++q;
+			}
+		    }
+		} else {
+		    valuePtr = Tcl_NewStringObj(start, p - start);
+		}
+		Tcl_DictObjPut(NULL, valuesPtr, Tcl_NewStringObj(name, -1),
+			       valuePtr);
+		copied = p;
+	    }
+	    strcpy(previous, "?");
+	    keepNext = 0;
+	    continue;
+	}
+
+	/* Track the clauses that keep literals inline */
+
+	if (word[0] != '\0') {
+	    if (!strcmp(word, "SELECT")) {
+		state[level] |= IN_SELECT_LIST;
+	    } else if (!strcmp(word, "FROM") || !strcmp(word, "INTO")) {
+		state[level] &= ~IN_SELECT_LIST;
+	    } else if (!strcmp(word, "BY")
+		       && (!strcmp(previous, "ORDER")
+			   || !strcmp(previous, "GROUP"))) {
+		state[level] |= IN_ORDER_BY;
+	    } else if (IsKeyword(word, orderByTerminators)) {
+		state[level] &= ~IN_ORDER_BY;
+	    }
+	    keepList = IsKeyword(word, inlineListIntroducers);
+	    keepNext = IsKeyword(word, typedLiteralIntroducers);
+	    strcpy(previous, word);
+	    continue;
+	}
+	if (c == '(') {
+	    ++depth;
+	    if (depth < MAX_PARAMETERIZE_DEPTH) {
+		state[depth] = (state[depth-1] & IN_SELECT_LIST)
+		    | (IsKeyword(previous, parameterizedTypes)
+		       ? IN_TYPE_ARGS : 0);
+	    }
+	} else if (c == ')') {
+	    if (depth > 0) {
+		--depth;
+	    }
+	} else if (c == ';') {
+	    depth = 0;
+	    state[0] = 0;
+	}
+	if (p - start != 1 || strchr(",+-()", c) == NULL || c == '\0') {
+	    keepList = 0;
+	}
+	keepNext = 0;
+	if (p - start == 1) {
+	    previous[0] = (char) c;
+	    previous[1] = '\0';
+	} else {
+	    previous[0] = '\0';
+	}
+    }
+    Tcl_DecrRefCount(classPtr);
+
+    if (resultPtr == NULL) {
+	return sqlObj;
+    }
+    Tcl_AppendToObj(resultPtr, copied, end - copied);
+    return resultPtr;
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * TdbcParameterizeObjCmd --
+ *
+ *	Tcl command to replace the literals in a SQL statement with bound
+ *	variables.
+ *
+ * Usage:
+ *	::tdbc::parameterize sqlcode
+ *
+ * Results:
+ *	Returns a two-element list of the rewritten SQL code and the
+ *	dictionary of the values of its new variables, as described for
+ *	ParameterizeSql.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+MODULE_SCOPE int
+TdbcParameterizeObjCmd(
+    ClientData clientData,	/* Unused */
+    Tcl_Interp* interp,		/* Tcl interpreter */
+    int objc,			/* Parameter count */
+    Tcl_Obj *const objv[]	/* Parameter vector */
+) {
+    Tcl_Obj* valuesPtr;
+    Tcl_Obj* resultv[2];
+
+    if (objc != 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "sqlcode");
+	return TCL_ERROR;
+    }
+    valuesPtr = Tcl_NewDictObj();
+    resultv[0] = ParameterizeSql(objv[1], valuesPtr);
+    resultv[1] = valuesPtr;
+    Tcl_SetObjResult(interp, Tcl_NewListObj(2, resultv));
+    return TCL_OK;
+}
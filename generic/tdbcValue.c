@@ -0,0 +1,182 @@
+/*
+ * tdbcValue.c --
+ *
+ *	Procedures that help drivers written in C to produce cell values
+ *	with native internal representations, for connections configured
+ *	with '-typed'.
+ *
+ * Copyright (c) 2026 by the TDBC contributors.
+ *
+ * Please refer to the file, 'license.terms' for the conditions on
+ * redistribution of this file and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+#include "tdbcInt.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_NewInt64Value --
+ *
+ *	Makes a cell value from a 64-bit integer.
+ *
+ * Results:
+ *	Returns an object whose internal representation is the integer,
+ *	with a reference count of zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_NewInt64Value(
+    Tcl_WideInt value		/* Value of the cell */
+) {
+    return Tcl_NewWideIntObj(value);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_NewDoubleValue --
+ *
+ *	Makes a cell value from a double-precision floating point number.
+ *
+ * Results:
+ *	Returns an object whose internal representation is the number,
+ *	with a reference count of zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_NewDoubleValue(
+    double value		/* Value of the cell */
+) {
+    return Tcl_NewDoubleObj(value);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_NewBytesValue --
+ *
+ *	Makes a cell value from a binary string, such as a BLOB.
+ *
+ * Results:
+ *	Returns a byte array object holding a copy of the bytes, with a
+ *	reference count of zero.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_NewBytesValue(
+    const unsigned char* bytes,	/* Contents of the cell */
+    int length			/* Number of bytes */
+) {
+    return Tcl_NewByteArrayObj(bytes, length);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_NewDecimalValue --
+ *
+ *	Makes a cell value from the text of an exact numeric (DECIMAL or
+ *	NUMERIC) value.
+ *
+ * Parameters:
+ *	digits -- Text of the number: an optional sign, digits, and an
+ *		  optional decimal point followed by more digits
+ *	length -- Length of the text in bytes, or -1 if it is
+ *		  NUL-terminated
+ *
+ * Results:
+ *	Returns an object with a reference count of zero. If the number
+ *	is an integer of at most 18 digits, the object's internal
+ *	representation is the integer. Otherwise, the object is a string
+ *	holding the text unchanged, so that no precision is lost to binary
+ *	floating point.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_NewDecimalValue(
+    const char* digits,		/* Text of the number */
+    int length			/* Length of the text */
+) {
+    Tcl_WideInt value = 0;	/* Value of an integer */
+    int negative = 0;		/* Flag == 1 if the number is negative */
+    int nDigits = 0;		/* Number of digits seen */
+    int i = 0;
+
+    if (length < 0) {
+	length = (int) strlen(digits);
+    }
+    if (i < length && (digits[i] == '-' || digits[i] == '+')) {
+	negative = (digits[i] == '-');
+	++i;
+    }
+
+    /*
+     * Accumulate the value as a negative number, whose range includes
+     * the most negative 64-bit integer. Up to 18 digits cannot overflow.
+     */
+
+    for (; i < length && digits[i] >= '0' && digits[i] <= '9'; ++i) {
+	if (++nDigits > 18) {
+	    return Tcl_NewStringObj(digits, length);
+	}
+	value = 10 * value - (digits[i] - '0');
+    }
+    if (nDigits == 0 || i < length) {
+	return Tcl_NewStringObj(digits, length);
+    }
+    return Tcl_NewWideIntObj(negative ? value : -value);
+}
+
+/*
+ *-----------------------------------------------------------------------------
+ *
+ * Tdbc_NewTimestampValue --
+ *
+ *	Makes a cell value from the fields of a date and time.
+ *
+ * Results:
+ *	Returns a string object with a reference count of zero, in the form
+ *	YYYY-MM-DD HH:MM:SS, followed by a decimal point and six digits of
+ *	microseconds if 'microseconds' is not zero. This is the form that
+ *	[clock scan -format {%Y-%m-%d %H:%M:%S}] accepts, and that drivers
+ *	accept as a bound value.
+ *
+ *-----------------------------------------------------------------------------
+ */
+
+TDBCAPI Tcl_Obj*
+Tdbc_NewTimestampValue(
+    int year,			/* Year */
+    int month,			/* Month, 1-12 */
+    int day,			/* Day of month, 1-31 */
+    int hour,			/* Hour, 0-23 */
+    int minute,			/* Minute, 0-59 */
+    int second,			/* Second, 0-60 */
+    int microseconds		/* Microseconds, 0-999999 */
+) {
+    char buffer[64];
+    int length;
+
+    if (microseconds != 0) {
+	length = sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d.%06d",
+			 year, month, day, hour, minute, second,
+			 microseconds);
+    } else {
+	length = sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d",
+			 year, month, day, hour, minute, second);
+    }
+    return Tcl_NewStringObj(buffer, length);
+}
@@ -16,6 +16,23 @@ package require TclOO
 namespace eval ::tdbc {
     namespace export connection statement resultset
     variable generalError [list TDBC GENERAL_ERROR HY000 {}]
+
+    # connectionOptions lists the options that the base classes accept
+    # in [$connection configure] on behalf of every driver, with their
+    # default values and the type of value that they accept.
+
+    variable connectionOptions {
+	-autoparameterize {default 0 type boolean}
+	-groupcommit	{default {} type options keys {-maxdelay -maxops}}
+	-maxmemory	{default 0 type count}
+	-maxresultsets	{default 0 type count}
+	-maxstatements	{default 0 type count}
+	-onlimit	{default error type choice values {close error}}
+	-querytimeout	{default 0 type count}
+	-resultcache	{default 0 type count}
+	-resultttl	{default 0 type count}
+	-typed		{default 0 type boolean}
+    }
 }
 
 #------------------------------------------------------------------------------
@@ -49,7 +66,7 @@ proc tdbc::ParseConvenienceArgs {argv optsVar} {
     # Munch keyword options off the front of the command arguments
     
     foreach {key value} $argv {
-	if {[string index $key 0] eq {-}} {
+	if {[string match -* $key]} {
 	    switch -regexp -- $key {
 		-as? {
 		    if {$value ne {dicts} && $value ne {lists}} {
@@ -62,9 +79,49 @@ proc tdbc::ParseConvenienceArgs {argv optsVar} {
 		    }
 		    dict set opts -as $value
 		}
+		^-columnvars$ {
+		    if {![string is boolean -strict $value]} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $key $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$key\""
+		    }
+		    if {$value} {
+			dict set opts -columnvars 1
+		    } else {
+			dict unset opts -columnvars
+		    }
+		}
 		-c(?:o(?:l(?:u(?:m(?:n(?:s(?:v(?:a(?:r(?:i(?:a(?:b(?:le?)?)?)?)?)?)?)?)?)?)?)?)?) {
 		    dict set opts -columnsvariable $value
 		}
+		^-intern$ {
+		    if {![string is list $value]} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $key $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$key\""
+		    }
+		    dict set opts -intern $value
+		}
+		^-timeout$ {
+		    if {![string is entier -strict $value] || $value < 0} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $key $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$key\""
+		    }
+		    dict set opts -timeout $value
+		}
+		^-variables$ {
+		    if {![string is list $value]} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $key $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$key\""
+		    }
+		    dict set opts -variables $value
+		}
 		-- {
 		    incr i
 		    break
@@ -75,7 +132,8 @@ proc tdbc::ParseConvenienceArgs {argv optsVar} {
 		    return -code error \
 			-errorcode $errorcode \
 			"bad option \"$key\":\
-                             must be -as or -columnsvariable"
+                             must be -as, -columnsvariable, -columnvars,\
+                             -intern, -timeout or -variables"
 		}
 	    }
 	} else {
@@ -88,8 +146,181 @@ proc tdbc::ParseConvenienceArgs {argv optsVar} {
     
 }
 
+#------------------------------------------------------------------------------
+#
+# tdbc::CheckRowOptions --
+#
+#	Rejects the options that store the cells of rows in variables,
+#	which only 'foreach' accepts, in the options of 'allrows'.
+#
+# Parameters:
+#	opts - Options returned by 'ParseConvenienceArgs'
+#
+# Results:
+#	None.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::CheckRowOptions {opts} {
+    variable generalError
+    foreach option {-columnvars -variables} {
+	if {[dict exists $opts $option]} {
+	    set errorcode $generalError
+	    lappend errorcode badOption $option
+	    return -code error -errorcode $errorcode \
+		"option \"$option\" can be used only with \"foreach\""
+	}
+    }
+    return
+}
+
 
 
+#------------------------------------------------------------------------------
+#
+# tdbc::IsTransactionRollback --
+#
+#	Determines whether an error code reports that the database rolled
+#	back a transaction because of a serialization failure or deadlock.
+#
+# Parameters:
+#	errorcode - Error code from a TDBC driver, of the form
+#		    {TDBC errorClass sqlstate driverName ...}
+#
+# Results:
+#	Returns 1 if the SQLSTATE is in the TRANSACTION_ROLLBACK class,
+#	0 otherwise.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::IsTransactionRollback {errorcode} {
+    if {[lindex $errorcode 0] ne {TDBC}} {
+	return 0
+    }
+    return [expr {[lindex $errorcode 1] eq {TRANSACTION_ROLLBACK}
+		  || [mapSqlState [lindex $errorcode 2]] 
+		         eq {TRANSACTION_ROLLBACK}}]
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::CallSite --
+#
+#	Describes where the application called into TDBC.
+#
+# Results:
+#	Returns the file name and line number of the innermost frame on
+#	the call stack that does not belong to a method of a TDBC class,
+#	or the first line of its command if it was not read from a file.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::CallSite {} {
+    for {set level [expr {[info frame] - 1}]} {$level > 0} {incr level -1} {
+	set frame [info frame $level]
+	if {[dict exists $frame class]
+	    && [string match ::tdbc::* [dict get $frame class]]} {
+	    continue
+	}
+	if {[dict exists $frame file]} {
+	    return [dict get $frame file]:[dict get $frame line]
+	}
+	return [string range [lindex [split [dict get $frame cmd] \n] 0] 0 59]
+    }
+    return {}
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::ObjectMemory --
+#
+#	Estimates the memory held in the variables of an object.
+#
+# Parameters:
+#	object - Object to examine
+#
+# Results:
+#	Returns the estimated number of bytes.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::ObjectMemory {object} {
+    set bytes 0
+    foreach var [info vars [info object namespace $object]::*] {
+	if {[array exists $var]} {
+	    incr bytes [SizeOf [array get $var]]
+	} elseif {[info exists $var]} {
+	    incr bytes [SizeOf [set $var]]
+	}
+    }
+    return $bytes
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::MemoryLimitError --
+#
+#	Reports that a fetch has exceeded the -maxmemory budget of its
+#	connection.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::MemoryLimitError {} {
+    return -code error -level 2 \
+	-errorcode {TDBC INSUFFICIENT_RESOURCES 53200 {} maxmemory} \
+	"result exceeds the memory budget of the connection"
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::QueryCanceledError --
+#
+#	Reports that a query was canceled, either because it overran its
+#	timeout or because the application asked.
+#
+# Parameters:
+#	reason - 'timeout' or 'cancel'
+#	timeout - Timeout of the query, in milliseconds
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::QueryCanceledError {reason timeout} {
+    if {$reason eq {timeout}} {
+	set message "query exceeded its timeout of $timeout ms"
+    } else {
+	set message "query was canceled"
+    }
+    set errorcode [list TDBC RESOURCE_NOT_AVAILABLE_OR_OPERATOR_INTERVENTION \
+		       57014 {} QUERY_CANCELED]
+    return -code error -level 2 -errorcode $errorcode $message
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::memstats --
+#
+#	Reports the memory held by each TDBC connection in the interpreter.
+#
+# Results:
+#	Returns a dictionary whose keys are the connections and whose
+#	values are the estimated number of bytes that each holds, as
+#	reported in the 'total' key of its 'memory' method.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::memstats {} {
+    set result {}
+    set classes [list ::tdbc::connection]
+    while {[llength $classes] > 0} {
+	set classes [lassign $classes class]
+	lappend classes {*}[info class subclasses $class]
+	foreach object [info class instances $class] {
+	    dict set result $object [dict get [$object memory] total]
+	}
+    }
+    return $result
+}
+
 #------------------------------------------------------------------------------
 #
 # tdbc::connection --
@@ -105,8 +336,60 @@ oo::class create ::tdbc::connection {
     #	'statement' API.
     # primaryKeysStatement is the statement that queries primary keys
     # foreignKeysStatement is the statement that queries foreign keys
-
-    variable statementSeq primaryKeysStatement foreignKeysStatement
+    # frameworkOptions is a dictionary of the values of the options
+    #	that the base class handles in 'configure'
+    # inTransaction is 1 if a transaction is in progress
+    # resultCache is a dictionary of cached results, in order from
+    #	least to most recently used, whose keys are lists of the
+    #	'-as' option, the SQL code and the dictionary of bound values,
+    #	and whose values are lists of the expiry time, the tables read,
+    #	the column names, the rows and the estimated size of the entry.
+    # resultCacheBytes is the estimated size of the entries in the result
+    #	cache.
+    # resultCacheStats is a dictionary of counts of cache hits, misses,
+    #	evictions and invalidations
+    # transactionStats is a dictionary of counts of transactions run by
+    #	the 'transaction' method, their rollbacks and their retries
+    # groupCommit is a dictionary describing the state of group commit:
+    #	open - 1 if the group's physical transaction has begun
+    #	running - Coroutine whose transaction script is running
+    #	queue - Coroutines waiting to run their scripts
+    #	members - Coroutines waiting for the group to commit
+    #	timer - Event that will commit the group
+    #	expired - 1 if the group should commit when 'running' finishes
+    # hasConstraintCatalogs is 1 if INFORMATION_SCHEMA supplies
+    #	CONSTRAINT_CATALOG
+    # schemaSnapshot is the snapshot of the schema returned by 'schema',
+    #	if one has been loaded
+    # openStatements is a dictionary whose keys are the statements
+    #	prepared on the connection that are still open, in order from
+    #	least to most recently executed when -maxstatements is set, and
+    #	whose values are lists of the creation time and call site.
+    # openResultSets is a dictionary whose keys are the open result sets,
+    #	in order of creation, and whose values are lists of the creation
+    #	time, call site, statement and timeout handle (see 'watches').
+    # pipeline is a dictionary describing the state of 'pipeline':
+    #	depth - Number of 'pipeline' scripts that are running
+    #	flushing - 1 while the queued statements are being executed
+    #	queue - List of the queued statements, each a list of the
+    #		future, the '-as' option, the SQL code and the
+    #		dictionary of bound values
+    # futureSeq is the sequence number of the last future created.
+    # watches is a dictionary whose keys are the handles of the timeouts
+    #	of executions that are running, and whose values are lists of
+    #	the kind of timer ('watchdog' or 'after'), its token, 1 if it
+    #	has fired, the deadline in milliseconds, and the timeout.
+    # watchSeq is the sequence number of the last timeout handle.
+    # memoryCharged is the number of bytes charged against -maxmemory
+    #	by materialized result sets and by fetches that are gathering
+    #	rows, kept as a running total so that the budget is checked
+    #	without measuring every open object.
+
+    variable statementSeq primaryKeysStatement foreignKeysStatement \
+	frameworkOptions inTransaction \
+	resultCache resultCacheBytes resultCacheStats transactionStats \
+	groupCommit hasConstraintCatalogs schemaSnapshot openStatements \
+	openResultSets pipeline futureSeq watches watchSeq memoryCharged
 
     # The base class constructor accepts no arguments.  It sets up the
     # machinery to do the bookkeeping to keep track of what statements
@@ -117,7 +400,30 @@ oo::class create ::tdbc::connection {
 
     constructor {} {
 	set statementSeq 0
+	set frameworkOptions {}
+	dict for {option spec} $::tdbc::connectionOptions {
+	    dict set frameworkOptions $option [dict get $spec default]
+	}
+	set inTransaction 0
+	set resultCache {}
+	set resultCacheBytes 0
+	set memoryCharged 0
+	set resultCacheStats \
+	    [dict create hits 0 misses 0 evictions 0 invalidations 0]
+	set transactionStats \
+	    [dict create transactions 0 rollbacks 0 retries 0 exhausted 0]
+	set groupCommit [dict create open 0 running {} queue {} members {} \
+			     timer {} expired 0]
+	set openStatements {}
+	set openResultSets {}
+	set pipeline [dict create depth 0 flushing 0 queue {}]
+	set futureSeq 0
+	set watches {}
+	set watchSeq 0
 	namespace eval Stmt {}
+	namespace eval Future {}
+	oo::objdefine [self] mixin {*}[info object mixins [self]] \
+	    ::tdbc::ConnectionHooks
     }
 
     # The 'close' method is simply an alternative syntax for destroying
@@ -130,10 +436,29 @@ oo::class create ::tdbc::connection {
     # The 'prepare' method creates a new statement against the connection,
     # giving its constructor the current statement and the SQL code to
     # prepare.  It uses the 'statementClass' variable set by the constructor
-    # to get the class to instantiate.
+    # to get the class to instantiate. With '-autoparameterize', the
+    # literals in the SQL code are replaced by bound variables, whose
+    # values the statement binds on every execution.
 
     method prepare {sqlcode} {
-	return [my statementCreate Stmt::[incr statementSeq] [self] $sqlcode]
+	set limit [dict get $frameworkOptions -maxstatements]
+	if {$limit > 0} {
+	    my EnforceLimit statements $limit
+	}
+	set literals {}
+	if {[dict get $frameworkOptions -autoparameterize]} {
+	    lassign [::tdbc::parameterize $sqlcode] sqlcode literals
+	}
+	set stmt [my statementCreate Stmt::[incr statementSeq] [self] $sqlcode]
+	if {[info object isa typeof $stmt ::tdbc::statement]} {
+	    [info object namespace $stmt]::my Attach \
+		[namespace which my] $sqlcode $literals
+	}
+	set stmt [namespace which $stmt]
+	dict set openStatements $stmt \
+	    [list [clock milliseconds] [::tdbc::CallSite]]
+	trace add command $stmt delete [list [namespace which my] Unregister]
+	return $stmt
     }
 
     # The 'statementCreate' method delegates to the constructor
@@ -154,421 +479,614 @@ oo::class create ::tdbc::connection {
     # connection.
 
     method statements {} {
-	info commands Stmt::*
+	dict keys $openStatements
     }
 
     # The 'resultsets' method lists the result sets active against this
     # connection.
 
     method resultsets {} {
-	set retval {}
-	foreach statement [my statements] {
-	    foreach resultset [$statement resultsets] {
-		lappend retval $resultset
-	    }
-	}
-	return $retval
+	dict keys $openResultSets
     }
 
-    # The 'transaction' method executes a block of Tcl code as an
-    # ACID transaction against the database.
-
-    method transaction {script} {
-	my begintransaction
-	set status [catch {uplevel 1 $script} result options]
-	if {$status in {0 2 3 4}} {
-	    set status2 [catch {my commit} result2 options2]
-	    if {$status2 == 1} {
-		set status 1
-		set result $result2
-		set options $options2
+    # The 'openobjects' method reports the statements and result sets
+    # that are open on the connection, oldest first, to help find the
+    # ones that an application has forgotten to close. The result is a
+    # list of dictionaries with the keys 'object', 'kind' ('statement' or
+    # 'resultset'), 'age' (in milliseconds) and 'site' (where the object
+    # was created). If 'count' is given, only the oldest 'count' objects
+    # are reported.
+
+    method openobjects {{count -1}} {
+	set now [clock milliseconds]
+	set result {}
+	foreach {kind registry} [list statement $openStatements \
+				     resultset $openResultSets] {
+	    dict for {object entry} $registry {
+		lassign $entry created site
+		lappend result [list $created \
+				    [dict create object $object kind $kind \
+					 age [expr {$now - $created}] \
+					 site $site]]
 	    }
 	}
-	switch -exact -- $status {
-	    0 {
-		# do nothing
-	    }
-	    2 - 3 - 4 {
-		set options [dict merge {-level 1} $options[set options {}]]
-		dict incr options -level
-	    }
-	    default {
-		my rollback
-	    }
+	set result [lsort -integer -index 0 $result]
+	if {$count >= 0} {
+	    set result [lrange $result 0 [expr {$count - 1}]]
 	}
-	return -options $options $result
+	return [lmap entry $result {lindex $entry 1}]
     }
 
-    # The 'allrows' method prepares a statement, then executes it with
-    # a given set of substituents, returning a list of all the rows
-    # that the statement returns. Optionally, it stores the names of
-    # the columns in '-columnsvariable'.
-    # Usage:
-    #     $db allrows ?-as lists|dicts? ?-columnsvariable varName? ?--?
-    #	      sql ?dictionary?
-
-    method allrows args {
+    # The 'EnforceLimit' method is called before a statement or result
+    # set is created, when the -maxstatements or -maxresultsets option
+    # limits how many may be open. If the limit has been reached, it
+    # either closes the least recently used objects or throws an error,
+    # according to the -onlimit option.
 
+    method EnforceLimit {kind limit} {
 	variable ::tdbc::generalError
+	if {$kind eq {statements}} {
+	    upvar 0 openStatements registry
+	    set detail statementLimit
+	} else {
+	    upvar 0 openResultSets registry
+	    set detail resultSetLimit
+	}
+	while {[dict size $registry] >= $limit} {
+	    dict for {object entry} $registry break
+	    if {[dict get $frameworkOptions -onlimit] eq {error}} {
+		set errorcode $generalError
+		lappend errorcode $detail $limit
+		return -code error -errorcode $errorcode \
+		    "too many open $kind (limit $limit): the oldest is\
+                     $object, created at [lindex $entry 1]"
+	    }
+	    catch {$object close}
+	    dict unset registry $object
+	}
+    }
 
-	# Grab keyword-value parameters
+    # The 'StatementExecuting' method is called by a statement before it
+    # executes, with the statement's classification from tdbc::classify.
+    # 'resultSet' is 0 if the execution will not create a result set. It
+    # returns the default timeout of the execution, in milliseconds.
 
-	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+    method StatementExecuting {stmt sqlClass {resultSet 1}} {
+	if {[dict get $frameworkOptions -maxstatements] > 0
+	    && [dict exists $openStatements $stmt]} {
 
-	# Check postitional parameters 
+	    # Move the statement to the most recently used position
 
-	set cmd [list [self] prepare]
-	if {[llength $args] == 1} {
-	    set sqlcode [lindex $args 0]
-	} elseif {[llength $args] == 2} {
-	    lassign $args sqlcode dict
-	} else {
-	    set errorcode $generalError
-	    lappend errorcode wrongNumArgs
-	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? sqlcode ?dictionary?"
+	    set entry [dict get $openStatements $stmt]
+	    dict unset openStatements $stmt
+	    dict set openStatements $stmt $entry
 	}
-	lappend cmd $sqlcode
+	set limit [dict get $frameworkOptions -maxresultsets]
+	if {$limit > 0 && $resultSet} {
+	    my EnforceLimit resultsets $limit
+	}
+	if {![dict get $sqlClass readonly]} {
+	    my StatementWrites $sqlClass
+	}
+	return [dict get $frameworkOptions -querytimeout]
+    }
 
-	# Prepare the statement
+    # The 'QueryTimeout' method returns the default timeout of an
+    # execution, in milliseconds, for a statement that must choose how to
+    # execute before it calls 'StatementExecuting'.
 
-	set stmt [uplevel 1 $cmd]
+    method QueryTimeout {} {
+	return [dict get $frameworkOptions -querytimeout]
+    }
 
-	# Delegate to the statement to accumulate the results
+    # The 'RegisterResultSet' method is called by a statement when it
+    # has created a result set. 'watch' is the handle of the execution's
+    # timeout, if it has one, which stays armed until the result set is
+    # closed. Under -maxmemory, a result set is given the connection to
+    # charge for the rows that 'allrows' gathers, and a materialized
+    # result set is charged for its rows until it is destroyed.
+
+    method RegisterResultSet {stmt resultSet {watch {}}} {
+	set resultSet [namespace which $resultSet]
+	set charged 0
+	if {[dict get $frameworkOptions -maxmemory] > 0} {
+	    if {[info object isa typeof $resultSet ::tdbc::resultset]} {
+		[info object namespace $resultSet]::my MemoryAccount \
+		    [namespace which my]
+	    } elseif {![catch {$resultSet memory} charged]} {
+		incr memoryCharged $charged
+	    } else {
+		set charged 0
+	    }
+	}
+	dict set openResultSets $resultSet \
+	    [list [clock milliseconds] [::tdbc::CallSite] $stmt $watch \
+		 $charged]
+	trace add command $resultSet delete \
+	    [list [namespace which my] Unregister]
+	if {$watch ne {}} {
+	    if {[info object isa typeof $resultSet ::tdbc::resultset]} {
+		[info object namespace $resultSet]::my Watch \
+		    [namespace which my] $watch \
+		    {*}[lrange [dict get $watches $watch] 3 4]
+	    }
+	}
+	return $resultSet
+    }
 
-	set cmd [list $stmt allrows {*}$opts --]
-	if {[info exists dict]} {
-	    lappend cmd $dict
+    # The 'memory' method reports an estimate of the memory held on
+    # behalf of the connection. The result is a dictionary with the keys
+    # 'statements' and 'resultsets', whose values are dictionaries
+    # mapping the open statements and result sets to the number of
+    # bytes that each holds, 'resultcache', the number of bytes of cached
+    # results, and 'total'.
+
+    method memory {} {
+	set total 0
+	set result {}
+	foreach {key registry} [list statements $openStatements \
+				    resultsets $openResultSets] {
+	    set sizes {}
+	    foreach object [dict keys $registry] {
+		if {[catch {$object memory} bytes]} {
+		    set bytes 0
+		}
+		dict set sizes $object $bytes
+		incr total $bytes
+	    }
+	    dict set result $key $sizes
 	}
-	set status [catch {
-	    uplevel 1 $cmd
-	} result options]
+	set bytes [::tdbc::SizeOf $resultCache]
+	dict set result resultcache $bytes
+	dict set result total [incr total $bytes]
+	return $result
+    }
 
-	# Destroy the statement
+    # The 'MemoryBudget' method returns the number of bytes that a fetch
+    # may still use under the -maxmemory option, or 0 if there is no
+    # limit. If the connection is already over its budget, the result
+    # cache is discarded to make room.
 
-	catch {
-	    $stmt close
+    method MemoryBudget {} {
+	set limit [dict get $frameworkOptions -maxmemory]
+	if {$limit <= 0} {
+	    return 0
+	}
+	if {$memoryCharged + $resultCacheBytes >= $limit} {
+	    my MemoryReclaim
 	}
+	set used [expr {$memoryCharged + $resultCacheBytes}]
+	return [expr {$used < $limit ? $limit - $used : 1}]
+    }
 
-	return -options $options $result
+    # The 'MemoryCharge' method adds 'bytes' to the memory charged
+    # against the -maxmemory option. If the charge would exceed the
+    # limit even without the result cache, it is refused and an error
+    # is thrown.
+
+    method MemoryCharge {bytes} {
+	incr memoryCharged $bytes
+	set limit [dict get $frameworkOptions -maxmemory]
+	if {$limit > 0 && $memoryCharged + $resultCacheBytes > $limit} {
+	    my MemoryReclaim
+	    if {$memoryCharged > $limit} {
+		incr memoryCharged [expr {-$bytes}]
+		::tdbc::MemoryLimitError
+	    }
+	}
+	return
     }
 
-    # The 'foreach' method prepares a statement, then executes it with
-    # a supplied set of substituents.  For each row of the result,
-    # it sets a variable to the row and invokes a script in the caller's
-    # scope.
-    #
-    # Usage: 
-    #     $db foreach ?-as lists|dicts? ?-columnsVariable varName? ?--?
-    #         varName sql ?dictionary? script
+    # The 'MemoryRelease' method returns 'bytes' charged by
+    # 'MemoryCharge' to the budget.
 
-    method foreach args {
+    method MemoryRelease {bytes} {
+	incr memoryCharged [expr {-$bytes}]
+	return
+    }
 
-	variable ::tdbc::generalError
+    # The 'MemoryReclaim' method discards the result cache to make room
+    # under the -maxmemory option.
 
-	# Grab keyword-value parameters
+    method MemoryReclaim {} {
+	if {[dict size $resultCache] > 0} {
+	    dict incr resultCacheStats evictions [dict size $resultCache]
+	    set resultCache {}
+	    set resultCacheBytes 0
+	}
+    }
 
-	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+    # The 'Unregister' method is called from a command trace when a
+    # statement or result set is destroyed.
 
-	# Check postitional parameters 
+    method Unregister {object args} {
+	dict unset openStatements $object
+	if {[dict exists $openResultSets $object]} {
+	    lassign [dict get $openResultSets $object] - - - watch charged
+	    if {$watch ne {}} {
+		my Disarm $watch
+	    }
+	    incr memoryCharged [expr {-$charged}]
+	    dict unset openResultSets $object
+	}
+    }
 
-	set cmd [list [self] prepare]
-	if {[llength $args] == 3} {
-	    lassign $args varname sqlcode script
-	} elseif {[llength $args] == 4} {
-	    lassign $args varname sqlcode dict script
+    # The 'Arm' method starts the timeout of an execution, and returns a
+    # handle for it. If the driver has registered a cancel procedure with
+    # Tdbc_SetCancelProc, the watchdog thread calls it when the timeout
+    # expires. Otherwise, an event calls the 'Expire' method, which can
+    # run only if the driver enters the event loop while it waits.
+
+    method Arm {timeout} {
+	set watch [incr watchSeq]
+	set deadline [expr {[clock milliseconds] + $timeout}]
+	set token [::tdbc::Watchdog arm [self] $timeout]
+	if {$token ne {}} {
+	    set kind watchdog
 	} else {
-	    set errorcode $generalError
-	    lappend errorcode wrongNumArgs
-	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? varname sqlcode ?dictionary? script"
+	    set kind after
+	    set token [after $timeout [list [namespace which my] Expire $watch]]
 	}
-	lappend cmd $sqlcode
+	dict set watches $watch [list $kind $token 0 $deadline $timeout]
+	return $watch
+    }
 
-	# Prepare the statement
+    # The 'Expire' method is called when the timeout of an execution
+    # expires without the watchdog thread. It cancels the query.
 
-	set stmt [uplevel 1 $cmd]
+    method Expire {watch} {
+	if {[dict exists $watches $watch]} {
+	    dict set watches $watch [lreplace [dict get $watches $watch] 2 2 1]
+	    my CancelQuery
+	}
+    }
 
-	# Delegate to the statement to iterate over the results
+    # The 'Fired' method returns 1 if the timeout with the given handle
+    # has expired and canceled the query, and 0 otherwise.
 
-	set cmd [list $stmt foreach {*}$opts -- $varname]
-	if {[info exists dict]} {
-	    lappend cmd $dict
+    method Fired {watch} {
+	if {![dict exists $watches $watch]} {
+	    return 0
 	}
-	lappend cmd $script
-	set status [catch {
-	    uplevel 1 $cmd
-	} result options]
+	lassign [dict get $watches $watch] kind token fired
+	if {$kind eq {watchdog}} {
+	    return [::tdbc::Watchdog fired $token]
+	}
+	return $fired
+    }
 
-	# Destroy the statement
+    # The 'Disarm' method stops the timeout with the given handle, and
+    # returns whether it had fired.
 
-	catch {
-	    $stmt close
+    method Disarm {watch} {
+	if {![dict exists $watches $watch]} {
+	    return 0
+	}
+	lassign [dict get $watches $watch] kind token fired
+	dict unset watches $watch
+	if {$kind eq {watchdog}} {
+	    return [::tdbc::Watchdog disarm $token]
 	}
+	after cancel $token
+	return $fired
+    }
 
-	# Adjust return level in the case that the script [return]s
+    # The 'CancelQuery' method asks the driver to cancel the query that
+    # is running on the connection, through the cancel procedure that it
+    # registered with Tdbc_SetCancelProc or its 'cancelQuery' method.
 
-	if {$status == 2} {
-	    set options [dict merge {-level 1} $options[set options {}]]
-	    dict incr options -level
+    method CancelQuery {} {
+	if {![::tdbc::Watchdog cancel [self]]
+	    && {cancelQuery} in [info object methods [self] -all]} {
+	    my cancelQuery
 	}
-	return -options $options $result
     }
 
-    # The 'BuildPrimaryKeysStatement' method builds a SQL statement to
-    # retrieve the primary keys from a database. (It executes once the
-    # first time the 'primaryKeys' method is executed, and retains the
-    # prepared statement for reuse.)
-
-    method BuildPrimaryKeysStatement {} {
+    # Drivers written in Tcl may implement a 'cancelQuery' method, which
+    # abandons the query that the connection is waiting for. It is called
+    # from the event loop, so it can take effect only if the driver waits
+    # for the database with 'vwait' or in a coroutine.
 
-	# On some databases, CONSTRAINT_CATALOG is always NULL and
-	# JOINing to it fails. Check for this case and include that
-	# JOIN only if catalog names are supplied.
+    # The 'cancel' method cancels the queries of the connection: it asks
+    # the driver to abandon the statement that is running, and makes the
+    # result sets that are open report QUERY_CANCELED when they are next
+    # read.
 
-	set catalogClause {}
-	if {[lindex [set count [my allrows -as lists {
-	    SELECT COUNT(*) 
-            FROM INFORMATION_SCHEMA.TABLE_CONSTRAINTS
-            WHERE CONSTRAINT_CATALOG IS NOT NULL}]] 0 0] != 0} {
-	    set catalogClause \
-		{AND xtable.CONSTRAINT_CATALOG = xcolumn.CONSTRAINT_CATALOG}
+    method cancel {} {
+	foreach resultSet [dict keys $openResultSets] {
+	    if {[info object isa typeof $resultSet ::tdbc::resultset]} {
+		[info object namespace $resultSet]::my Canceled
+	    }
 	}
-	set primaryKeysStatement [my prepare "
-	     SELECT xtable.TABLE_SCHEMA AS \"tableSchema\", 
-                 xtable.TABLE_NAME AS \"tableName\",
-                 xtable.CONSTRAINT_CATALOG AS \"constraintCatalog\", 
-                 xtable.CONSTRAINT_SCHEMA AS \"constraintSchema\", 
-                 xtable.CONSTRAINT_NAME AS \"constraintName\", 
-                 xcolumn.COLUMN_NAME AS \"columnName\", 
-                 xcolumn.ORDINAL_POSITION AS \"ordinalPosition\" 
-             FROM INFORMATION_SCHEMA.TABLE_CONSTRAINTS xtable 
-             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE xcolumn 
-                     ON xtable.CONSTRAINT_SCHEMA = xcolumn.CONSTRAINT_SCHEMA 
-                    AND xtable.TABLE_NAME = xcolumn.TABLE_NAME
-                    AND xtable.CONSTRAINT_NAME = xcolumn.CONSTRAINT_NAME 
-	            $catalogClause
-             WHERE xtable.TABLE_NAME = :tableName 
-               AND xtable.CONSTRAINT_TYPE = 'PRIMARY KEY'
-  	"]
+	my CancelQuery
+	return
     }
 
-    # The default implementation of the 'primarykeys' method uses the
-    # SQL INFORMATION_SCHEMA to retrieve primary key information. Databases
-    # that might not have INFORMATION_SCHEMA must overload this method.
-
-    method primarykeys {tableName} {
-	if {![info exists primaryKeysStatement]} {
-	    my BuildPrimaryKeysStatement
-	}
-	tailcall $primaryKeysStatement allrows [list tableName $tableName]
-    }
+    # The 'transaction' method executes a block of Tcl code as an
+    # ACID transaction against the database.
+    #
+    # Usage:
+    #     $db transaction ?-retry n? ?-backoff ms? ?-maxbackoff ms?
+    #         ?-onretry cmdPrefix? script
+    #
+    # If the script or the commit fails with a serialization failure or
+    # deadlock (an error whose SQLSTATE is in class 40, TRANSACTION
+    # ROLLBACK), the transaction is rolled back and the script is run
+    # again, up to 'n' more times. Successive retries wait for an
+    # exponentially increasing, randomly jittered delay, starting at
+    # '-backoff' milliseconds and capped at '-maxbackoff'. Before each
+    # retry, the '-onretry' command prefix, if any, is called with the
+    # attempt number, the delay and the error code.
 
-    # The 'BuildForeignKeysStatements' method builds a SQL statement to
-    # retrieve the foreign keys from a database. (It executes once the
-    # first time the 'foreignKeys' method is executed, and retains the
-    # prepared statements for reuse.)
+    method transaction args {
 
-    method BuildForeignKeysStatement {} {
+	variable ::tdbc::generalError
 
-	# On some databases, CONSTRAINT_CATALOG is always NULL and
-	# JOINing to it fails. Check for this case and include that
-	# JOIN only if catalog names are supplied.
+	# Parse the options
 
-	set catalogClause1 {}
-	set catalogClause2 {}
-	if {[lindex [set count [my allrows -as lists {
-	    SELECT COUNT(*) 
-            FROM INFORMATION_SCHEMA.TABLE_CONSTRAINTS
-            WHERE CONSTRAINT_CATALOG IS NOT NULL}]] 0 0] != 0} {
-	    set catalogClause1 \
-		{AND fkc.CONSTRAINT_CATALOG = rc.CONSTRAINT_CATALOG}
-	    set catalogClause2 \
-		{AND pkc.CONSTRAINT_CATALOG = rc.CONSTRAINT_CATALOG}
+	if {[llength $args] % 2 != 1} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... script"
 	}
-
-	foreach {exists1 clause1} {
-	    0 {}
-	    1 { AND pkc.TABLE_NAME = :primary}
-	} {
-	    foreach {exists2 clause2} {
-		0 {}
-		1 { AND fkc.TABLE_NAME = :foreign}
-	    } {
-		set stmt [my prepare "
-	     SELECT rc.CONSTRAINT_CATALOG AS \"foreignConstraintCatalog\",
-                    rc.CONSTRAINT_SCHEMA AS \"foreignConstraintSchema\",
-                    rc.CONSTRAINT_NAME AS \"foreignConstraintName\",
-                    rc.UNIQUE_CONSTRAINT_CATALOG 
-                        AS \"primaryConstraintCatalog\",
-                    rc.UNIQUE_CONSTRAINT_SCHEMA AS \"primaryConstraintSchema\",
-                    rc.UNIQUE_CONSTRAINT_NAME AS \"primaryConstraintName\",
-                    rc.UPDATE_RULE AS \"updateAction\",
-		    rc.DELETE_RULE AS \"deleteAction\",
-                    pkc.TABLE_CATALOG AS \"primaryCatalog\",
-                    pkc.TABLE_SCHEMA AS \"primarySchema\",
-                    pkc.TABLE_NAME AS \"primaryTable\",
-                    pkc.COLUMN_NAME AS \"primaryColumn\",
-                    fkc.TABLE_CATALOG AS \"foreignCatalog\",
-                    fkc.TABLE_SCHEMA AS \"foreignSchema\",
-                    fkc.TABLE_NAME AS \"foreignTable\",
-                    fkc.COLUMN_NAME AS \"foreignColumn\",
-                    pkc.ORDINAL_POSITION AS \"ordinalPosition\"
-             FROM INFORMATION_SCHEMA.REFERENTIAL_CONSTRAINTS rc
-             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE fkc
-                     ON fkc.CONSTRAINT_NAME = rc.CONSTRAINT_NAME
-                    AND fkc.CONSTRAINT_SCHEMA = rc.CONSTRAINT_SCHEMA
-                    $catalogClause1
-             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE pkc
-                     ON pkc.CONSTRAINT_NAME = rc.UNIQUE_CONSTRAINT_NAME
-                     AND pkc.CONSTRAINT_SCHEMA = rc.UNIQUE_CONSTRAINT_SCHEMA
-                     $catalogClause2
-                     AND pkc.ORDINAL_POSITION = fkc.ORDINAL_POSITION
-             WHERE 1=1
-                 $clause1
-                 $clause2
-"]
-		dict set foreignKeysStatement $exists1 $exists2 $stmt
+	set script [lindex $args end]
+	set retry 0
+	set backoff 10
+	set maxbackoff 5000
+	set onretry {}
+	foreach {key value} [lrange $args 0 end-1] {
+	    switch -exact -- $key {
+		-retry - -backoff - -maxbackoff {
+		    if {![string is entier -strict $value] || $value < 0} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $key $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$key\""
+		    }
+		    set [string range $key 1 end] $value
+		}
+		-onretry {
+		    set onretry $value
+		}
+		default {
+		    set errorcode $generalError
+		    lappend errorcode badOption $key
+		    return -code error -errorcode $errorcode \
+			"bad option \"$key\": must be -backoff,\
+                         -maxbackoff, -onretry or -retry"
+		}
 	    }
 	}
-    }
 
-    # The default implementation of the 'foreignkeys' method uses the
-    # SQL INFORMATION_SCHEMA to retrieve primary key information. Databases
-    # that might not have INFORMATION_SCHEMA must overload this method.
+	# In group commit mode, a transaction requested from a coroutine
+	# shares a physical transaction with the others that arrive within
+	# the group's time window.
 
-    method foreignkeys {args} {
+	if {$retry == 0 && [dict get $frameworkOptions -groupcommit] ne {}} {
+	    if {[info coroutine] ne {}
+		&& [info coroutine] ne [dict get $groupCommit running]
+		&& ($inTransaction == 0 || [dict get $groupCommit open])} {
+		set status [catch {
+		    uplevel 1 [list [namespace which my] GroupMember $script]
+		} result options]
+		if {$status == 0} {
+		    return $result
+		} elseif {$status == 2} {
+		    set options [dict merge {-level 1} $options[set options {}]]
+		    dict incr options -level
+		}
+		return -options $options $result
+	    } elseif {[dict get $groupCommit open]
+		      && [dict get $groupCommit running] eq {}} {
+		my GroupCommitFlush
+	    }
+	}
 
-	variable ::tdbc::generalError
+	# Run the script, retrying it on serialization failures
+
+	for {set attempt 1} {1} {incr attempt} {
+	    dict incr transactionStats transactions
+	    my begintransaction
+	    set status [catch {uplevel 1 $script} result options]
+	    if {$status in {0 2 3 4}} {
+		set status2 [catch {my commit} result2 options2]
+		if {$status2 == 1} {
+		    set status 1
+		    set result $result2
+		    set options $options2
+		}
+	    }
+	    switch -exact -- $status {
+		0 {
+		    # do nothing
+		}
+		2 - 3 - 4 {
+		    set options \
+			[dict merge {-level 1} $options[set options {}]]
+		    dict incr options -level
+		}
+		default {
+		    my rollback
+		    dict incr transactionStats rollbacks
+		}
+	    }
+	    if {$status != 1 || ![dict exists $options -errorcode]
+		|| ![::tdbc::IsTransactionRollback \
+			 [dict get $options -errorcode]]} {
+		break
+	    }
+	    if {$attempt > $retry} {
+		if {$retry > 0} {
+		    dict incr transactionStats exhausted
+		}
+		break
+	    }
 
-	# Check arguments
+	    # Wait for a capped exponential delay, with half of it jittered
 
-	set argdict {}
-	if {[llength $args] % 2 != 0} {
-	    set errorcode $generalError
-	    lappend errorcode wrongNumArgs
-	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?..."
-	}
-	foreach {key value} $args {
-	    if {$key ni {-primary -foreign}} {
-		set errorcode $generalError
-		lappend errorcode badOption
-		return -code error -errorcode $errorcode \
-		    "bad option \"$key\", must be -primary or -foreign"
+	    set delay [expr {min($maxbackoff, $backoff << min($attempt-1, 30))}]
+	    set delay [expr {$delay / 2 + int(rand() * ($delay / 2 + 1))}]
+	    dict incr transactionStats retries
+	    if {$onretry ne {}} {
+		uplevel 1 [list {*}$onretry $attempt $delay \
+			       [dict get $options -errorcode]]
 	    }
-	    set key [string range $key 1 end]
-	    if {[dict exists $argdict $key]} {
-		set errorcode $generalError
-		lappend errorcode dupOption
-		return -code error -errorcode $errorcode \
-		    "duplicate option \"$key\" supplied"
+	    if {[info coroutine] ne {}} {
+		after $delay [info coroutine]
+		yield
+	    } else {
+		after $delay
 	    }
-	    dict set argdict $key $value
 	}
+	return -options $options $result
+    }
 
-	# Build the statements that query foreign keys. There are four
-	# of them, one for each combination of whether -primary
-	# and -foreign is specified.
+    # The 'GroupMember' method runs a transaction script as a member of
+    # a group commit. It must be called from a coroutine. The script runs
+    # inside a savepoint in the group's physical transaction, so that an
+    # error rolls back only its own work. The coroutine then waits until
+    # the group is committed, and reports either the script's own result
+    # or the error from the commit.
 
-	if {![info exists foreignKeysStatement]} {
-	    my BuildForeignKeysStatement
+    method GroupMember {script} {
+
+	set coro [info coroutine]
+	set maxdelay 5
+	set maxops 500
+	if {[dict exists $frameworkOptions -groupcommit -maxdelay]} {
+	    set maxdelay [dict get $frameworkOptions -groupcommit -maxdelay]
+	}
+	if {[dict exists $frameworkOptions -groupcommit -maxops]} {
+	    set maxops [dict get $frameworkOptions -groupcommit -maxops]
 	}
-	set stmt [dict get $foreignKeysStatement \
-		      [dict exists $argdict primary] \
-		      [dict exists $argdict foreign]]
-	tailcall $stmt allrows $argdict
-    }
 
-    # Derived classes are expected to implement the 'begintransaction',
-    # 'commit', and 'rollback' methods.
-	
-    # Derived classes are expected to implement 'tables' and 'columns' method.
+	# Member scripts run one at a time, so that their savepoints
+	# do not interleave and can all have the same name. (A name per
+	# member would make every SAVEPOINT a distinct statement, both
+	# to the database and to tdbc::querystats.)
 
-}
-
-#------------------------------------------------------------------------------
-#
-# Class: tdbc::statement
-#
-#	Class that represents a SQL statement in a generic database
-#
-#------------------------------------------------------------------------------
+	while {[dict get $groupCommit running] ne {}} {
+	    dict lappend groupCommit queue $coro
+	    yield
+	}
 
-oo::class create tdbc::statement {
+	# Open a group if there is none
 
-    # resultSetSeq is the sequence number of the last result set created.
-    # resultSetClass is the name of the class that implements the 'resultset'
-    #	API.
+	if {![dict get $groupCommit open]} {
+	    my begintransaction
+	    dict set groupCommit open 1
+	    dict set groupCommit timer \
+		[after $maxdelay [list [namespace which my] GroupCommitFlush]]
+	}
 
-    variable resultSetClass resultSetSeq
+	# Run the script inside a savepoint
 
-    # The base class constructor accepts no arguments.  It initializes
-    # the machinery for tracking the ownership of result sets. The derived
-    # constructor is expected to invoke the base constructor, and to
-    # set a variable 'resultSetClass' to the fully-qualified name of the
-    # class that represents result sets.
+	set savepoint tdbc_group
+	dict set groupCommit running $coro
+	set status [catch {
+	    my allrows "SAVEPOINT $savepoint"
+	    uplevel 1 $script
+	} result options]
+	if {$status in {0 2 3 4}} {
+	    set status2 [catch {
+		my allrows "RELEASE SAVEPOINT $savepoint"
+	    } result2 options2]
+	} else {
+	    set status2 [catch {
+		my allrows "ROLLBACK TO SAVEPOINT $savepoint"
+		my allrows "RELEASE SAVEPOINT $savepoint"
+	    } result2 options2]
+	}
+	if {$status2 == 1 && $status != 1} {
+	    set status 1
+	    set result $result2
+	    set options $options2
+	}
+	dict set groupCommit running {}
+	dict lappend groupCommit members $coro
 
-    constructor {} {
-	set resultSetSeq 0
-	namespace eval ResultSet {}
-    }
+	# Let the next waiting member run
 
-    # The 'execute' method on a statement runs the statement with
-    # a particular set of substituted variables.  It actually works
-    # by creating the result set object and letting that objects
-    # constructor do the work of running the statement.  The creation
-    # is wrapped in an [uplevel] call because the substitution proces
-    # may need to access variables in the caller's scope.
+	if {[llength [dict get $groupCommit queue]] > 0} {
+	    set queue [dict get $groupCommit queue]
+	    dict set groupCommit queue [lrange $queue 1 end]
+	    after 0 [list [lindex $queue 0]]
+	}
 
-    # WORKAROUND: Take out the '0 &&' from the next line when 
-    # Bug 2649975 is fixed
-    if {0 && [package vsatisfies [package provide Tcl] 8.6]} {
-	method execute args {
-	    tailcall my resultSetCreate \
-		[namespace current]::ResultSet::[incr resultSetSeq]  \
-		[self] {*}$args
+	# Commit the group if it is full or its time has expired, otherwise
+	# wait for the commit.
+
+	if {[llength [dict get $groupCommit members]] >= $maxops
+	    || [dict get $groupCommit expired]} {
+	    set outcome [my GroupCommitFlush]
+	} else {
+	    set outcome [yield]
 	}
-    } else {
-	method execute args {
-	    return \
-		[uplevel 1 \
-		     [list \
-			  [self] resultSetCreate \
-			  [namespace current]::ResultSet::[incr resultSetSeq] \
-			  [self] {*}$args]]
+	lassign $outcome status2 result2 options2
+	if {$status2 == 1} {
+	    return -options $options2 $result2
+	}
+	if {$status == 2} {
+	    set options [dict merge {-level 1} $options[set options {}]]
+	    dict incr options -level
 	}
+	return -options $options $result
     }
 
-    # The 'ResultSetCreate' method is expected to be a forward to the
-    # appropriate result set constructor. If it's missing, the driver must
-    # have been designed for tdbc 1.0b9 and earlier, and the 'resultSetClass'
-    # variable holds the class name.
+    # The 'GroupCommitFlush' method commits the physical transaction of a
+    # group, and passes the outcome to the members that are waiting for
+    # it. If a member's script is still running, the commit is deferred
+    # until it finishes.
 
-    method resultSetCreate {name instance args} {
-	return [uplevel 1 [list $resultSetClass create \
-			       $name $instance {*}$args]]
+    method GroupCommitFlush {} {
+	after cancel [dict get $groupCommit timer]
+	if {![dict get $groupCommit open]} {
+	    return {0 {} {}}
+	}
+	if {[dict get $groupCommit running] ne {}} {
+	    dict set groupCommit expired 1
+	    return {0 {} {}}
+	}
+	set members [dict get $groupCommit members]
+	dict set groupCommit open 0
+	dict set groupCommit expired 0
+	dict set groupCommit members {}
+	dict set groupCommit timer {}
+	dict incr transactionStats transactions
+	set status [catch {my commit} result options]
+	if {$status != 0} {
+	    catch {my rollback}
+	    dict incr transactionStats rollbacks
+	}
+	set outcome [list $status $result $options]
+	foreach coro $members {
+	    if {$coro ne [info coroutine]} {
+		after 0 [list $coro $outcome]
+	    }
+	}
+	return $outcome
     }
 
-    # The 'resultsets' method returns a list of result sets produced by
-    # the current statement
+    # The 'transactionstats' method returns a dictionary of counts of
+    # transactions run by the 'transaction' method: the number of
+    # attempts, rollbacks, retries after serialization failures, and
+    # transactions that failed after the last permitted retry.
 
-    method resultsets {} {
-	info commands ResultSet::*
+    method transactionstats {} {
+	return $transactionStats
     }
 
-    # The 'allrows' method executes a statement with a given set of
-    # substituents, and returns a list of all the rows that the statement
-    # returns.  Optionally, it stores the names of columns in
-    # '-columnsvariable'.
-    #
+    # The 'allrows' method prepares a statement, then executes it with
+    # a given set of substituents, returning a list of all the rows
+    # that the statement returns. Optionally, it stores the names of
+    # the columns in '-columnsvariable'. If the result cache is enabled,
+    # the results of read-only statements are answered from the cache
+    # when possible.
     # Usage:
-    #	$statement allrows ?-as lists|dicts? ?-columnsvariable varName? ?--?
-    #		?dictionary?
-
+    #     $db allrows ?-as lists|dicts? ?-columnsvariable varName?
+    #	      ?-intern columns? ?-timeout ms? ?--? sql ?dictionary?
 
     method allrows args {
 
@@ -577,98 +1095,299 @@ oo::class create tdbc::statement {
 	# Grab keyword-value parameters
 
 	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+	::tdbc::CheckRowOptions $opts
 
 	# Check postitional parameters 
 
-	set cmd [list [self] execute]
-	if {[llength $args] == 0} {
-	    # do nothing
-	} elseif {[llength $args] == 1} {
-	    lappend cmd [lindex $args 0]
+	set cmd [list [self] prepare]
+	if {[llength $args] == 1} {
+	    set sqlcode [lindex $args 0]
+	} elseif {[llength $args] == 2} {
+	    lassign $args sqlcode dict
 	} else {
 	    set errorcode $generalError
 	    lappend errorcode wrongNumArgs
 	    return -code error -errorcode $errorcode \
 		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? ?dictionary?"
+                 ?-option value?... ?--? sqlcode ?dictionary?"
 	}
+	lappend cmd $sqlcode
 
-	# Get the result set
+	# Inside 'pipeline', queue the statement and return a future
 
-	set resultSet [uplevel 1 $cmd]
+	if {[dict get $pipeline depth] > 0 && ![dict get $pipeline flushing]} {
+	    if {[dict exists $opts -columnsvariable]} {
+		set errorcode $generalError
+		lappend errorcode badOption -columnsvariable
+		return -code error -errorcode $errorcode \
+		    "option \"-columnsvariable\" cannot be used in a\
+                     pipeline: use the \"columns\" method of the future"
+	    }
+	    if {![info exists dict]} {
+		set dict {}
+		foreach name [dict get [::tdbc::classify $sqlcode] params] {
+		    upvar 1 $name value
+		    if {[info exists value]} {
+			dict set dict $name $value
+		    }
+		    unset -nocomplain value
+		}
+	    }
+	    set future [::tdbc::future create \
+			    [namespace current]::Future::[incr futureSeq] \
+			    [namespace which my]]
+	    dict lappend pipeline queue \
+		[list $future [dict get $opts -as] $sqlcode $dict]
+	    return $future
+	}
 
-	# Delegate to the result set's [allrows] method to accumulate
-	# the rows of the result.
+	# Try the result cache
+
+	if {[dict get $frameworkOptions -resultcache] > 0 && !$inTransaction} {
+	    set class [::tdbc::classify $sqlcode]
+	    if {[dict get $class readonly]} {
+
+		# Bound values come from the caller's variables if no
+		# dictionary is given, and the dictionary's keys are put
+		# in a canonical order to make the cache key.
+
+		set bound {}
+		foreach name [lsort [dict get $class params]] {
+		    if {[info exists dict]} {
+			if {[dict exists $dict $name]} {
+			    dict set bound $name [dict get $dict $name]
+			}
+		    } else {
+			upvar 1 $name value
+			if {[info exists value]} {
+			    dict set bound $name $value
+			}
+		    }
+		}
+		set key [list [dict get $opts -as] $sqlcode $bound]
+		if {[dict exists $opts -columnsvariable]} {
+		    upvar 1 [dict get $opts -columnsvariable] columns
+		}
+		if {[my ResultCacheGet $key columns rows]} {
+		    return $rows
+		}
+		set dict $bound
+		set columnsVar [my varname cachedColumns]
+		dict set opts -columnsvariable $columnsVar
+	    }
+	}
 
-	set cmd [list $resultSet allrows {*}$opts]
+	# Prepare the statement
+
+	set stmt [uplevel 1 $cmd]
+
+	# Delegate to the statement to accumulate the results
+
+	set cmd [list $stmt allrows {*}$opts --]
+	if {[info exists dict]} {
+	    lappend cmd $dict
+	}
 	set status [catch {
 	    uplevel 1 $cmd
 	} result options]
 
-	# Destroy the result set
+	# Destroy the statement
 
 	catch {
-	    rename $resultSet {}
+	    $stmt close
 	}
 
-	# Adjust return level in the case that the script [return]s
-
-	if {$status == 2} {
-	    set options [dict merge {-level 1} $options[set options {}]]
-	    dict incr options -level
+	if {$status == 0 && [info exists key]} {
+	    set columns [set $columnsVar]
+	    my ResultCachePut $key [dict get $class tables] $columns $result
 	}
+
 	return -options $options $result
     }
 
-    # The 'foreach' method executes a statement with a given set of
-    # substituents.  It runs the supplied script, substituting the supplied
-    # named variable. Optionally, it stores the names of columns in
-    # '-columnsvariable'.
-    #
-    # Usage:
-    #	$statement foreach ?-as lists|dicts? ?-columnsvariable varName? ?--?
-    #		variableName ?dictionary? script
+    # The 'ResultCacheGet' method looks up a key in the result cache.
+    # On a hit, it stores the column names and rows in the given variables
+    # and returns 1. On a miss, it returns 0.
+
+    method ResultCacheGet {key columnsVar rowsVar} {
+	if {[dict exists $resultCache $key]} {
+	    set entry [dict get $resultCache $key]
+	    lassign $entry expires tables columns rows bytes
+	    dict unset resultCache $key
+	    if {$expires == 0 || $expires > [clock milliseconds]} {
+
+		# Move the entry to the most recently used position
+
+		dict set resultCache $key $entry
+		dict incr resultCacheStats hits
+		upvar 1 $columnsVar c $rowsVar r
+		set c $columns
+		set r $rows
+		return 1
+	    }
+	    incr resultCacheBytes [expr {-$bytes}]
+	    dict incr resultCacheStats evictions
+	}
+	dict incr resultCacheStats misses
+	return 0
+    }
 
-    method foreach args {
+    # The 'ResultCachePut' method stores a result in the cache, evicting
+    # the least recently used entries if the cache is full.
+
+    method ResultCachePut {key tables columns rows} {
+	set size [dict get $frameworkOptions -resultcache]
+	while {[dict size $resultCache] >= $size && $size > 0} {
+	    dict for {k entry} $resultCache break
+	    dict unset resultCache $k
+	    incr resultCacheBytes [expr {-[lindex $entry 4]}]
+	    dict incr resultCacheStats evictions
+	}
+	set ttl [dict get $frameworkOptions -resultttl]
+	if {$ttl > 0} {
+	    set expires [expr {[clock milliseconds] + $ttl}]
+	} else {
+	    set expires 0
+	}
+	set bytes [::tdbc::SizeOf [list $tables $columns $rows]]
+	dict set resultCache $key [list $expires $tables $columns $rows $bytes]
+	incr resultCacheBytes $bytes
+    }
+
+    # The 'StatementWrites' method is called when a statement that writes
+    # to the database is executed, with the statement's classification
+    # from tdbc::classify. It invalidates the cached results that the
+    # statement may change, and discards the schema snapshot if the
+    # statement changes the schema.
+
+    method StatementWrites {sqlClass} {
+	my ResultCacheInvalidate [dict get $sqlClass tables]
+	if {[dict get $sqlClass kind] in {CREATE ALTER DROP RENAME}} {
+	    unset -nocomplain schemaSnapshot
+	}
+    }
+
+    # The 'ResultCacheInvalidate' method removes the cached results
+    # that read any of the given tables, or all cached results if the
+    # list of tables is empty.
+
+    method ResultCacheInvalidate {tables} {
+	if {[dict size $resultCache] == 0} {
+	    return
+	}
+	if {[llength $tables] == 0} {
+	    dict incr resultCacheStats invalidations [dict size $resultCache]
+	    set resultCache {}
+	    set resultCacheBytes 0
+	    return
+	}
+	dict for {key entry} $resultCache {
+	    foreach table [lindex $entry 1] {
+		if {$table in $tables} {
+		    dict unset resultCache $key
+		    incr resultCacheBytes [expr {-[lindex $entry 4]}]
+		    dict incr resultCacheStats invalidations
+		    break
+		}
+	    }
+	}
+    }
+
+    # The 'cacheflush' method empties the result cache.
+
+    method cacheflush {} {
+	set resultCache {}
+	set resultCacheBytes 0
+	return
+    }
+
+    # The 'cachestats' method returns a dictionary of statistics about
+    # the result cache: the counts of hits, misses, evictions and
+    # invalidations, the number of entries, and the hit rate.
+
+    method cachestats {} {
+	set stats $resultCacheStats
+	dict set stats entries [dict size $resultCache]
+	set lookups [expr {[dict get $stats hits] + [dict get $stats misses]}]
+	if {$lookups == 0} {
+	    dict set stats hitrate 0.0
+	} else {
+	    dict set stats hitrate \
+		[expr {double([dict get $stats hits]) / $lookups}]
+	}
+	return $stats
+    }
+
+    # The 'foreach' method prepares a statement, then executes it with
+    # a supplied set of substituents.  For each row of the result,
+    # it sets a variable to the row and invokes a script in the caller's
+    # scope. With -variables or -columnvars, it sets a variable to each
+    # column instead, and takes no row variable.
+    #
+    # Usage: 
+    #     $db foreach ?-as lists|dicts? ?-columnsVariable varName?
+    #         ?-intern columns? ?-timeout ms? ?--? varName sql ?dictionary?
+    #         script
+    #     $db foreach ?-variables varNames|-columnvars boolean?
+    #         ?-option value?... ?--? sql ?dictionary? script
+
+    method foreach args {
 
 	variable ::tdbc::generalError
 
 	# Grab keyword-value parameters
 
 	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
-	
-	# Check positional parameters
 
-	set cmd [list [self] execute]
-	if {[llength $args] == 2} {
-	    lassign $args varname script
-	} elseif {[llength $args] == 3} {
-	    lassign $args varname dict script
-	    lappend cmd $dict
+	# With -variables or -columnvars, there is no row variable
+
+	set bind [expr {[dict exists $opts -variables]
+			|| [dict exists $opts -columnvars]}]
+	if {$bind} {
+	    set args [linsert $args[set args {}] 0 {}]
+	    set usage {}
+	} else {
+	    set usage {varname }
+	}
+
+	# Check postitional parameters 
+
+	set cmd [list [self] prepare]
+	if {[llength $args] == 3} {
+	    lassign $args varname sqlcode script
+	} elseif {[llength $args] == 4} {
+	    lassign $args varname sqlcode dict script
 	} else {
 	    set errorcode $generalError
 	    lappend errorcode wrongNumArgs
 	    return -code error -errorcode $errorcode \
 		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? varName ?dictionary? script"
+                 ?-option value?... ?--? ${usage}sqlcode ?dictionary? script"
 	}
+	lappend cmd $sqlcode
 
-	# Get the result set
+	# Prepare the statement
 
-	set resultSet [uplevel 1 $cmd]
+	set stmt [uplevel 1 $cmd]
 
-	# Delegate to the result set's [foreach] method to evaluate
-	# the script for each row of the result.
+	# Delegate to the statement to iterate over the results
 
-	set cmd [list $resultSet foreach {*}$opts -- $varname $script]
+	set cmd [list $stmt foreach {*}$opts --]
+	if {!$bind} {
+	    lappend cmd $varname
+	}
+	if {[info exists dict]} {
+	    lappend cmd $dict
+	}
+	lappend cmd $script
 	set status [catch {
 	    uplevel 1 $cmd
 	} result options]
 
-	# Destroy the result set
+	# Destroy the statement
 
 	catch {
-	    rename $resultSet {}
+	    $stmt close
 	}
 
 	# Adjust return level in the case that the script [return]s
@@ -680,242 +1399,3413 @@ oo::class create tdbc::statement {
 	return -options $options $result
     }
 
-    # The 'close' method is syntactic sugar for invoking the destructor
+    # The 'pages' method is defined on first use, by 'LazyPages'.
 
-    method close {} {
-	my destroy
+    method pages args {
+	::tdbc::DefineLazy
+	tailcall my LazyPages {*}$args
     }
 
-    # Derived classes are expected to implement their own constructors,
-    # plus the following methods:
-
-    # paramtype paramName ?direction? type ?scale ?precision??
-    #     Declares the type of a parameter in the statement
+    # The 'pipeline' method is defined on first use, by 'LazyPipeline'.
 
-}
-
-#------------------------------------------------------------------------------
-#
-# Class: tdbc::resultset
-#
-#	Class that represents a result set in a generic database.
-#
-#------------------------------------------------------------------------------
+    method pipeline {script} {
+	::tdbc::DefineLazy
+	tailcall my LazyPipeline $script
+    }
 
-oo::class create tdbc::resultset {
+    # The 'HasConstraintCatalogs' method determines whether the
+    # database supplies CONSTRAINT_CATALOG in INFORMATION_SCHEMA. On some
+    # databases, CONSTRAINT_CATALOG is always NULL and JOINing to it
+    # fails, so the JOINs on it are included only if catalog names are
+    # supplied. The answer is obtained once and retained.
+
+    method HasConstraintCatalogs {} {
+	if {![info exists hasConstraintCatalogs]} {
+	    set hasConstraintCatalogs [expr {[lindex [my allrows -as lists {
+		SELECT COUNT(*) 
+		FROM INFORMATION_SCHEMA.TABLE_CONSTRAINTS
+		WHERE CONSTRAINT_CATALOG IS NOT NULL}] 0 0] != 0}]
+	}
+	return $hasConstraintCatalogs
+    }
 
-    constructor {} { }
+    # The 'PrimaryKeysSql' method returns the SQL code that retrieves
+    # primary keys from INFORMATION_SCHEMA, with the given extra
+    # condition in its WHERE clause.
 
-    # The 'allrows' method returns a list of all rows that a given
-    # result set returns.
+    method PrimaryKeysSql {condition} {
+	set catalogClause {}
+	if {[my HasConstraintCatalogs]} {
+	    set catalogClause \
+		{AND xtable.CONSTRAINT_CATALOG = xcolumn.CONSTRAINT_CATALOG}
+	}
+	return "
+	     SELECT xtable.TABLE_SCHEMA AS \"tableSchema\", 
+                 xtable.TABLE_NAME AS \"tableName\",
+                 xtable.CONSTRAINT_CATALOG AS \"constraintCatalog\", 
+                 xtable.CONSTRAINT_SCHEMA AS \"constraintSchema\", 
+                 xtable.CONSTRAINT_NAME AS \"constraintName\", 
+                 xcolumn.COLUMN_NAME AS \"columnName\", 
+                 xcolumn.ORDINAL_POSITION AS \"ordinalPosition\" 
+             FROM INFORMATION_SCHEMA.TABLE_CONSTRAINTS xtable 
+             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE xcolumn 
+                     ON xtable.CONSTRAINT_SCHEMA = xcolumn.CONSTRAINT_SCHEMA 
+                    AND xtable.TABLE_NAME = xcolumn.TABLE_NAME
+                    AND xtable.CONSTRAINT_NAME = xcolumn.CONSTRAINT_NAME 
+	            $catalogClause
+             WHERE xtable.CONSTRAINT_TYPE = 'PRIMARY KEY'
+                 $condition
+  	"
+    }
 
-    method allrows args {
+    # The 'BuildPrimaryKeysStatement' method builds a SQL statement to
+    # retrieve the primary keys from a database. (It executes once the
+    # first time the 'primaryKeys' method is executed, and retains the
+    # prepared statement for reuse. The statement is built again if it
+    # has been closed since, as -onlimit close may do.)
 
-	variable ::tdbc::generalError
+    method BuildPrimaryKeysStatement {} {
+	set primaryKeysStatement \
+	    [my prepare [my PrimaryKeysSql {AND xtable.TABLE_NAME = :tableName}]]
+    }
 
-	# Parse args
+    # The default implementation of the 'primarykeys' method uses the
+    # SQL INFORMATION_SCHEMA to retrieve primary key information. Databases
+    # that might not have INFORMATION_SCHEMA must overload this method.
 
-	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
-	if {[llength $args] != 0} {
-	    set errorcode $generalError
-	    lappend errorcode wrongNumArgs
-	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? varName script"
+    method primarykeys {tableName} {
+	if {![info exists primaryKeysStatement]
+	    || [info commands $primaryKeysStatement] eq {}} {
+	    my BuildPrimaryKeysStatement
 	}
+	tailcall $primaryKeysStatement allrows [list tableName $tableName]
+    }
 
-	# Do -columnsvariable if requested
+    # The 'ForeignKeysSql' method returns the SQL code that retrieves
+    # foreign keys from INFORMATION_SCHEMA, restricted to the given
+    # primary and foreign tables if 'exists1' and 'exists2' are true.
 
-	if {[dict exists $opts -columnsvariable]} {
-	    upvar 1 [dict get $opts -columnsvariable] columns
+    method ForeignKeysSql {exists1 exists2} {
+	set catalogClause1 {}
+	set catalogClause2 {}
+	if {[my HasConstraintCatalogs]} {
+	    set catalogClause1 \
+		{AND fkc.CONSTRAINT_CATALOG = rc.CONSTRAINT_CATALOG}
+	    set catalogClause2 \
+		{AND pkc.CONSTRAINT_CATALOG = rc.CONSTRAINT_CATALOG}
 	}
+	set clause1 [expr {$exists1 ? { AND pkc.TABLE_NAME = :primary} : {}}]
+	set clause2 [expr {$exists2 ? { AND fkc.TABLE_NAME = :foreign} : {}}]
+	return "
+	     SELECT rc.CONSTRAINT_CATALOG AS \"foreignConstraintCatalog\",
+                    rc.CONSTRAINT_SCHEMA AS \"foreignConstraintSchema\",
+                    rc.CONSTRAINT_NAME AS \"foreignConstraintName\",
+                    rc.UNIQUE_CONSTRAINT_CATALOG 
+                        AS \"primaryConstraintCatalog\",
+                    rc.UNIQUE_CONSTRAINT_SCHEMA AS \"primaryConstraintSchema\",
+                    rc.UNIQUE_CONSTRAINT_NAME AS \"primaryConstraintName\",
+                    rc.UPDATE_RULE AS \"updateAction\",
+		    rc.DELETE_RULE AS \"deleteAction\",
+                    pkc.TABLE_CATALOG AS \"primaryCatalog\",
+                    pkc.TABLE_SCHEMA AS \"primarySchema\",
+                    pkc.TABLE_NAME AS \"primaryTable\",
+                    pkc.COLUMN_NAME AS \"primaryColumn\",
+                    fkc.TABLE_CATALOG AS \"foreignCatalog\",
+                    fkc.TABLE_SCHEMA AS \"foreignSchema\",
+                    fkc.TABLE_NAME AS \"foreignTable\",
+                    fkc.COLUMN_NAME AS \"foreignColumn\",
+                    pkc.ORDINAL_POSITION AS \"ordinalPosition\"
+             FROM INFORMATION_SCHEMA.REFERENTIAL_CONSTRAINTS rc
+             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE fkc
+                     ON fkc.CONSTRAINT_NAME = rc.CONSTRAINT_NAME
+                    AND fkc.CONSTRAINT_SCHEMA = rc.CONSTRAINT_SCHEMA
+                    $catalogClause1
+             INNER JOIN INFORMATION_SCHEMA.KEY_COLUMN_USAGE pkc
+                     ON pkc.CONSTRAINT_NAME = rc.UNIQUE_CONSTRAINT_NAME
+                     AND pkc.CONSTRAINT_SCHEMA = rc.UNIQUE_CONSTRAINT_SCHEMA
+                     $catalogClause2
+                     AND pkc.ORDINAL_POSITION = fkc.ORDINAL_POSITION
+             WHERE 1=1
+                 $clause1
+                 $clause2
+"
+    }
 
-	# Assemble the results
+    # The 'BuildForeignKeysStatement' method builds a SQL statement to
+    # retrieve the foreign keys from a database. There are four variants
+    # of the statement, one for each combination of whether -primary and
+    # -foreign is specified; each is prepared the first time that it is
+    # needed, and retained for reuse until it is closed.
 
-	if {[dict get $opts -as] eq {lists}} {
-	    set delegate nextlist
-	} else {
-	    set delegate nextdict
-	}
-	set results [list]
-	while {1} {
-	    set columns [my columns]
-	    while {[my $delegate row]} {
-		lappend results $row
-	    }
-	    if {![my nextresults]} break
-	}
-	return $results
-	    
+    method BuildForeignKeysStatement {exists1 exists2} {
+	dict set foreignKeysStatement $exists1 $exists2 \
+	    [my prepare [my ForeignKeysSql $exists1 $exists2]]
     }
 
-    # The 'foreach' method runs a script on each row from a result set.
+    # The 'ForeignKeysArgs' method checks the arguments of the
+    # 'foreignkeys' method, and returns a dictionary whose keys are
+    # 'primary' and 'foreign' and whose values are the table names
+    # supplied. 'cmd' is the command name to use in error messages.
 
-    method foreach args {
+    method ForeignKeysArgs {cmd argv} {
 
 	variable ::tdbc::generalError
 
-	# Grab keyword-value parameters
-
-	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
-
-	# Check positional parameters
-
-	if {[llength $args] != 2} {
+	set argdict {}
+	if {[llength $argv] % 2 != 0} {
 	    set errorcode $generalError
 	    lappend errorcode wrongNumArgs
 	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? varName script"
+		"wrong # args: should be $cmd ?-option value?..."
+	}
+	foreach {key value} $argv {
+	    if {$key ni {-primary -foreign}} {
+		set errorcode $generalError
+		lappend errorcode badOption
+		return -code error -errorcode $errorcode \
+		    "bad option \"$key\", must be -primary or -foreign"
+	    }
+	    set key [string range $key 1 end]
+	    if {[dict exists $argdict $key]} {
+		set errorcode $generalError
+		lappend errorcode dupOption
+		return -code error -errorcode $errorcode \
+		    "duplicate option \"$key\" supplied"
+	    }
+	    dict set argdict $key $value
 	}
+	return $argdict
+    }
 
-	# Do -columnsvariable if requested
-	    
-	if {[dict exists $opts -columnsvariable]} {
-	    upvar 1 [dict get $opts -columnsvariable] columns
+    # The default implementation of the 'foreignkeys' method uses the
+    # SQL INFORMATION_SCHEMA to retrieve primary key information. Databases
+    # that might not have INFORMATION_SCHEMA must overload this method.
+
+    method foreignkeys {args} {
+	set argdict [my ForeignKeysArgs [lrange [info level 0] 0 1] $args]
+	set exists1 [dict exists $argdict primary]
+	set exists2 [dict exists $argdict foreign]
+	if {![info exists foreignKeysStatement]
+	    || ![dict exists $foreignKeysStatement $exists1 $exists2]
+	    || [info commands [dict get $foreignKeysStatement \
+				   $exists1 $exists2]] eq {}} {
+	    my BuildForeignKeysStatement $exists1 $exists2
 	}
+	tailcall [dict get $foreignKeysStatement $exists1 $exists2] \
+	    allrows $argdict
+    }
 
-	# Iterate over the groups of results 
-	while {1} {
+    # The 'schema' method is defined on first use, by 'LazySchema'.
 
-	    # Export column names to caller
+    method schema args {
+	::tdbc::DefineLazy
+	tailcall my LazySchema {*}$args
+    }
 
-	    set columns [my columns]
+    # Derived classes are expected to implement the 'begintransaction',
+    # 'commit', and 'rollback' methods.
+	
+    # Derived classes are expected to implement 'tables' and 'columns' method.
 
-	    # Iterate over the rows of one group of results
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::ConnectionHooks --
+#
+#	Mixin that the base class constructor applies to every connection.
+#	It accepts the options in 'tdbc::connectionOptions' in 'configure',
+#	passing any others to the driver, and tracks whether a transaction
+#	is in progress.
+#
+#------------------------------------------------------------------------------
 
-	    upvar 1 [lindex $args 0] row
-	    if {[dict get $opts -as] eq {lists}} {
-		set delegate nextlist
-	    } else {
-		set delegate nextdict
+oo::class create ::tdbc::ConnectionHooks {
+
+    variable frameworkOptions inTransaction schemaSnapshot
+
+    method configure args {
+
+	variable ::tdbc::connectionOptions
+	variable ::tdbc::generalError
+
+	# Query all options
+
+	if {[llength $args] == 0} {
+	    set result {}
+	    if {[llength [self next]] > 0} {
+		set result [next]
 	    }
-	    while {[my $delegate row]} {
-		set status [catch {
-		    uplevel 1 [lindex $args 1]
-		} result options]
-		switch -exact -- $status {
-		    0 - 4 {	# OK or CONTINUE
-		    }
-		    2 {		# RETURN
-			set options \
-			    [dict merge {-level 1} $options[set options {}]]
-			dict incr options -level
-			return -options $options $result
-		    }
-		    3 {		# BREAK
-			set broken 1
-			break
+	    return [dict merge $result $frameworkOptions]
+	}
+
+	# Query a single option
+
+	if {[llength $args] == 1} {
+	    if {[dict exists $frameworkOptions [lindex $args 0]]} {
+		return [dict get $frameworkOptions [lindex $args 0]]
+	    }
+	    return [next {*}$args]
+	}
+
+	# Set options, passing the ones that the driver handles to the driver
+
+	if {[llength $args] % 2 != 0} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be \"[self] configure\
+                 ?-option value?...\""
+	}
+	set driverArgs {}
+	set newOptions $frameworkOptions
+	foreach {option value} $args {
+	    if {![dict exists $connectionOptions $option]} {
+		lappend driverArgs $option $value
+		continue
+	    }
+	    switch -exact -- [dict get $connectionOptions $option type] {
+		count {
+		    set ok [expr {[string is entier -strict $value]
+				  && $value >= 0}]
+		}
+		boolean {
+		    set ok [string is boolean -strict $value]
+		}
+		choice {
+		    set ok [expr {$value in
+				  [dict get $connectionOptions $option values]}]
+		}
+		options {
+		    set ok [expr {[string is list $value]
+				  && [llength $value] % 2 == 0}]
+		    set keys [dict get $connectionOptions $option keys]
+		    foreach {k v} [expr {$ok ? $value : {}}] {
+			if {$k ni $keys || ![string is entier -strict $v]
+			    || $v < 0} {
+			    set ok 0
+			}
 		    }
-		    default {	# ERROR or unknown status
-			return -options $options $result
+		}
+		default {
+		    set ok 1
+		}
+	    }
+	    if {!$ok} {
+		set errorcode $generalError
+		lappend errorcode badOptionValue $option $value
+		return -code error -errorcode $errorcode \
+		    "bad value \"$value\" for option \"$option\""
+	    }
+	    dict set newOptions $option $value
+	}
+	if {[llength $driverArgs] > 0} {
+	    next {*}$driverArgs
+	}
+	set frameworkOptions $newOptions
+	return
+    }
+
+    method begintransaction {} {
+	set result [next]
+	set inTransaction 1
+	return $result
+    }
+
+    method commit {} {
+	set result [next]
+	set inTransaction 0
+	return $result
+    }
+
+    method rollback {} {
+	set inTransaction 0
+	return [next]
+    }
+
+    # Answer 'primarykeys' and 'foreignkeys' from the schema snapshot,
+    # if one has been loaded, whether or not the driver overloads them.
+
+    method primarykeys {tableName} {
+	if {![info exists schemaSnapshot]} {
+	    return [next $tableName]
+	}
+	if {![dict exists $schemaSnapshot $tableName]} {
+	    return {}
+	}
+	return [dict get $schemaSnapshot $tableName primarykeys]
+    }
+
+    method foreignkeys args {
+	if {![info exists schemaSnapshot]} {
+	    return [next {*}$args]
+	}
+	return [my SchemaForeignKeys \
+		    [my ForeignKeysArgs [lrange [info level 0] 0 1] $args]]
+    }
+
+    # Cancel a pending group commit when the connection is destroyed
+
+    destructor {
+	my variable groupCommit watches
+	if {[info exists groupCommit]} {
+	    after cancel [dict get $groupCommit timer]
+	}
+	if {[info exists watches]} {
+	    dict for {watch entry} $watches {
+		lassign $entry kind token
+		if {$kind eq {watchdog}} {
+		    ::tdbc::Watchdog disarm $token
+		} else {
+		    after cancel $token
+		}
+	    }
+	}
+	if {[llength [self next]] > 0} {
+	    next
+	}
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# Class: tdbc::statement
+#
+#	Class that represents a SQL statement in a generic database
+#
+#------------------------------------------------------------------------------
+
+oo::class create tdbc::statement {
+
+    # resultSetSeq is the sequence number of the last result set created.
+    # resultSetClass is the name of the class that implements the 'resultset'
+    #	API.
+    # connectionMy is the 'my' command of the connection that prepared
+    #	the statement, through which the statement calls back to the
+    #	connection's private methods.
+    # sqlClass is the result of tdbc::classify on the statement's SQL
+    #	code.
+    # fingerprint is the result of tdbc::fingerprint on the statement's
+    #	SQL code, under which its executions are counted in the query
+    #	statistics, or empty if they are not counted.
+    # countCalls is 1 if the statement counts its executions in the query
+    #	statistics, and 0 if the statements that it executes on other
+    #	connections count them.
+    # literals is a dictionary of the values of the literals that
+    #	'-autoparameterize' replaced by bound variables, keyed by the
+    #	variables' names
+    # hasExecuteDirect is 1 if the driver implements 'executeDirect'
+    # hasStreamParams is 1 if the driver reads the channels of stream
+    #	parameters itself
+
+    variable resultSetClass resultSetSeq connectionMy sqlClass \
+	fingerprint countCalls literals hasExecuteDirect hasStreamParams
+
+    # The base class constructor accepts no arguments.  It initializes
+    # the machinery for tracking the ownership of result sets. The derived
+    # constructor is expected to invoke the base constructor, and to
+    # set a variable 'resultSetClass' to the fully-qualified name of the
+    # class that represents result sets.
+
+    constructor {} {
+	set resultSetSeq 0
+	set connectionMy {}
+	set sqlClass {kind {} readonly 0 tables {} params {}}
+	set fingerprint {}
+	set countCalls 1
+	set literals {}
+	namespace eval ResultSet {}
+    }
+
+    # The 'Attach' method is called by the connection's 'prepare' method
+    # once the statement has been constructed, to tell the statement
+    # what connection it belongs to, what SQL code it executes, and the
+    # values of the literals that the connection replaced in the code.
+
+    method Attach {connection sqlcode {values {}}} {
+	set connectionMy $connection
+	set sqlClass [::tdbc::classify $sqlcode]
+	set fingerprint [::tdbc::fingerprint $sqlcode]
+	set literals $values
+    }
+
+    # The 'execute' method on a statement runs the statement with
+    # a particular set of substituted variables.  It actually works
+    # by creating the result set object and letting that objects
+    # constructor do the work of running the statement.  The creation
+    # is wrapped in an [uplevel] call because the substitution proces
+    # may need to access variables in the caller's scope.
+
+    # The options below may be given in any order before the dictionary
+    # of bound values.
+
+    # If '-materialize' is given, the rows of the result are read
+    # immediately into a compact arena, and the return value is a
+    # command that gives random access to them.
+
+    # If '-prefetch n' is given, and the driver permits rows to be
+    # fetched in another thread, a thread reads up to 'n' rows ahead of
+    # the caller.
+
+    # If '-timeout ms' is given, or the connection has a '-querytimeout',
+    # the query is canceled if it has not finished 'ms' milliseconds
+    # later. The timeout covers reading the rows, and lasts
+    # until the result set is closed.
+
+    # If stream parameters exist and the driver cannot read their
+    # channels, or the statement binds the values of literals, the bound
+    # values are gathered into a dictionary in which the channels'
+    # contents replace the tokens.
+
+    # The execution is counted in the query statistics, with the time
+    # that it took to create the result set.
+
+    # The result set is created with 'uplevel' rather than 'tailcall', so
+    # that the execution can be timed, counted and registered after it.
+
+    method execute args {
+	variable ::tdbc::generalError
+	set timeout {}
+	set materialize 0
+	while {[lindex $args 0] in {-materialize -prefetch -timeout}} {
+	    set option [lindex $args 0]
+	    if {$option eq {-materialize}} {
+		set materialize 1
+		set args [lrange $args 1 end]
+		continue
+	    }
+	    set value [lindex $args 1]
+	    if {![string is entier -strict $value]
+		|| $value < ($option eq {-prefetch})} {
+		set errorcode $generalError
+		lappend errorcode badOptionValue $option $value
+		return -code error -errorcode $errorcode \
+		    "bad value \"$value\" for option \"$option\""
+	    }
+	    set [string range $option 1 end] $value
+	    set args [lrange $args 2 end]
+	}
+
+	# From here on, '-materialize' is passed on as the first argument.
+
+	if {$materialize} {
+	    set args [linsert $args 0 -materialize]
+	}
+	if {$connectionMy ne {}} {
+	    set defaultTimeout \
+		[$connectionMy StatementExecuting [self] $sqlClass]
+	    if {$timeout eq {}} {
+		set timeout $defaultTimeout
+	    }
+	}
+	if {([::tdbc::StreamParamCount] > 0 && ![my HasStreamParams])
+	    || [dict size $literals] > 0} {
+	    set i [expr {[lindex $args 0] eq {-materialize}}]
+	    if {[llength $args] <= $i + 1} {
+		set args [list {*}[lrange $args 0 $i-1] \
+			      [my BoundValues [lrange $args $i end]]]
+	    }
+	}
+	set watch {}
+	set start [clock microseconds]
+	set failed [catch {
+	    if {$timeout ne {} && $timeout > 0 && $connectionMy ne {}} {
+		lassign [uplevel 1 \
+			     [list [namespace which my] ExecuteWatched \
+				  $timeout {*}$args]] resultSet watch
+	    } elseif {[lindex $args 0] eq {-materialize}} {
+		set resultSet \
+		    [uplevel 1 \
+			 [list [namespace which my] ExecuteMaterialized \
+			      {*}[lrange $args 1 end]]]
+	    } else {
+		set resultSet \
+		    [uplevel 1 \
+			 [list \
+			      [self] resultSetCreate \
+			      [namespace current]::ResultSet::[incr resultSetSeq] \
+			      [self] {*}$args]]
+	    }
+	} result options]
+	if {$countCalls && $fingerprint ne {}} {
+	    set rows 0
+	    if {!$failed && [lindex $args 0] eq {-materialize}} {
+		set rows [$resultSet size]
+	    }
+	    ::tdbc::RecordQueryStats record $fingerprint \
+		[expr {[clock microseconds] - $start}] $failed $rows
+	}
+	if {$failed} {
+	    return -options $options $result
+	}
+	if {[info exists prefetch] && [lindex $args 0] ne {-materialize}
+	    && [::tdbc::Prefetch $resultSet start $prefetch]} {
+	    oo::objdefine $resultSet mixin \
+		{*}[info object mixins $resultSet] ::tdbc::PrefetchHooks
+	}
+	if {$connectionMy ne {}} {
+	    $connectionMy RegisterResultSet [self] $resultSet $watch
+	}
+	return $resultSet
+    }
+
+    # The 'ExecuteWatched' method executes the statement under a timeout
+    # of 'timeout' milliseconds. It returns a list of the result set and
+    # the handle of the timeout, which is empty if the result set is
+    # materialized, since its rows have then all been read.
+
+    method ExecuteWatched {timeout args} {
+	set watch [$connectionMy Arm $timeout]
+	if {[lindex $args 0] eq {-materialize}} {
+	    set cmd [list [namespace which my] ExecuteMaterialized \
+			 {*}[lrange $args 1 end]]
+	} else {
+	    set cmd [list [self] resultSetCreate \
+			 [namespace current]::ResultSet::[incr resultSetSeq] \
+			 [self] {*}$args]
+	}
+	if {[catch {uplevel 1 $cmd} resultSet options]} {
+	    if {[$connectionMy Disarm $watch]} {
+		::tdbc::QueryCanceledError timeout $timeout
+	    }
+	    return -options $options $resultSet
+	}
+	if {[lindex $args 0] eq {-materialize}} {
+	    $connectionMy Disarm $watch
+	    set watch {}
+	}
+	return [list $resultSet $watch]
+    }
+
+    # The 'ExecuteMaterialized' method executes the statement, reads
+    # the first set of results into a materialized result set, and
+    # closes the driver's result set. The materialized result set is
+    # named like any other result set of the statement, so that it
+    # appears in [$statement resultsets] and is destroyed with the
+    # statement.
+
+    method ExecuteMaterialized args {
+	set budget 0
+	if {$connectionMy ne {}} {
+	    set budget [$connectionMy MemoryBudget]
+	}
+	set resultSet [uplevel 1 \
+			   [list [self] resultSetCreate \
+				[namespace current]::ResultSet::[incr resultSetSeq] \
+				[self] {*}$args]]
+	set status [catch {
+	    ::tdbc::Materialize \
+		[namespace current]::ResultSet::[incr resultSetSeq] $resultSet \
+		$budget
+	} result options]
+	catch {
+	    rename $resultSet {}
+	}
+	return -options $options $result
+    }
+
+    # The 'ResultSetCreate' method is expected to be a forward to the
+    # appropriate result set constructor. If it's missing, the driver must
+    # have been designed for tdbc 1.0b9 and earlier, and the 'resultSetClass'
+    # variable holds the class name.
+
+    method resultSetCreate {name instance args} {
+	return [uplevel 1 [list $resultSetClass create \
+			       $name $instance {*}$args]]
+    }
+
+    # The 'resultsets' method returns a list of result sets produced by
+    # the current statement
+
+    method resultsets {} {
+	info commands ResultSet::*
+    }
+
+    # The 'allrows' method executes a statement with a given set of
+    # substituents, and returns a list of all the rows that the statement
+    # returns.  Optionally, it stores the names of columns in
+    # '-columnsvariable'.
+    #
+    # Usage:
+    #	$statement allrows ?-as lists|dicts? ?-columnsvariable varName?
+    #		?-intern columns? ?-timeout ms? ?--? ?dictionary?
+
+
+    method allrows args {
+
+	variable ::tdbc::generalError
+
+	# Grab keyword-value parameters
+
+	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+	::tdbc::CheckRowOptions $opts
+	set timeout {}
+	if {[dict exists $opts -timeout]} {
+	    set timeout [dict get $opts -timeout]
+	    dict unset opts -timeout
+	}
+
+	# Check postitional parameters 
+
+	set cmd [list [self] execute]
+	if {[llength $args] == 0} {
+	    # do nothing
+	} elseif {[llength $args] == 1} {
+	    lappend cmd [lindex $args 0]
+	} else {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... ?--? ?dictionary?"
+	}
+
+	# If the driver can execute the statement without a result set,
+	# let it do so, unless the execution has a timeout, which needs a
+	# result set to track it, or interns values, which needs a result
+	# set to hold the shared values.
+
+	if {[my HasExecuteDirect] && $timeout in {{} 0}
+	    && ![dict exists $opts -intern]} {
+	    set bindings [my BoundValues [lrange $cmd 2 end]]
+	    set defaultTimeout 0
+	    if {$connectionMy ne {}} {
+		set defaultTimeout [$connectionMy QueryTimeout]
+	    }
+	    if {$timeout ne {} || $defaultTimeout == 0} {
+		if {$connectionMy ne {}} {
+		    $connectionMy StatementExecuting [self] $sqlClass 0
+		}
+		set start [clock microseconds]
+		set failed [catch {
+		    my executeDirect [dict get $opts -as] $bindings
+		} result options]
+		if {$fingerprint ne {}} {
+		    ::tdbc::RecordQueryStats record $fingerprint \
+			[expr {[clock microseconds] - $start}] $failed \
+			[expr {$failed ? 0 : [llength [lindex $result 1]]}]
+		}
+		if {$failed} {
+		    return -options $options $result
+		}
+		lassign $result columns rows
+		if {$connectionMy ne {}} {
+		    set budget [$connectionMy MemoryBudget]
+		    if {$budget > 0 && [::tdbc::SizeOf $rows] > $budget} {
+			::tdbc::MemoryLimitError
 		    }
 		}
+		if {[dict exists $opts -columnsvariable]} {
+		    upvar 1 [dict get $opts -columnsvariable] columnsVar
+		    set columnsVar $columns
+		}
+		return $rows
+	    }
+	}
+
+	# Get the result set
+
+	if {$timeout ne {}} {
+	    set cmd [linsert $cmd 2 -timeout $timeout]
+	}
+	set resultSet [uplevel 1 $cmd]
+
+	# Delegate to the result set's [allrows] method to accumulate
+	# the rows of the result.
+
+	set cmd [list $resultSet allrows {*}$opts]
+	set status [catch {
+	    uplevel 1 $cmd
+	} result options]
+	if {$fingerprint ne {}} {
+	    ::tdbc::RecordQueryStats rows $fingerprint \
+		[expr {$status == 0 ? [llength $result] : 0}] [expr {$status == 1}]
+	}
+
+	# Destroy the result set
+
+	catch {
+	    rename $resultSet {}
+	}
+
+	# Adjust return level in the case that the script [return]s
+
+	if {$status == 2} {
+	    set options [dict merge {-level 1} $options[set options {}]]
+	    dict incr options -level
+	}
+	return -options $options $result
+    }
+
+    # The 'run' method executes a statement with a given set of
+    # substituents, and returns the number of rows affected, without
+    # leaving a result set behind.
+    #
+    # Usage:
+    #	$statement run ?dictionary?
+
+    method run args {
+
+	variable ::tdbc::generalError
+
+	if {[llength $args] > 1} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?dictionary?"
+	}
+
+	# If the driver can execute the statement without a result set,
+	# let it do so, unless the connection has a '-querytimeout'.
+
+	if {[my HasExecuteDirect]} {
+	    set bindings [my BoundValues $args]
+	    set timeout 0
+	    if {$connectionMy ne {}} {
+		set timeout [$connectionMy QueryTimeout]
+	    }
+	    if {$timeout == 0} {
+		if {$connectionMy ne {}} {
+		    $connectionMy StatementExecuting [self] $sqlClass 0
+		}
+		set start [clock microseconds]
+		set failed [catch {
+		    my executeDirect rowcount $bindings
+		} result options]
+		if {$fingerprint ne {}} {
+		    ::tdbc::RecordQueryStats record $fingerprint \
+			[expr {[clock microseconds] - $start}] $failed \
+			[expr {$failed ? 0 : $result}]
+		}
+		if {$failed} {
+		    return -options $options $result
+		}
+		return $result
+	    }
+	}
+
+	# Otherwise, get a result set, ask it for the row count, and
+	# destroy it.
+
+	set resultSet [uplevel 1 [list [self] execute {*}$args]]
+	set status [catch {
+	    $resultSet rowcount
+	} result options]
+	if {$fingerprint ne {}} {
+	    ::tdbc::RecordQueryStats rows $fingerprint \
+		[expr {$status == 0 ? $result : 0}] $status
+	}
+	catch {
+	    rename $resultSet {}
+	}
+	return -options $options $result
+    }
+
+    # The 'memory' method returns an estimate of the number of bytes
+    # that the statement holds. The base class counts the statement's
+    # variables; drivers that keep buffers elsewhere should override it.
+
+    method memory {} {
+	::tdbc::ObjectMemory [self]
+    }
+
+    # Drivers may implement an 'executeDirect' method, which executes the
+    # statement without creating a result set object, for the use of
+    # 'run' and 'allrows'. It accepts a mode and a dictionary of bound
+    # values. If the mode is 'rowcount', it returns the number of rows
+    # affected; if it is 'dicts' or 'lists', it returns a two-element list
+    # of the column names and the rows of the result in that form.
+
+    # The 'HasExecuteDirect' method determines, once per statement,
+    # whether the driver implements 'executeDirect'.
+
+    method HasExecuteDirect {} {
+	if {![info exists hasExecuteDirect]} {
+	    set hasExecuteDirect \
+		[expr {{executeDirect} in [info object methods [self] -all]}]
+	}
+	return $hasExecuteDirect
+    }
+
+    # The 'BoundValues' method returns the dictionary of bound values for
+    # an execution. 'argv' is the list of the optional dictionary
+    # argument; if it is empty, the values are taken from the variables
+    # of the caller of the public method. The values of the literals
+    # that '-autoparameterize' replaced are added.
+
+    method BoundValues {argv} {
+	if {[llength $argv] == 1} {
+	    set bindings [lindex $argv 0]
+	} else {
+	    set bindings {}
+	    foreach name [dict keys [my params]] {
+		upvar 2 $name value
+		if {[info exists value]} {
+		    dict set bindings $name $value
+		}
+	    }
+	}
+	if {[dict size $literals] > 0} {
+	    set bindings [dict merge $bindings $literals]
+	}
+	if {[::tdbc::StreamParamCount] > 0 && ![my HasStreamParams]} {
+	    set bindings [::tdbc::ExpandStreamParams $bindings]
+	}
+	return $bindings
+    }
+
+    # Drivers may implement a 'streamParams' method, returning 1, to
+    # declare that they read the channels of the tokens made by
+    # 'tdbc::streamparam' themselves, using Tdbc_GetStreamParam and
+    # Tdbc_ReadStreamParam. For other drivers, the base class replaces the
+    # tokens with the contents of the channels.
+
+    # The 'HasStreamParams' method determines, once per statement,
+    # whether the driver reads stream parameters itself.
+
+    method HasStreamParams {} {
+	if {![info exists hasStreamParams]} {
+	    set hasStreamParams \
+		[expr {{streamParams} in [info object methods [self] -all]
+		       && [my streamParams]}]
+	}
+	return $hasStreamParams
+    }
+
+    # The 'foreach' method executes a statement with a given set of
+    # substituents.  It runs the supplied script, substituting the supplied
+    # named variable, or the variables named by '-variables' or
+    # '-columnvars'. Optionally, it stores the names of columns in
+    # '-columnsvariable'.
+    #
+    # Usage:
+    #	$statement foreach ?-as lists|dicts? ?-columnsvariable varName?
+    #		?-intern columns? ?-timeout ms? ?--? variableName ?dictionary?
+    #		script
+    #	$statement foreach ?-variables varNames|-columnvars boolean?
+    #		?-option value?... ?--? ?dictionary? script
+
+    method foreach args {
+
+	variable ::tdbc::generalError
+
+	# Grab keyword-value parameters
+
+	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+	
+	# Check positional parameters
+
+	set cmd [list [self] execute]
+	if {[dict exists $opts -timeout]} {
+	    lappend cmd -timeout [dict get $opts -timeout]
+	    dict unset opts -timeout
+	}
+	set bind [expr {[dict exists $opts -variables]
+			|| [dict exists $opts -columnvars]}]
+	if {$bind} {
+	    set args [linsert $args[set args {}] 0 {}]
+	    set usage {}
+	} else {
+	    set usage {varName }
+	}
+	if {[llength $args] == 2} {
+	    lassign $args varname script
+	} elseif {[llength $args] == 3} {
+	    lassign $args varname dict script
+	    lappend cmd $dict
+	} else {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... ?--? ${usage}?dictionary? script"
+	}
+
+	# Get the result set
+
+	set resultSet [uplevel 1 $cmd]
+
+	# Delegate to the result set's [foreach] method to evaluate
+	# the script for each row of the result.
+
+	set cmd [list $resultSet foreach {*}$opts --]
+	if {!$bind} {
+	    lappend cmd $varname
+	}
+	lappend cmd $script
+	set status [catch {
+	    uplevel 1 $cmd
+	} result options]
+
+	# Destroy the result set
+
+	catch {
+	    rename $resultSet {}
+	}
+
+	# Adjust return level in the case that the script [return]s
+
+	if {$status == 2} {
+	    set options [dict merge {-level 1} $options[set options {}]]
+	    dict incr options -level
+	}
+	return -options $options $result
+    }
+
+    # The 'close' method is syntactic sugar for invoking the destructor
+
+    method close {} {
+	my destroy
+    }
+
+    # Derived classes are expected to implement their own constructors,
+    # plus the following methods:
+
+    # paramtype paramName ?direction? type ?scale ?precision??
+    #     Declares the type of a parameter in the statement
+
+}
+
+#------------------------------------------------------------------------------
+#
+# Class: tdbc::resultset
+#
+#	Class that represents a result set in a generic database.
+#
+#------------------------------------------------------------------------------
+
+oo::class create tdbc::resultset {
+
+    # currentRow is a list of the form of the row most recently fetched
+    #	('lists' or 'dicts') and the row itself, or empty if no row is
+    #	current. It is kept only if trackRows is 1.
+    # trackRows is 1 if the driver does not implement 'blobRead', so
+    #	that 'blobchannel' has to read LOBs from the fetched rows.
+    # memoryAccount is the 'my' command of the connection that 'allrows'
+    #	charges for the rows it gathers under the connection's -maxmemory
+    #	option, or empty for no limit.
+    # watched is 1 if the result set has a timeout or has been canceled,
+    #	so that its rows must be read through the driver's methods, which
+    #	the tdbc::DeadlineHooks mixin checks.
+    # watch is a list of the 'my' command of the connection, the handle
+    #	of the timeout, the deadline in milliseconds and the timeout, or
+    #	empty if the result set has no timeout.
+    # canceled is 'timeout' or 'cancel' once the query has been canceled,
+    #	and empty before.
+
+    variable currentRow trackRows memoryAccount watched watch canceled
+
+    # The base class constructor accepts no arguments. If the driver
+    # cannot read LOBs a chunk at a time, it applies a mixin that keeps
+    # the current row for 'blobchannel'.
+
+    constructor {} {
+	set currentRow {}
+	set memoryAccount {}
+	set watched 0
+	set watch {}
+	set canceled {}
+	set trackRows [expr {{blobRead} ni [info object methods [self] -all]}]
+	if {$trackRows} {
+	    oo::objdefine [self] mixin {*}[info object mixins [self]] \
+		::tdbc::ResultSetHooks
+	}
+    }
+
+    # The 'allrows' method returns a list of all rows that a given
+    # result set returns.
+
+    method allrows args {
+
+	variable ::tdbc::generalError
+
+	# Parse args
+
+	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+	::tdbc::CheckRowOptions $opts
+	if {[llength $args] != 0} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... ?--? varName script"
+	}
+	if {[dict exists $opts -timeout]} {
+	    set errorcode $generalError
+	    lappend errorcode badOption -timeout
+	    return -code error -errorcode $errorcode \
+		"option \"-timeout\" must be given when the statement\
+                 is executed"
+	}
+
+	# Do -columnsvariable if requested
+
+	if {[dict exists $opts -columnsvariable]} {
+	    upvar 1 [dict get $opts -columnsvariable] columns
+	}
+
+	# Give the result set a table of shared values if -intern is
+	# requested.
+
+	set intern [dict exists $opts -intern]
+	if {$intern} {
+	    ::tdbc::Intern attach [self] [dict get $opts -intern]
+	}
+
+	# If the driver has attached a table of C procedures to the result
+	# set, fetch the rows through it.
+
+	if {!$watched && [::tdbc::ResultSetType [self]] ne {}} {
+	    set budget 0
+	    if {$memoryAccount ne {}} {
+		set budget [$memoryAccount MemoryBudget]
+	    }
+	    lassign [::tdbc::FetchAll [self] [dict get $opts -as] $budget] \
+		columns results
+	    return $results
+	}
+
+	# Assemble the results
+
+	set as [dict get $opts -as]
+	if {$as eq {lists}} {
+	    set delegate nextlist
+	} else {
+	    set delegate nextdict
+	}
+	set results [list]
+	set size 0
+	try {
+	    while {1} {
+		set columns [my columns]
+		while {[my $delegate row]} {
+		    if {$intern} {
+			set row [::tdbc::Intern row [self] $as $columns $row]
+		    }
+		    if {$memoryAccount ne {}} {
+			set bytes [::tdbc::SizeOf $row]
+			$memoryAccount MemoryCharge $bytes
+			incr size $bytes
+		    }
+		    lappend results $row
+		}
+		if {![my nextresults]} break
+	    }
+	} finally {
+
+	    # The rows are the caller's once they are returned.
+
+	    if {$size > 0} {
+		$memoryAccount MemoryRelease $size
+	    }
+	}
+	return $results
+	    
+    }
+
+    # The 'memory' method returns an estimate of the number of bytes
+    # that the result set holds. The base class counts the result set's
+    # variables; drivers that keep buffers elsewhere should override it.
+
+    method memory {} {
+	::tdbc::ObjectMemory [self]
+    }
+
+    # The 'MemoryAccount' method is called by the connection when the
+    # result set is registered, to give 'allrows' the connection to
+    # charge under its -maxmemory option.
+
+    method MemoryAccount {account} {
+	set memoryAccount $account
+    }
+
+    # The 'foreach' method runs a script on each row from a result set.
+    # The row is stored in a variable, or its cells are stored in the
+    # variables named by '-variables', or by the columns' names with
+    # '-columnvars'.
+
+    method foreach args {
+
+	variable ::tdbc::generalError
+
+	# Grab keyword-value parameters
+
+	set args [::tdbc::ParseConvenienceArgs $args[set args {}] opts]
+
+	# With -variables or -columnvars, the cells of each row are stored
+	# in variables in the caller's scope, and there is no row variable.
+
+	set bind [expr {[dict exists $opts -variables]
+			|| [dict exists $opts -columnvars]}]
+
+	# Check positional parameters
+
+	if {[llength $args] != 2 - $bind} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    if {$bind} {
+		set usage script
+	    } else {
+		set usage "varName script"
+	    }
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... ?--? $usage"
+	}
+	set script [lindex $args end]
+	if {[dict exists $opts -variables] && [dict exists $opts -columnvars]} {
+	    set errorcode $generalError
+	    lappend errorcode badOption -columnvars
+	    return -code error -errorcode $errorcode \
+		"options \"-variables\" and \"-columnvars\" cannot be\
+                 used together"
+	}
+	if {[dict exists $opts -timeout]} {
+	    set errorcode $generalError
+	    lappend errorcode badOption -timeout
+	    return -code error -errorcode $errorcode \
+		"option \"-timeout\" must be given when the statement\
+                 is executed"
+	}
+
+	# Do -columnsvariable if requested
+	    
+	if {[dict exists $opts -columnsvariable]} {
+	    upvar 1 [dict get $opts -columnsvariable] columns
+	}
+
+	# Give the result set a table of shared values if -intern is
+	# requested. Rows fetched through C procedures are interned as they
+	# are built; rows fetched through the driver's methods are interned
+	# afterward.
+
+	set intern 0
+	if {[dict exists $opts -intern]} {
+	    ::tdbc::Intern attach [self] [dict get $opts -intern]
+	    set intern 1
+	}
+
+	# Fetch rows through the driver's table of C procedures if it has
+	# attached one to the result set, and through its methods otherwise.
+
+	set as [dict get $opts -as]
+	set direct [expr {!$watched && [::tdbc::ResultSetType [self]] ne {}}]
+
+	# When cells are stored in variables, the C procedures run the whole
+	# loop in the caller's scope, without building rows.
+
+	if {$direct && $bind} {
+	    set cmd [list ::tdbc::ForeachVars [self] $as]
+	    if {[dict exists $opts -variables]} {
+		lappend cmd -variables [dict get $opts -variables]
+	    }
+	    if {[dict exists $opts -columnsvariable]} {
+		lappend cmd [dict get $opts -columnsvariable]
+	    } else {
+		lappend cmd {}
+	    }
+	    lappend cmd $script
+	    if {$trackRows} {
+		set currentRow {}
+	    }
+	    set status [catch {
+		uplevel 1 $cmd
+	    } result options]
+	    if {$status == 0} {
+		return
+	    }
+	    if {$status == 2} {
+		set options [dict merge {-level 1} $options[set options {}]]
+		dict incr options -level
+	    }
+	    return -options $options $result
+	}
+	if {$direct} {
+	    set fetch [list ::tdbc::FetchRow [self] $as row]
+	    set intern 0
+	} elseif {$as eq {lists}} {
+	    set fetch [list my nextlist row]
+	} else {
+	    set fetch [list my nextdict row]
+	}
+
+	# Iterate over the groups of results 
+	while {1} {
+
+	    # Export column names to caller
+
+	    set columns [my columns]
+
+	    # Link the variables that receive the row or its cells. The
+	    # cells are reached through local links 'var0', 'var1', ...
+
+	    if {!$bind} {
+		upvar 1 [lindex $args 0] row
+	    } else {
+		if {[dict exists $opts -variables]} {
+		    set names [dict get $opts -variables]
+		} else {
+		    set names $columns
+		}
+		set links {}
+		foreach name $names {
+		    upvar 1 $name var[llength $links]
+		    lappend links var[llength $links]
+		}
+	    }
+
+	    # Iterate over the rows of one group of results
+
+	    while {[{*}$fetch]} {
+		if {$intern} {
+		    set row [::tdbc::Intern row [self] $as $columns $row]
+		}
+		if {!$bind} {
+		    if {$trackRows} {
+			set currentRow [list $as $row]
+		    }
+		} elseif {$as eq {lists}} {
+		    lassign $row {*}$links
+		} else {
+		    foreach link $links column $columns {
+			if {$link eq {}} {
+			    break
+			} elseif {[dict exists $row $column]} {
+			    set $link [dict get $row $column]
+			} else {
+			    unset -nocomplain $link
+			}
+		    }
+		}
+		set status [catch {
+		    uplevel 1 $script
+		} result options]
+		switch -exact -- $status {
+		    0 - 4 {	# OK or CONTINUE
+		    }
+		    2 {		# RETURN
+			set options \
+			    [dict merge {-level 1} $options[set options {}]]
+			dict incr options -level
+			return -options $options $result
+		    }
+		    3 {		# BREAK
+			set broken 1
+			break
+		    }
+		    default {	# ERROR or unknown status
+			return -options $options $result
+		    }
+		}
+	    }
+
+	    # Advance to the next group of results if there is one
+
+	    if {[info exists broken] || ![my nextresults]} {
+		break
+	    }
+	}	
+
+	return
+    }
+
+    
+    # The 'nextrow' method retrieves a row in the form of either
+    # a list or a dictionary.
+
+    method nextrow {args} {
+
+	variable ::tdbc::generalError
+
+	set opts [dict create -as dicts]
+	set i 0
+    
+	# Munch keyword options off the front of the command arguments
+	
+	foreach {key value} $args {
+	    if {[string index $key 0] eq {-}} {
+		switch -regexp -- $key {
+		    -as? {
+			dict set opts -as $value
+		    }
+		    -- {
+			incr i
+			break
+		    }
+		    default {
+			set errorcode $generalError
+			lappend errorcode badOption $key
+			return -code error -errorcode $errorcode \
+			    "bad option \"$key\":\
+                             must be -as or -columnsvariable"
+		    }
+		}
+	    } else {
+		break
+	    }
+	    incr i 2
+	}
+
+	set args [lrange $args $i end]
+	if {[llength $args] != 1} {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [lrange [info level 0] 0 1]\
+                 ?-option value?... ?--? varName"
+	}
+	upvar 1 [lindex $args 0] row
+	if {[dict get $opts -as] eq {lists}} {
+	    set as lists
+	    set delegate nextlist
+	} else {
+	    set as dicts
+	    set delegate nextdict
+	}
+	if {!$watched && [::tdbc::ResultSetType [self]] ne {}} {
+	    set found [::tdbc::FetchRow [self] $as row]
+	    if {$trackRows} {
+		set currentRow [expr {$found ? [list $as $row] : {}}]
+	    }
+	    return $found
+	}
+	return [my $delegate row]
+    }
+
+    # The 'blobchannel' method is defined on first use, by 'LazyBlobchannel'.
+
+    method blobchannel {column} {
+	::tdbc::DefineLazy
+	tailcall my LazyBlobchannel $column
+    }
+
+    # The 'cancel' method cancels the query: the result set reports
+    # QUERY_CANCELED when it is next read and, if it has a timeout, the
+    # driver is asked to abandon the statement.
+
+    method cancel {} {
+	my Canceled
+	if {$watch ne {}} {
+	    [lindex $watch 0] CancelQuery
+	}
+	return
+    }
+
+    # The 'Watch' method is called by the connection when the result set
+    # is registered with a timeout.
+
+    method Watch {owner handle deadline timeout} {
+	set watch [list $owner $handle $deadline $timeout]
+	my WatchRows
+    }
+
+    # The 'Canceled' method marks the result set as canceled by the
+    # application.
+
+    method Canceled {} {
+	set canceled cancel
+	my WatchRows
+    }
+
+    # The 'WatchRows' method makes the rows be read through the driver's
+    # methods, and checks them with the tdbc::DeadlineHooks mixin.
+
+    method WatchRows {} {
+	if {!$watched} {
+	    set watched 1
+	    oo::objdefine [self] mixin \
+		::tdbc::DeadlineHooks {*}[info object mixins [self]]
+	}
+    }
+
+    # The 'CheckCanceled' method throws QUERY_CANCELED if the query has
+    # been canceled or has overrun its timeout. If 'failed' is 1, the
+    # driver has just reported an error, and the error is replaced if the
+    # timeout fired.
+
+    method CheckCanceled {{failed 0}} {
+	if {$canceled eq {} && $watch ne {}} {
+	    lassign $watch owner handle deadline
+	    if {$failed ? [$owner Fired $handle]
+		: [clock milliseconds] >= $deadline} {
+		set canceled timeout
+		$owner Disarm $handle
+	    }
+	}
+	if {$canceled ne {}} {
+	    ::tdbc::QueryCanceledError $canceled [lindex $watch 3]
+	}
+    }
+
+    # Derived classes must override 'nextresults' if a single
+    # statement execution can yield multiple sets of results
+
+    method nextresults {} {
+	return 0
+    }
+
+    # Derived classes must override 'outputparams' if statements can
+    # have output parameters.
+
+    method outputparams {} {
+	return {}
+    }
+
+    # The 'close' method is syntactic sugar for destroying the result set.
+
+    method close {} {
+	my destroy
+    }
+
+    # The destructor stops a thread that reads rows ahead, which must not
+    # be inside the driver when the driver frees the result set. A driver
+    # whose result sets have a destructor should call [next] first.
+
+    destructor {
+	if {[::tdbc::ResultSetType [self]] eq {prefetch}} {
+	    ::tdbc::Prefetch [self] stop
+	}
+    }
+
+    # Derived classes are expected to implement the following methods:
+
+    # constructor and destructor.  
+    #        Constructor accepts a statement and an optional
+    #        a dictionary of substituted parameters  and
+    #        executes the statement against the database. If
+    #	     the dictionary is not supplied, then the default
+    #	     is to get params from variables in the caller's scope).
+    # columns
+    #     -- Returns a list of the names of the columns in the result.
+    # nextdict variableName
+    #     -- Stores the next row of the result set in the given variable
+    #        in caller's scope, in the form of a dictionary that maps
+    #	     column names to values.
+    # nextlist variableName
+    #     -- Stores the next row of the result set in the given variable
+    #        in caller's scope, in the form of a list of cells.
+    # blobRead column offset count
+    #     -- (Optional) Returns up to 'count' bytes of the value of the
+    #        given column in the current row, starting at byte 'offset',
+    #        or an empty string at the end of the value.
+    # rowcount
+    #     -- Returns a count of rows affected by the statement, or -1
+    #        if the count of rows has not been determined.
+
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::ResultSetHooks --
+#
+#	Mixin that the base class constructor applies to result sets whose
+#	driver does not implement 'blobRead'. It keeps the row most recently
+#	fetched by 'nextdict' or 'nextlist', so that 'blobchannel' can read
+#	its values.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::ResultSetHooks {
+
+    variable currentRow
+
+    method nextdict {varName} {
+	upvar 1 $varName row
+	if {[next $varName]} {
+	    set currentRow [list dicts $row]
+	    return 1
+	}
+	set currentRow {}
+	return 0
+    }
+
+    method nextlist {varName} {
+	upvar 1 $varName row
+	if {[next $varName]} {
+	    set currentRow [list lists $row]
+	    return 1
+	}
+	set currentRow {}
+	return 0
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::PrefetchHooks --
+#
+#	Mixin that 'execute -prefetch' applies to a result set while a
+#	thread reads rows ahead of it. It sends the calls that would reach
+#	the driver through ::tdbc::Prefetch, which takes rows from the
+#	thread's queue and pauses the thread when the driver must be called.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::PrefetchHooks {
+
+    method columns {} {
+	::tdbc::Prefetch [self] columns
+    }
+
+    method nextdict {varName} {
+	upvar 1 $varName row
+	::tdbc::FetchRow [self] dicts row
+    }
+
+    method nextlist {varName} {
+	upvar 1 $varName row
+	::tdbc::FetchRow [self] lists row
+    }
+
+    method nextresults {} {
+	::tdbc::Prefetch [self] nextresults
+    }
+
+    method rowcount {} {
+	::tdbc::Prefetch [self] rowcount
+    }
+
+    # The driver's cursor is ahead of the caller's current row, so it
+    # cannot read a large object from that row.
+
+    method blobRead args {
+	variable ::tdbc::generalError
+	set errorcode $generalError
+	lappend errorcode prefetching
+	return -code error -errorcode $errorcode \
+	    "cannot read a large object from a result set that reads ahead"
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::DeadlineHooks --
+#
+#	Mixin applied to a result set that has a timeout or has been
+#	canceled. Before each call that reaches the driver, it throws
+#	QUERY_CANCELED if the query has been canceled or has overrun its
+#	timeout, and it reports an error from the driver as QUERY_CANCELED
+#	if the timeout canceled the query.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::DeadlineHooks {
+
+    method nextdict {varName} {
+	upvar 1 $varName row
+	my CheckCanceled
+	if {[catch {next row} result options]} {
+	    my CheckCanceled 1
+	    return -options $options $result
+	}
+	return $result
+    }
+
+    method nextlist {varName} {
+	upvar 1 $varName row
+	my CheckCanceled
+	if {[catch {next row} result options]} {
+	    my CheckCanceled 1
+	    return -options $options $result
+	}
+	return $result
+    }
+
+    method nextresults {} {
+	my CheckCanceled
+	if {[catch {next} result options]} {
+	    my CheckCanceled 1
+	    return -options $options $result
+	}
+	return $result
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::router --
+#
+#	Connection that sends each statement to one of a primary connection
+#	and several read replicas. Statements that only read are sent to a
+#	replica; statements that write, everything in a transaction, and
+#	reads within the '-readyourwrites' window after a write are sent to
+#	the primary.
+#
+# Usage:
+#	tdbc::router create name -primary db -replicas {db...} ?-option value?
+#
+# The router does not own the connections that it routes to, and does
+# not close them.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::router {
+
+    superclass ::tdbc::connection
+
+    # primary is the connection that receives writes
+    # replicas is the list of connections that receive reads
+    # routerOptions is a dictionary of the values of '-balance' and
+    #	'-readyourwrites'
+    # nextReplica is the index in 'replicas' of the replica that is next
+    #	in turn
+    # lastWrite is the time, in milliseconds, of the last write sent to
+    #	the primary
+    # inTransaction is 1 if a transaction is in progress
+
+    variable primary replicas routerOptions nextReplica lastWrite \
+	inTransaction
+
+    constructor args {
+	variable ::tdbc::generalError
+	next
+	set primary {}
+	set replicas {}
+	set routerOptions [dict create -balance roundrobin -readyourwrites 0]
+	set nextReplica 0
+	set lastWrite {}
+	set options {}
+	foreach {option value} $args {
+	    switch -exact -- $option {
+		-primary {
+		    set primary $value
+		}
+		-replicas {
+		    set replicas $value
+		}
+		default {
+		    lappend options $option $value
+		}
+	    }
+	}
+	if {$primary eq {}} {
+	    set errorcode $generalError
+	    lappend errorcode badOption -primary
+	    return -code error -errorcode $errorcode \
+		"option \"-primary\" is required"
+	}
+	if {[llength $options] > 0} {
+	    my configure {*}$options
+	}
+    }
+
+    forward statementCreate ::tdbc::routerStatement create
+
+    method Connections {} {
+	return [list $primary {*}$replicas]
+    }
+
+    # Canceling cancels the queries of every connection.
+
+    method CancelQuery {} {
+	foreach db [my Connections] {
+	    $db cancel
+	}
+    }
+
+    # Options other than the router's own are passed to the primary and
+    # every replica, and queried from the primary.
+
+    method configure args {
+	variable ::tdbc::generalError
+	if {[llength $args] == 0} {
+	    return [dict merge [$primary configure] $routerOptions \
+			[dict create -primary $primary -replicas $replicas]]
+	} elseif {[llength $args] == 1} {
+	    switch -exact -- [lindex $args 0] {
+		-primary {
+		    return $primary
+		}
+		-replicas {
+		    return $replicas
+		}
+	    }
+	    if {[dict exists $routerOptions [lindex $args 0]]} {
+		return [dict get $routerOptions [lindex $args 0]]
+	    }
+	    return [$primary configure [lindex $args 0]]
+	}
+	set driverArgs {}
+	foreach {option value} $args {
+	    switch -exact -- $option {
+		-balance {
+		    if {$value ni {leastoutstanding roundrobin}} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $option $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$option\":\
+                             must be leastoutstanding or roundrobin"
+		    }
+		    dict set routerOptions $option $value
+		}
+		-readyourwrites {
+		    if {![string is entier -strict $value] || $value < 0} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $option $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$option\""
+		    }
+		    dict set routerOptions $option $value
+		}
+		-primary - -replicas {
+		    set errorcode $generalError
+		    lappend errorcode readOnlyOption $option
+		    return -code error -errorcode $errorcode \
+			"option \"$option\" can only be set when the\
+                         router is created"
+		}
+		default {
+		    lappend driverArgs $option $value
+		}
+	    }
+	}
+	if {[llength $driverArgs] > 0} {
+	    foreach db [list $primary {*}$replicas] {
+		$db configure {*}$driverArgs
+	    }
+	}
+	return
+    }
+
+    # The 'Route' method chooses the connection that executes a statement,
+    # given the statement's classification from tdbc::classify.
+
+    method Route {sqlClass} {
+	if {$inTransaction || ![dict get $sqlClass readonly]} {
+	    set lastWrite [clock milliseconds]
+	    return $primary
+	}
+	if {[llength $replicas] == 0} {
+	    return $primary
+	}
+	set window [dict get $routerOptions -readyourwrites]
+	if {$window > 0 && $lastWrite ne {}
+	    && [clock milliseconds] - $lastWrite < $window} {
+	    return $primary
+	}
+
+	# Take replicas in turn, or the replica with the fewest open result
+	# sets, preferring the one next in turn when several are equal.
+
+	set n [llength $replicas]
+	set chosen $nextReplica
+	if {[dict get $routerOptions -balance] eq {leastoutstanding}} {
+	    set least {}
+	    for {set i 0} {$i < $n} {incr i} {
+		set j [expr {($nextReplica + $i) % $n}]
+		set count [llength [[lindex $replicas $j] resultsets]]
+		if {$least eq {} || $count < $least} {
+		    set least $count
+		    set chosen $j
+		}
+	    }
+	}
+	set nextReplica [expr {($chosen + 1) % $n}]
+	return [lindex $replicas $chosen]
+    }
+
+    # Transactions, stored procedures and metadata go to the primary.
+
+    method begintransaction {} {
+	$primary begintransaction
+    }
+
+    method commit {} {
+	set lastWrite [clock milliseconds]
+	$primary commit
+    }
+
+    method rollback {} {
+	$primary rollback
+    }
+
+    method prepareCall {call} {
+	$primary prepareCall $call
+    }
+
+    method tables args {
+	$primary tables {*}$args
+    }
+
+    method columns args {
+	$primary columns {*}$args
+    }
+
+    method primarykeys {tableName} {
+	$primary primarykeys $tableName
+    }
+
+    method foreignkeys args {
+	$primary foreignkeys {*}$args
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::ProxyStatement --
+#
+#	Base class of the statements of connections, such as tdbc::router
+#	and tdbc::sharded, that execute statements on other connections.
+#	The statement is prepared on each of those connections the first
+#	time that it is needed there. The owning connection must implement
+#	a 'Connections' method that lists them, the first being the one
+#	that describes the statement's parameters.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::ProxyStatement {
+
+    superclass ::tdbc::statement
+
+    # owner is the connection that prepared the statement
+    # sql is the SQL code of the statement
+    # statements is a dictionary whose keys are connections and whose
+    #	values are the statements prepared on them
+    # paramTypes is a list of the argument lists of calls to 'paramtype',
+    #	which are repeated on each statement prepared
+
+    variable owner sql statements paramTypes connectionMy countCalls
+
+    # The statements prepared on the other connections count the
+    # executions in the query statistics.
+
+    constructor {connection sqlcode} {
+	next
+	set countCalls 0
+	set owner $connection
+	set sql $sqlcode
+	set statements {}
+	set paramTypes {}
+    }
+
+    # The 'Prepared' method returns the statement prepared on a
+    # connection, preparing it if necessary. The connection may have
+    # closed the statement to stay within its -maxstatements limit, in
+    # which case it is prepared again.
+
+    method Prepared {db} {
+	if {![dict exists $statements $db]
+	    || [info commands [dict get $statements $db]] eq {}} {
+	    set stmt [$db prepare $sql]
+	    foreach argv $paramTypes {
+		$stmt paramtype {*}$argv
+	    }
+	    dict set statements $db $stmt
+	}
+	return [dict get $statements $db]
+    }
+
+    method connection {} {
+	return $owner
+    }
+
+    method params {} {
+	[my Prepared [lindex [$connectionMy Connections] 0]] params
+    }
+
+    method paramtype args {
+	dict for {db stmt} $statements {
+	    $stmt paramtype {*}$args
+	}
+	lappend paramTypes $args
+	return
+    }
+
+    destructor {
+	dict for {db stmt} $statements {
+	    catch {$stmt close}
+	}
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::routerStatement --
+#
+#	Statement prepared on a tdbc::router. Each execution is sent to the
+#	connection that the router chooses.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::routerStatement {
+
+    superclass ::tdbc::ProxyStatement
+
+    variable statements connectionMy sqlClass literals
+
+    # The values of the literals that '-autoparameterize' replaced are
+    # passed to the routed statement with the other bound values. The
+    # options of 'execute' are passed on as they were given.
+
+    method execute args {
+	set db [$connectionMy Route $sqlClass]
+	set timeout [$connectionMy StatementExecuting [self] $sqlClass]
+	set i 0
+	while {[lindex $args $i] in {-materialize -prefetch -timeout}} {
+	    incr i [expr {[lindex $args $i] eq {-materialize} ? 1 : 2}]
+	}
+	if {[dict size $literals] > 0} {
+	    set args [list {*}[lrange $args 0 $i-1] \
+			  [my BoundValues [lrange $args $i end]]]
+	}
+	if {$timeout > 0 && {-timeout} ni [lrange $args 0 $i-1]} {
+	    set args [list -timeout $timeout {*}$args]
+	}
+	set resultSet [uplevel 1 [list [my Prepared $db] execute {*}$args]]
+	$connectionMy RegisterResultSet [self] $resultSet
+	return $resultSet
+    }
+
+    # The result sets belong to the statements prepared on the primary
+    # and replicas.
+
+    method resultsets {} {
+	set result {}
+	dict for {db stmt} $statements {
+	    lappend result {*}[$stmt resultsets]
+	}
+	return $result
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::sharded --
+#
+#	Connection over several shards of a database, each reached through
+#	a connection of its own. A statement whose bound values include the
+#	shard key is executed on the shard that the key's value maps to;
+#	any other statement is executed on every shard, and the rows are
+#	merged into a single result set.
+#
+# Usage:
+#	tdbc::sharded create name -shards {db...} ?-option value?
+#
+# The sharded connection does not own the shards' connections, and does
+# not close them.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::sharded {
+
+    superclass ::tdbc::connection
+
+    # shards is the list of the shards' connections
+    # shardOptions is a dictionary of the values of '-nullsort',
+    #	'-shardkey' and '-shardmap'
+    # ring is the hash ring used when there is no '-shardmap': a list
+    #	of pairs of a hash value and the index of a shard, sorted by
+    #	hash value
+
+    variable shards shardOptions ring
+
+    constructor args {
+	variable ::tdbc::generalError
+	next
+	set shards {}
+	set shardOptions [dict create -nullsort low -shardkey {} -shardmap {}]
+	set options {}
+	foreach {option value} $args {
+	    if {$option eq {-shards}} {
+		set shards $value
+	    } else {
+		lappend options $option $value
+	    }
+	}
+	if {[llength $shards] == 0} {
+	    set errorcode $generalError
+	    lappend errorcode badOption -shards
+	    return -code error -errorcode $errorcode \
+		"option \"-shards\" is required"
+	}
+
+	# Place points for each shard on the ring, so that adding a shard
+	# moves only the keys that fall on its points.
+
+	set ring {}
+	for {set i 0} {$i < [llength $shards]} {incr i} {
+	    for {set j 0} {$j < 64} {incr j} {
+		lappend ring [list [zlib crc32 shard$i.$j] $i]
+	    }
+	}
+	set ring [lsort -integer -index 0 $ring]
+	if {[llength $options] > 0} {
+	    my configure {*}$options
+	}
+    }
+
+    forward statementCreate ::tdbc::shardedStatement create
+
+    method Connections {} {
+	return $shards
+    }
+
+    # Canceling cancels the queries of every connection.
+
+    method CancelQuery {} {
+	foreach db [my Connections] {
+	    $db cancel
+	}
+    }
+
+    # Options other than the sharded connection's own are passed to every
+    # shard, and queried from the first.
+
+    method configure args {
+	variable ::tdbc::generalError
+	if {[llength $args] == 0} {
+	    return [dict merge [[lindex $shards 0] configure] $shardOptions \
+			[dict create -shards $shards]]
+	} elseif {[llength $args] == 1} {
+	    if {[lindex $args 0] eq {-shards}} {
+		return $shards
+	    }
+	    if {[dict exists $shardOptions [lindex $args 0]]} {
+		return [dict get $shardOptions [lindex $args 0]]
+	    }
+	    return [[lindex $shards 0] configure [lindex $args 0]]
+	}
+	set driverArgs {}
+	foreach {option value} $args {
+	    switch -exact -- $option {
+		-nullsort {
+		    if {$value ni {low high}} {
+			set errorcode $generalError
+			lappend errorcode badOptionValue $option $value
+			return -code error -errorcode $errorcode \
+			    "bad value \"$value\" for option \"$option\":\
+                             must be low or high"
+		    }
+		    dict set shardOptions $option $value
+		}
+		-shardkey - -shardmap {
+		    dict set shardOptions $option $value
+		}
+		-shards {
+		    set errorcode $generalError
+		    lappend errorcode readOnlyOption $option
+		    return -code error -errorcode $errorcode \
+			"option \"$option\" can only be set when the\
+                         connection is created"
+		}
+		default {
+		    lappend driverArgs $option $value
+		}
+	    }
+	}
+	if {[llength $driverArgs] > 0} {
+	    foreach db $shards {
+		$db configure {*}$driverArgs
+	    }
+	}
+	return
+    }
+
+    # The 'Targets' method returns the connections on which to execute a
+    # statement, given the dictionary of its bound values.
+
+    method Targets {bindings} {
+	variable ::tdbc::generalError
+	set key [dict get $shardOptions -shardkey]
+	if {$key eq {} || ![dict exists $bindings $key]} {
+	    return $shards
+	}
+	set value [dict get $bindings $key]
+	set map [dict get $shardOptions -shardmap]
+	if {$map ne {}} {
+	    set i [{*}$map $value]
+	    if {![string is integer -strict $i]
+		|| $i < 0 || $i >= [llength $shards]} {
+		set errorcode $generalError
+		lappend errorcode badShard $i
+		return -code error -errorcode $errorcode \
+		    "shard map returned \"$i\" for \"$value\": must be an\
+                     integer from 0 to [expr {[llength $shards] - 1}]"
+	    }
+	} else {
+	    set k [lsearch -integer -sorted -bisect -index 0 $ring \
+		       [zlib crc32 $value]]
+	    set i [lindex $ring [expr {($k + 1) % [llength $ring]}] 1]
+	}
+	return [list [lindex $shards $i]]
+    }
+
+    # Transactions are begun, committed and rolled back on every shard in
+    # turn. They are not atomic across shards.
+
+    method begintransaction {} {
+	foreach db $shards {
+	    $db begintransaction
+	}
+    }
+
+    method commit {} {
+	foreach db $shards {
+	    $db commit
+	}
+    }
+
+    method rollback {} {
+	foreach db $shards {
+	    $db rollback
+	}
+    }
+
+    method prepareCall {call} {
+	variable ::tdbc::generalError
+	set errorcode $generalError
+	lappend errorcode featureNotSupported
+	return -code error -errorcode $errorcode \
+	    "stored procedures cannot be called on a sharded connection"
+    }
+
+    # Metadata comes from the first shard.
+
+    method tables args {
+	[lindex $shards 0] tables {*}$args
+    }
+
+    method columns args {
+	[lindex $shards 0] columns {*}$args
+    }
+
+    method primarykeys {tableName} {
+	[lindex $shards 0] primarykeys $tableName
+    }
+
+    method foreignkeys args {
+	[lindex $shards 0] foreignkeys {*}$args
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::shardedStatement --
+#
+#	Statement prepared on a tdbc::sharded connection.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::shardedStatement {
+
+    superclass ::tdbc::ProxyStatement
+
+    # orderBy is the statement's trailing ORDER BY clause, as returned by
+    #	tdbc::OrderByColumns
+
+    variable sql orderBy connectionMy
+
+    constructor {connection sqlcode} {
+	next $connection $sqlcode
+	set orderBy [::tdbc::OrderByColumns $sqlcode]
+    }
+
+    forward resultSetCreate ::tdbc::shardedResultSet create
+
+    method Targets {bindings} {
+	$connectionMy Targets $bindings
+    }
+
+    # The 'OrderBy' method returns the keys of the statement's ORDER BY
+    # clause. The keys that do not say where NULLs go follow the
+    # connection's -nullsort option.
+
+    method OrderBy {} {
+	set low [expr {[$connectionMy configure -nullsort] eq {low}}]
+	lmap key $orderBy {
+	    lassign $key name descending nullsFirst
+	    if {$nullsFirst eq {}} {
+		set nullsFirst [expr {$low != $descending}]
+	    }
+	    list $name $descending $nullsFirst
+	}
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::shardedResultSet --
+#
+#	Result set of a statement executed on one or more shards. The rows
+#	of the shards' result sets are returned in turn or, if the statement
+#	ends with an ORDER BY clause of plain column names, merged in that
+#	order.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::shardedResultSet {
+
+    superclass ::tdbc::resultset
+
+    # resultSets is the list of the shards' result sets
+    # columns is the list of the names of the result's columns
+    # keys is the list of the statement's ORDER BY keys, each a list of
+    #	a column name, 1 for descending order and 1 if NULLs come first
+    # orderBy is the list of 'keys', with the column names as the result
+    #	spells them, or empty if the rows are not merged in order
+    # cursor is the index in 'resultSets' of the result set being read
+    #	when the rows are not merged in order
+    # heads is a list, parallel to 'resultSets', of the next row of each
+    #	shard as a dictionary, or of an empty list if the shard has no
+    #	more rows, when the rows are merged in order
+
+    variable resultSets keys columns orderBy cursor heads
+
+    constructor {statement args} {
+	variable ::tdbc::generalError
+	next
+	if {[llength $args] == 0} {
+	    set bindings {}
+	    foreach name [dict keys [$statement params]] {
+		upvar 1 $name value
+		if {[info exists value]} {
+		    dict set bindings $name $value
+		}
+	    }
+	} elseif {[llength $args] == 1} {
+	    set bindings [lindex $args 0]
+	} else {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be\
+                 \"[lindex [info level 0] 0] statement ?dictionary?\""
+	}
+	set stmtMy [info object namespace $statement]::my
+	set resultSets {}
+	foreach db [$stmtMy Targets $bindings] {
+	    if {[catch {
+		lappend resultSets [[$stmtMy Prepared $db] execute $bindings]
+	    } result options]} {
+		foreach rs $resultSets {
+		    catch {$rs close}
+		}
+		set resultSets {}
+		return -options $options $result
+	    }
+	}
+	set keys [$stmtMy OrderBy]
+	my Start
+    }
+
+    # The 'Start' method prepares to read the current set of results.
+
+    method Start {} {
+	set columns [[lindex $resultSets 0] columns]
+	set cursor 0
+	set heads {}
+	set orderBy {}
+	if {[llength $resultSets] > 1} {
+	    foreach key $keys {
+		lassign $key name descending nullsFirst
+		set i [lsearch -exact -nocase $columns $name]
+		if {$i < 0} {
+		    set orderBy {}
+		    break
+		}
+		lappend orderBy [list [lindex $columns $i] \
+				     $descending $nullsFirst]
+	    }
+	}
+	if {[llength $orderBy] > 0} {
+	    foreach rs $resultSets {
+		lappend heads [my Fetch $rs]
+	    }
+	}
+    }
+
+    # The 'Fetch' method returns the next row of a shard's result set as a
+    # dictionary, or an empty list if there are no more rows.
+
+    method Fetch {rs} {
+	if {[$rs nextdict row]} {
+	    return [list $row]
+	}
+	return {}
+    }
+
+    method columns {} {
+	return $columns
+    }
+
+    method rowcount {} {
+	set count 0
+	foreach rs $resultSets {
+	    set n [$rs rowcount]
+	    if {$n >= 0} {
+		incr count $n
+	    }
+	}
+	return $count
+    }
+
+    # The shards that have no more results are dropped, so that the
+    # next set of results is described by a shard that has it.
+
+    method nextresults {} {
+	set more {}
+	foreach rs $resultSets {
+	    if {[$rs nextresults]} {
+		lappend more $rs
+	    }
+	}
+	if {[llength $more] == 0} {
+	    return 0
+	}
+	foreach rs $resultSets {
+	    if {$rs ni $more} {
+		catch {$rs close}
+	    }
+	}
+	set resultSets $more
+	my Start
+	return 1
+    }
+
+    method nextdict {varName} {
+	upvar 1 $varName row
+	if {[llength $orderBy] == 0} {
+	    while {$cursor < [llength $resultSets]} {
+		if {[[lindex $resultSets $cursor] nextdict row]} {
+		    return 1
+		}
+		incr cursor
+	    }
+	    return 0
+	}
+
+	# Take the least of the shards' next rows, preferring the earlier
+	# shard when rows are equal.
+
+	set best -1
+	for {set i 0} {$i < [llength $heads]} {incr i} {
+	    set head [lindex $heads $i]
+	    if {[llength $head] == 0} {
+		continue
+	    }
+	    if {$best < 0 || [::tdbc::CompareRows $orderBy [lindex $head 0] \
+				   [lindex $heads $best 0]] < 0} {
+		set best $i
+	    }
+	}
+	if {$best < 0} {
+	    return 0
+	}
+	set row [lindex $heads $best 0]
+	lset heads $best [my Fetch [lindex $resultSets $best]]
+	return 1
+    }
+
+    method nextlist {varName} {
+	upvar 1 $varName row
+	if {![my nextdict d]} {
+	    return 0
+	}
+	set row [lmap c $columns {
+	    expr {[dict exists $d $c] ? [dict get $d $c] : {}}
+	}]
+	return 1
+    }
+
+    destructor {
+	if {[info exists resultSets]} {
+	    foreach rs $resultSets {
+		catch {$rs close}
+	    }
+	}
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::MaskSql --
+#
+#	Blanks out the bound variables, strings, quoted names and comments
+#	of SQL code, so that keywords and punctuation inside them are not
+#	mistaken for the structure of the statement.
+#
+# Parameters:
+#	sqlcode - SQL code to mask
+#
+# Results:
+#	Returns a string of the same length as 'sqlcode', in which bound
+#	variables and comments are replaced by spaces, and strings and
+#	quoted names by underscores, so that they are not trimmed.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::MaskSql {sqlcode} {
+    set masked {}
+    foreach token [::tdbc::tokenize $sqlcode] {
+	if {[string index $token 0] in {: $ @} && [string length $token] > 1} {
+	    set token [string repeat " " [string length $token]]
+	}
+	append masked $token
+    }
+    set i 0
+    while {[regexp -indices -start $i {['"\[]|--|/\*} $masked match]} {
+	set start [lindex $match 0]
+	switch -exact -- [string index $masked $start] {
+	    ' - \" {
+		set end [string first [string index $masked $start] \
+			     $masked [expr {$start + 1}]]
+	    }
+	    \[ {
+		set end [string first \] $masked $start]
+	    }
+	    - {
+		set end [string first \n $masked $start]
+	    }
+	    / {
+		set end [string first */ $masked [expr {$start + 2}]]
+		if {$end >= 0} {
+		    incr end
+		}
+	    }
+	}
+	if {$end < 0} {
+	    set end [expr {[string length $masked] - 1}]
+	}
+	if {[string index $masked $start] in {' \" \[}} {
+	    set fill _
+	} else {
+	    set fill " "
+	}
+	set masked [string replace $masked $start $end \
+			[string repeat $fill [expr {$end - $start + 1}]]]
+	set i [expr {$end + 1}]
+    }
+    return $masked
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::OrderByColumns --
+#
+#	Finds the ORDER BY clause at the end of a SQL statement.
+#
+# Parameters:
+#	sqlcode - SQL code of the statement
+#
+# Results:
+#	Returns a list of the keys of the clause, each a list of the column
+#	name, 1 if the order is descending, and 1 if NULLs come first, 0 if
+#	they come last or an empty string if the clause does not say. The
+#	list is empty if there is no ORDER BY clause, or if any of its keys
+#	is not a plain column name.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::OrderByColumns {sqlcode} {
+
+    # Find the last ORDER BY at the outer level of the statement, looking
+    # past strings, quoted names and comments.
+
+    set masked [MaskSql $sqlcode]
+    set depth 0
+    set start -1
+    foreach match [regexp -all -indices -inline -nocase \
+		       {[()]|\mORDER\s+BY\M} $masked] {
+	set word [string range $masked {*}$match]
+	if {$word eq "("} {
+	    incr depth
+	} elseif {$word eq ")"} {
+	    incr depth -1
+	} elseif {$depth == 0} {
+	    set start [expr {[lindex $match 1] + 1}]
+	}
+    }
+    if {$start < 0} {
+	return {}
+    }
+    set clause [string trimright [string range $masked $start end] \
+		    " \t\r\n;"]
+    if {[string first ( $clause] >= 0 || [string first ) $clause] >= 0} {
+	return {}
+    }
+    if {[regexp -indices -nocase {\s(?:LIMIT|OFFSET|FETCH)\M} $clause \
+	     match]} {
+	set clause [string range $clause 0 [expr {[lindex $match 0] - 1}]]
+    }
+
+    # Split the clause at its commas, taking the quoted names, which the
+    # mask filled, from the SQL code.
+
+    set text [string range $sqlcode $start \
+		  [expr {$start + [string length $clause] - 1}]]
+    set plain $clause
+    foreach run [regexp -all -indices -inline {_+} $clause] {
+	set plain [string replace $plain {*}$run [string range $text {*}$run]]
+    }
+    set items {}
+    set from 0
+    foreach comma [regexp -all -indices -inline , $clause] {
+	lappend items \
+	    [string range $plain $from [expr {[lindex $comma 0] - 1}]]
+	set from [expr {[lindex $comma 0] + 1}]
+    }
+    lappend items [string range $plain $from end]
+
+    set keys {}
+    set pattern {^\s*("[^"]+"|\[[^]]+\]|[[:alpha:]_][[:alnum:]_$.]*)}
+    append pattern {(?:\s+(ASC|DESC))?(?:\s+NULLS\s+(FIRST|LAST))?\s*$}
+    foreach item $items {
+	if {![regexp -nocase $pattern $item -> name direction nulls]} {
+	    return {}
+	}
+	if {[string index $name 0] in {\" \[}} {
+	    set name [string range $name 1 end-1]
+	} else {
+	    set name [lindex [split $name .] end]
+	}
+	set descending [string equal -nocase $direction DESC]
+	set nullsFirst {}
+	if {$nulls ne {}} {
+	    set nullsFirst [string equal -nocase $nulls FIRST]
+	}
+	lappend keys [list $name $descending $nullsFirst]
+    }
+    return $keys
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::CompareRows --
+#
+#	Compares two rows by the keys of an ORDER BY clause.
+#
+# Parameters:
+#	keys - List of keys, as returned by tdbc::OrderByColumns
+#	row1, row2 - Rows to compare, as dictionaries
+#
+# Results:
+#	Returns -1, 0 or 1 as 'row1' comes before, with or after 'row2'.
+#	Numbers are compared numerically and come before all other values,
+#	which are compared as strings, so that the order is total. A
+#	missing value is a NULL.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::CompareRows {keys row1 row2} {
+    foreach key $keys {
+	lassign $key name descending nullsFirst
+	set null1 [expr {![dict exists $row1 $name]}]
+	set null2 [expr {![dict exists $row2 $name]}]
+	if {$null1 || $null2} {
+	    if {$null1 && $null2} {
+		continue
+	    }
+	    return [expr {($null1 == $nullsFirst) ? -1 : 1}]
+	}
+	set a [dict get $row1 $name]
+	set b [dict get $row2 $name]
+	# NaN is not ordered against numbers, so it counts as a string.
+
+	set number1 [expr {[string is double -strict $a] && $a == $a}]
+	set number2 [expr {[string is double -strict $b] && $b == $b}]
+	if {$number1 && $number2} {
+	    set c [expr {$a < $b ? -1 : $a > $b ? 1 : 0}]
+	} elseif {$number1 || $number2} {
+	    set c [expr {$number1 ? -1 : 1}]
+	} else {
+	    set c [string compare $a $b]
+	}
+	if {$c != 0} {
+	    return [expr {$descending ? -$c : $c}]
+	}
+    }
+    return 0
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::KeysetSql --
+#
+#	Rewrites a query so that it returns one page of its rows in the order
+#	of a key, starting after the key of the last row of the previous page.
+#
+# Parameters:
+#	sqlcode - SQL code of the query
+#	keyset - List of the columns of the key
+#	pagesize - Number of rows in a page
+#
+# Results:
+#	Returns a list of the SQL code that retrieves the first page, the SQL
+#	code that retrieves the later pages, and the names of the columns of
+#	the key in the result. The later pages compare the key with the
+#	bound variables 'tdbc_key1', 'tdbc_key2', ...
+#
+#	The query's own WHERE clause is extended. A query that groups its
+#	rows or combines several queries is made a derived table, and a
+#	query that orders or limits its rows is rejected.
+#
+#------------------------------------------------------------------------------
+
+proc tdbc::KeysetSql {sqlcode keyset pagesize} {
+    variable generalError
+
+    # Blank out the bound variables, strings and comments, so that what
+    # remains is the structure of the statement.
+
+    set text $sqlcode
+    set masked [MaskSql $sqlcode]
+
+    # Drop a trailing semicolon and comment, and reject several statements
+
+    set masked [string trimright $masked]
+    if {[string index $masked end] eq {;}} {
+	set masked [string trimright [string range $masked 0 end-1]]
+    }
+    if {[string first ";" $masked] >= 0} {
+	set errorcode $generalError
+	lappend errorcode featureNotSupported
+	return -code error -errorcode $errorcode \
+	    "only a single query can be paged"
+    }
+    set text [string range $text 0 [expr {[string length $masked] - 1}]]
+
+    # Find the clauses at the outer level of the query
+
+    set depth 0
+    set where {}
+    set wrap 0
+    set pattern {[()]|\m(?:WHERE|GROUP|HAVING|WINDOW|UNION|INTERSECT|EXCEPT}
+    append pattern {|ORDER|LIMIT|OFFSET|FETCH|FOR)\M}
+    foreach match [regexp -all -indices -inline -nocase $pattern $masked] {
+	set word [string toupper [string range $masked {*}$match]]
+	if {$word eq "("} {
+	    incr depth
+	} elseif {$word eq ")"} {
+	    incr depth -1
+	} elseif {$depth > 0} {
+	    continue
+	} elseif {$word in {ORDER LIMIT OFFSET FETCH FOR}} {
+	    set errorcode $generalError
+	    lappend errorcode featureNotSupported
+	    if {$word eq {ORDER}} {
+		set word {ORDER BY}
+	    }
+	    return -code error -errorcode $errorcode \
+		"the query cannot be paged because of its $word clause"
+	} elseif {$word eq {WHERE}} {
+	    set where [lindex $match 1]
+	} else {
+	    set wrap 1
+	}
+    }
+
+    # Make the condition and the order of the key
+
+    set names {}
+    set columns {}
+    set keys {}
+    set pattern {^(?:(?:"[^"]+"|\[[^]]+\]|[[:alpha:]_][[:alnum:]_$]*)\.)*}
+    append pattern {("[^"]+"|\[[^]]+\]|[[:alpha:]_][[:alnum:]_$]*)$}
+    foreach column $keyset {
+	if {![regexp $pattern $column -> name]} {
+	    set errorcode $generalError
+	    lappend errorcode badOptionValue -keyset $keyset
+	    return -code error -errorcode $errorcode \
+		"bad value \"$keyset\" for option \"-keyset\""
+	}
+	if {$wrap} {
+	    set column $name
+	}
+	if {[string index $name 0] in {\" \[}} {
+	    set name [string range $name 1 end-1]
+	}
+	lappend names $name
+	lappend columns $column
+	lappend keys :tdbc_key[expr {[llength $keys] + 1}]
+    }
+    if {[llength $columns] == 1} {
+	set condition "[lindex $columns 0] > [lindex $keys 0]"
+    } else {
+	set condition "([join $columns {, }]) > ([join $keys {, }])"
+    }
+    set order " ORDER BY [join $columns {, }] LIMIT $pagesize"
+
+    if {$wrap} {
+	set first "SELECT * FROM ($text) tdbc_keyset"
+	set next "$first WHERE $condition"
+    } elseif {$where ne {}} {
+	set first $text
+	set next "[string range $text 0 $where] ([string trim [string range \
+		  $text [expr {$where + 1}] end]]) AND $condition"
+    } else {
+	set first $text
+	set next "$text WHERE $condition"
+    }
+    return [list $first$order $next$order $names]
+}
+
+#------------------------------------------------------------------------------
+#
+# Definitions made on first use
+#
+#	When TDBC is loaded from its shared library, only the part of this
+#	file above the marker that follows is evaluated at once. The rest
+#	is evaluated by tdbc::DefineLazy when one of the seldom-used methods
+#	whose bodies it defines is first called: each has a method in its
+#	class that calls tdbc::DefineLazy and then the body, so that the
+#	method exists and can be reached with 'next' from a derived class
+#	before the body is defined. When the file is sourced, all of it is
+#	evaluated at once.
+#
+#------------------------------------------------------------------------------
+#@lazy
+
+oo::define ::tdbc::connection {
+
+    # The 'pages' method pages through the results of a query by the
+    # seek method. The query is rewritten to return at most 'pagesize'
+    # rows in the order of the key, following the key of the last row of
+    # the previous page, so that each page costs the same however deep
+    # it is. For each page, it sets a variable to the list of rows and
+    # invokes a script in the caller's scope. One statement is prepared
+    # for the first page and one for the rest.
+    #
+    # Usage:
+    #     $db pages -keyset columns -pagesize n ?-as lists|dicts?
+    #         ?-columnsvariable varName? ?-intern columns? ?-timeout ms?
+    #         ?--? varName sql ?dictionary? script
+
+    method LazyPages args {
+	variable ::tdbc::generalError
+
+	# Take the options of paging, and leave the others to
+	# ParseConvenienceArgs
+
+	set keyset {}
+	set pagesize {}
+	set options {}
+	set i 0
+	foreach {option value} $args {
+	    if {$option eq {-keyset}} {
+		if {![string is list $value]} {
+		    set errorcode $generalError
+		    lappend errorcode badOptionValue $option $value
+		    return -code error -errorcode $errorcode \
+			"bad value \"$value\" for option \"$option\""
+		}
+		set keyset $value
+	    } elseif {$option eq {-pagesize}} {
+		if {![string is entier -strict $value] || $value <= 0} {
+		    set errorcode $generalError
+		    lappend errorcode badOptionValue $option $value
+		    return -code error -errorcode $errorcode \
+			"bad value \"$value\" for option \"$option\""
+		}
+		set pagesize $value
+	    } elseif {[string match -* $option] && $option ne {--}} {
+		lappend options $option $value
+	    } else {
+		break
+	    }
+	    incr i 2
+	}
+	set args [::tdbc::ParseConvenienceArgs \
+		      [concat $options [lrange $args $i end]] opts]
+	::tdbc::CheckRowOptions $opts
+	foreach {option value} [list -keyset $keyset -pagesize $pagesize] {
+	    if {$value eq {}} {
+		set errorcode $generalError
+		lappend errorcode badOption $option
+		return -code error -errorcode $errorcode \
+		    "option \"$option\" is required"
 	    }
+	}
 
-	    # Advance to the next group of results if there is one
+	# Check positional parameters
 
-	    if {[info exists broken] || ![my nextresults]} {
-		break
+	if {[llength $args] == 3} {
+	    lassign $args varname sqlcode script
+	} elseif {[llength $args] == 4} {
+	    lassign $args varname sqlcode dict script
+	} else {
+	    set errorcode $generalError
+	    lappend errorcode wrongNumArgs
+	    return -code error -errorcode $errorcode \
+		"wrong # args: should be [list [self] pages]\
+                 -keyset columns -pagesize n ?-option value?... ?--?\
+                 varname sqlcode ?dictionary? script"
+	}
+	lassign [::tdbc::KeysetSql $sqlcode $keyset $pagesize] \
+	    firstSql nextSql names
+
+	# The values of the bound variables come from the caller's variables
+	# if no dictionary is given, since the key is bound with them.
+
+	if {![info exists dict]} {
+	    set dict {}
+	    foreach name [dict get [::tdbc::classify $sqlcode] params] {
+		upvar 1 $name param
+		if {[info exists param]} {
+		    dict set dict $name $param
+		}
+		unset -nocomplain param
 	    }
-	}	
+	}
+	upvar 1 $varname page
+	set columnsVar [dict exists $opts -columnsvariable]
+	if {$columnsVar} {
+	    upvar 1 [dict get $opts -columnsvariable] caller
+	    dict unset opts -columnsvariable
+	}
+	set as [dict get $opts -as]
 
-	return
-    }
+	# Fetch the pages, preparing each kind of statement when it is
+	# first needed
 
-    
-    # The 'nextrow' method retrieves a row in the form of either
-    # a list or a dictionary.
+	set stmts {}
+	set status [catch {
+	    set stmt [my prepare $firstSql]
+	    lappend stmts $stmt
+	    while {1} {
+		set rows [$stmt allrows {*}$opts -columnsvariable columns \
+			      -- $dict]
+		if {[llength $rows] == 0} {
+		    break
+		}
+		if {$columnsVar} {
+		    set caller $columns
+		}
+		set page $rows
+		set code [catch {uplevel 1 $script} result options]
+		if {$code == 3} {
+		    break
+		} elseif {$code != 0 && $code != 4} {
+		    return -options $options $result
+		}
+		if {[llength $rows] < $pagesize} {
+		    break
+		}
 
-    method nextrow {args} {
+		# Bind the key of the last row for the next page
+
+		set dict [dict merge $dict \
+			      [my PageKey $names $as $columns [lindex $rows end]]]
+		if {[llength $stmts] == 1} {
+		    set stmt [my prepare $nextSql]
+		    lappend stmts $stmt
+		}
+	    }
+	} result options]
+
+	# Destroy the statements
+
+	foreach stmt $stmts {
+	    catch {
+		$stmt close
+	    }
+	}
+
+	# Adjust return level in the case that the script [return]s
+
+	if {$status == 2} {
+	    set options [dict merge {-level 1} $options[set options {}]]
+	    dict incr options -level
+	}
+	return -options $options $result
+    }
 
+    # The 'PageKey' method returns a dictionary of the values of the
+    # bound variables 'tdbc_key1', 'tdbc_key2', ... for the page that
+    # follows a row.
+
+    method PageKey {names as columns row} {
 	variable ::tdbc::generalError
+	set key {}
+	set n 0
+	foreach name $names {
+	    incr n
+	    if {$as eq {lists}} {
+		set index [lsearch -exact $columns $name]
+		if {$index < 0} {
+		    set index [lsearch -exact -nocase $columns $name]
+		}
+		set found [expr {$index >= 0}]
+	    } else {
+		set found [dict exists $row $name]
+	    }
+	    if {!$found} {
+		set errorcode $generalError
+		lappend errorcode badColumn $name
+		return -code error -errorcode $errorcode \
+		    "key column \"$name\" is missing from the results or\
+                     is NULL"
+	    }
+	    if {$as eq {lists}} {
+		dict set key tdbc_key$n [lindex $row $index]
+	    } else {
+		dict set key tdbc_key$n [dict get $row $name]
+	    }
+	}
+	return $key
+    }
 
-	set opts [dict create -as dicts]
-	set i 0
-    
-	# Munch keyword options off the front of the command arguments
-	
-	foreach {key value} $args {
-	    if {[string index $key 0] eq {-}} {
-		switch -regexp -- $key {
-		    -as? {
-			dict set opts -as $value
+    # The 'pipeline' method evaluates a script in the caller's scope.
+    # Statements that the script executes with 'allrows' on this
+    # connection are queued rather than executed, and 'allrows' returns
+    # a future for each. When the script finishes, the queued statements
+    # are executed and the futures are resolved. If the script fails,
+    # the queued statements are discarded.
+    # Usage:
+    #	$db pipeline script
+
+    method LazyPipeline {script} {
+	dict incr pipeline depth
+	set status [catch {uplevel 1 $script} result options]
+	dict incr pipeline depth -1
+	if {[dict get $pipeline depth] == 0} {
+	    if {$status == 1} {
+		my PipelineDiscard
+	    } else {
+		my PipelineFlush
+	    }
+	}
+
+	# Adjust return level in the case that the script [return]s
+
+	if {$status == 2} {
+	    set options [dict merge {-level 1} $options[set options {}]]
+	    dict incr options -level
+	}
+	return -options $options $result
+    }
+
+    # Drivers may implement an 'executePipeline' method, which sends all
+    # the statements of a pipeline to the database before reading any of
+    # their results. It accepts a list of requests, each a list of the
+    # '-as' option, the SQL code and the dictionary of bound values, and
+    # returns a list of outcomes in the same order. Each outcome is either
+    # a list of 0, the column names and the rows, or a list of 1, an
+    # error message and an error code.
+
+    # The 'PipelineFlush' method executes the statements that are queued
+    # in the pipeline and resolves their futures. Without a driver hook,
+    # the statements are executed one after another with 'allrows'.
+
+    method PipelineFlush {} {
+	set queue {}
+	foreach entry [dict get $pipeline queue] {
+	    if {[info object isa object [lindex $entry 0]]} {
+		lappend queue $entry
+	    }
+	}
+	dict set pipeline queue {}
+	if {[llength $queue] == 0} {
+	    return
+	}
+	dict set pipeline flushing 1
+	try {
+	    if {{executePipeline} in [info object methods [self] -all]} {
+		set requests {}
+		foreach entry $queue {
+		    lassign $entry future as sqlcode dict
+		    if {[dict get $frameworkOptions -autoparameterize]} {
+			lassign [::tdbc::parameterize $sqlcode] sqlcode literals
+			set dict [dict merge $dict $literals]
 		    }
-		    -- {
-			incr i
-			break
+		    lappend requests [list $as $sqlcode $dict]
+		}
+		set status [catch {my executePipeline $requests} outcomes options]
+		set i 0
+		foreach entry $queue {
+		    set futureMy [info object namespace [lindex $entry 0]]::my
+		    if {$status} {
+
+			# The whole pipeline failed
+
+			$futureMy Resolve 1 {} $outcomes $options
+			continue
 		    }
-		    default {
-			set errorcode $generalError
-			lappend errorcode badOption $key
-			return -code error -errorcode $errorcode \
-			    "bad option \"$key\":\
-                             must be -as or -columnsvariable"
+		    lassign [lindex $outcomes $i] code columns rows
+		    incr i
+		    if {$code == 0} {
+			$futureMy Resolve 0 $columns $rows {}
+		    } else {
+			$futureMy Resolve 1 {} $columns \
+			    [dict create -code 1 -level 0 -errorcode $rows]
 		    }
 		}
 	    } else {
-		break
+		foreach entry $queue {
+		    lassign $entry future as sqlcode dict
+		    set columns {}
+		    set status [catch {
+			my allrows -as $as -columnsvariable columns -- \
+			    $sqlcode $dict
+		    } result options]
+		    [info object namespace $future]::my Resolve \
+			$status $columns $result $options
+		}
 	    }
-	    incr i 2
+	} finally {
+	    dict set pipeline flushing 0
 	}
+	return
+    }
 
-	set args [lrange $args $i end]
-	if {[llength $args] != 1} {
+    # The 'PipelineDiscard' method abandons the statements that are
+    # queued in the pipeline.
+
+    method PipelineDiscard {} {
+	variable ::tdbc::generalError
+	set errorcode $generalError
+	lappend errorcode pipelineAbandoned
+	set options [dict create -code 1 -level 0 -errorcode $errorcode]
+	foreach entry [dict get $pipeline queue] {
+	    set future [lindex $entry 0]
+	    if {[info object isa object $future]} {
+		[info object namespace $future]::my Resolve 1 {} \
+		    "statement was not executed because the pipeline failed" \
+		    $options
+	    }
+	}
+	dict set pipeline queue {}
+	return
+    }
+
+    # The 'schema' method returns a snapshot of the keys and columns of
+    # every table in the database, loading it on first use or when
+    # '-refresh' is supplied. While a snapshot is held, 'primarykeys'
+    # and 'foreignkeys' are answered from it without querying the
+    # database. The snapshot is discarded when a statement that changes
+    # the schema is executed on the connection.
+    #
+    # The result is a dictionary whose keys are table names, and whose
+    # values are dictionaries with the keys:
+    #	columns      - Dictionary of column descriptions, as returned
+    #		       by the 'columns' method
+    #	primarykeys  - The table's primary key, as returned by
+    #		       'primarykeys'
+    #	foreignkeys  - The table's foreign keys, as returned by
+    #		       'foreignkeys -foreign'
+    #	referencedby - The foreign keys that refer to the table, as
+    #		       returned by 'foreignkeys -primary'
+
+    method LazySchema args {
+	variable ::tdbc::generalError
+	if {[llength $args] > 1
+	    || ([llength $args] == 1 && [lindex $args 0] ne {-refresh})} {
 	    set errorcode $generalError
 	    lappend errorcode wrongNumArgs
 	    return -code error -errorcode $errorcode \
-		"wrong # args: should be [lrange [info level 0] 0 1]\
-                 ?-option value?... ?--? varName"
+		"wrong # args: should be \"[self] schema ?-refresh?\""
 	}
-	upvar 1 [lindex $args 0] row
-	if {[dict get $opts -as] eq {lists}} {
-	    set delegate nextlist
+	if {[llength $args] == 1 || ![info exists schemaSnapshot]} {
+	    my LoadSchema
+	}
+	return $schemaSnapshot
+    }
+
+    # The 'LoadSchema' method loads the schema snapshot. If the driver
+    # uses the base class's INFORMATION_SCHEMA queries for keys, the
+    # whole snapshot is loaded in three queries. Otherwise, the driver's
+    # own 'tables', 'columns', 'primarykeys' and 'foreignkeys' methods
+    # are called for each table.
+
+    method LoadSchema {} {
+	unset -nocomplain schemaSnapshot
+	set empty {columns {} primarykeys {} foreignkeys {} referencedby {}}
+	set snapshot {}
+	set bulk 1
+	foreach m {primarykeys foreignkeys} {
+	    foreach entry [info object call [self] $m] {
+		if {[lindex $entry 2] ne {::tdbc::ConnectionHooks}} {
+		    if {[lindex $entry 2] ne {::tdbc::connection}} {
+			set bulk 0
+		    }
+		    break
+		}
+	    }
+	}
+	if {$bulk} {
+	    my foreach col {
+		SELECT TABLE_NAME AS "tableName",
+		       COLUMN_NAME AS "name",
+		       DATA_TYPE AS "type",
+		       COALESCE(CHARACTER_MAXIMUM_LENGTH, NUMERIC_PRECISION)
+		           AS "precision",
+		       NUMERIC_SCALE AS "scale",
+		       IS_NULLABLE AS "nullable"
+		FROM INFORMATION_SCHEMA.COLUMNS
+		WHERE TABLE_SCHEMA NOT IN ('INFORMATION_SCHEMA',
+		                           'information_schema',
+		                           'pg_catalog')
+		ORDER BY TABLE_NAME, ORDINAL_POSITION
+	    } {
+		set table [dict get $col tableName]
+		dict unset col tableName
+		foreach key {precision scale} {
+		    if {![dict exists $col $key]} {
+			dict set col $key 0
+		    }
+		}
+		if {[dict exists $col nullable]} {
+		    dict set col nullable \
+			[expr {[string toupper [dict get $col nullable]]
+			       eq {YES}}]
+		}
+		if {![dict exists $snapshot $table]} {
+		    dict set snapshot $table $empty
+		}
+		dict set snapshot $table columns [dict get $col name] $col
+	    }
+	    set primaryKeys [my allrows [my PrimaryKeysSql {}]]
+	    set foreignKeys [my allrows [my ForeignKeysSql 0 0]]
 	} else {
-	    set delegate nextdict
+	    set primaryKeys {}
+	    set foreignKeys {}
+	    foreach table [dict keys [my tables]] {
+		dict set snapshot $table $empty
+		dict set snapshot $table columns [my columns $table]
+		lappend primaryKeys {*}[my primarykeys $table]
+		lappend foreignKeys {*}[my foreignkeys -foreign $table]
+	    }
 	}
-	return [my $delegate row]
+	foreach key $primaryKeys {
+	    set table [dict get $key tableName]
+	    if {![dict exists $snapshot $table]} {
+		dict set snapshot $table $empty
+	    }
+	    dict with snapshot $table {
+		lappend primarykeys $key
+	    }
+	}
+	foreach key $foreignKeys {
+	    foreach {side table} [list foreignkeys [dict get $key foreignTable] \
+				      referencedby [dict get $key primaryTable]] {
+		if {![dict exists $snapshot $table]} {
+		    dict set snapshot $table $empty
+		}
+		dict with snapshot $table {
+		    lappend $side $key
+		}
+	    }
+	}
+	set schemaSnapshot $snapshot
+	return
     }
 
-    # Derived classes must override 'nextresults' if a single
-    # statement execution can yield multiple sets of results
+    # The 'SchemaForeignKeys' method answers the 'foreignkeys' method
+    # from the schema snapshot, given the dictionary returned by
+    # 'ForeignKeysArgs'.
 
-    method nextresults {} {
-	return 0
+    method SchemaForeignKeys {argdict} {
+	if {[dict exists $argdict foreign]} {
+	    set table [dict get $argdict foreign]
+	    if {![dict exists $schemaSnapshot $table]} {
+		return {}
+	    }
+	    set result [dict get $schemaSnapshot $table foreignkeys]
+	    if {[dict exists $argdict primary]} {
+		set primary [dict get $argdict primary]
+		set result [lmap key $result {
+		    if {[dict get $key primaryTable] ne $primary} continue
+		    set key
+		}]
+	    }
+	    return $result
+	} elseif {[dict exists $argdict primary]} {
+	    set table [dict get $argdict primary]
+	    if {![dict exists $schemaSnapshot $table]} {
+		return {}
+	    }
+	    return [dict get $schemaSnapshot $table referencedby]
+	}
+	set result {}
+	dict for {table entry} $schemaSnapshot {
+	    lappend result {*}[dict get $entry foreignkeys]
+	}
+	return $result
     }
+}
 
-    # Derived classes must override 'outputparams' if statements can
-    # have output parameters.
+oo::define ::tdbc::resultset {
 
-    method outputparams {} {
-	return {}
+    # The 'blobchannel' method returns a read-only channel that reads the
+    # value of a column in the current row as binary data. If the driver
+    # implements 'blobRead', the channel reads the value from the
+    # database a chunk at a time; otherwise it reads the value that was
+    # fetched with the row.
+
+    method LazyBlobchannel {column} {
+
+	variable ::tdbc::generalError
+
+	set names [my columns]
+	if {$column ni $names} {
+	    set errorcode $generalError
+	    lappend errorcode badColumn $column
+	    return -code error -errorcode $errorcode \
+		"no column named \"$column\""
+	}
+	if {!$trackRows} {
+	    set reader [::tdbc::BlobChannel new [namespace which my] $column]
+	} elseif {$currentRow eq {}} {
+	    set errorcode $generalError
+	    lappend errorcode noCurrentRow
+	    return -code error -errorcode $errorcode "no current row"
+	} else {
+	    lassign $currentRow as row
+	    if {$as eq {lists}} {
+		set value [lindex $row [lsearch -exact $names $column]]
+	    } elseif {[dict exists $row $column]} {
+		set value [dict get $row $column]
+	    } else {
+		set value {}
+	    }
+
+	    # A value with a character that does not fit in a byte is not
+	    # binary data; read its UTF-8 encoding instead.
+
+	    if {[regexp {[^\u0000-\u00ff]} $value]} {
+		set value [encoding convertto utf-8 $value]
+	    }
+	    set reader [::tdbc::BlobChannel new {} $column $value]
+	}
+	set chan [chan create read $reader]
+	chan configure $chan -translation binary
+	return $chan
     }
+}
+#------------------------------------------------------------------------------
+#
+# tdbc::BlobChannel --
+#
+#	Handler for the reflected channel returned by 'blobchannel'. It
+#	reads either from the driver's 'blobRead' method, a chunk at a time,
+#	or from a value already in memory.
+#
+#------------------------------------------------------------------------------
 
-    # The 'close' method is syntactic sugar for destroying the result set.
+oo::class create ::tdbc::BlobChannel {
+
+    # resultSetMy is the 'my' command of the result set, or empty if
+    #	the channel reads from 'value'
+    # column is the name of the column being read
+    # value is the value being read, if it is in memory, as a string
+    #	of bytes
+    # offset is the byte offset of the next read
+    # timer is the event that will notify a channel that is being
+    #	watched that it is readable
+
+    variable resultSetMy column value offset timer
+
+    constructor {resultSet col {data {}}} {
+	set resultSetMy $resultSet
+	set column $col
+	set value $data
+	set offset 0
+	set timer {}
+    }
 
-    method close {} {
+    destructor {
+	after cancel $timer
+    }
+
+    method initialize {chan mode} {
+	return {initialize finalize watch read}
+    }
+
+    method finalize {chan} {
 	my destroy
     }
 
-    # Derived classes are expected to implement the following methods:
+    # A channel in memory is always readable, so while the channel
+    # is watched, notify it repeatedly from the event loop.
 
-    # constructor and destructor.  
-    #        Constructor accepts a statement and an optional
-    #        a dictionary of substituted parameters  and
-    #        executes the statement against the database. If
-    #	     the dictionary is not supplied, then the default
-    #	     is to get params from variables in the caller's scope).
-    # columns
-    #     -- Returns a list of the names of the columns in the result.
-    # nextdict variableName
-    #     -- Stores the next row of the result set in the given variable
-    #        in caller's scope, in the form of a dictionary that maps
-    #	     column names to values.
-    # nextlist variableName
-    #     -- Stores the next row of the result set in the given variable
-    #        in caller's scope, in the form of a list of cells.
-    # rowcount
-    #     -- Returns a count of rows affected by the statement, or -1
-    #        if the count of rows has not been determined.
+    method watch {chan events} {
+	after cancel $timer
+	set timer {}
+	if {{read} in $events} {
+	    set timer [after 0 [list [namespace which my] Notify $chan]]
+	}
+    }
+
+    method Notify {chan} {
+	set timer [after 0 [list [namespace which my] Notify $chan]]
+	chan postevent $chan read
+    }
+
+    method read {chan count} {
+	if {$resultSetMy eq {}} {
+	    set data [string range $value $offset [expr {$offset + $count - 1}]]
+	} elseif {[namespace which $resultSetMy] eq {}} {
+	    return -code error "result set has been closed"
+	} else {
+	    set data [$resultSetMy blobRead $column $offset $count]
+	}
+	incr offset [string length $data]
+	return $data
+    }
+}
+
+#------------------------------------------------------------------------------
+#
+# tdbc::future --
+#
+#	Class of the objects that 'allrows' returns inside the 'pipeline'
+#	method of a connection. A future holds the outcome of a queued
+#	statement once the pipeline has executed it.
+#
+#------------------------------------------------------------------------------
+
+oo::class create ::tdbc::future {
+
+    # connectionMy is the 'my' command of the connection
+    # resolved is 1 once the statement has been executed
+    # columns is the list of the names of the columns of the result
+    # result and options are the result of executing the statement and
+    #	the return options that go with it
+
+    variable connectionMy resolved columns result options
+
+    constructor {connection} {
+	set connectionMy $connection
+	set resolved 0
+	set columns {}
+    }
+
+    # The 'Resolve' method stores the outcome of the statement.
+
+    method Resolve {status cols res opts} {
+	set resolved 1
+	set columns $cols
+	set result $res
+	set options [dict merge $opts [dict create -code $status -level 0]]
+	return
+    }
+
+    # The 'get' method returns the rows of the result, or rethrows the
+    # error that the statement raised. Inside the pipeline, it first
+    # executes the statements that have been queued so far.
+
+    method get {} {
+	if {!$resolved} {
+	    $connectionMy PipelineFlush
+	}
+	return -options $options $result
+    }
+
+    # The 'columns' method returns the names of the columns of the result.
+
+    method columns {} {
+	if {!$resolved} {
+	    $connectionMy PipelineFlush
+	}
+	return $columns
+    }
+
+    # The 'close' method is simply an alternative syntax for destroying
+    # the future.
+
+    method close {} {
+	my destroy
+    }
+}
 
-}
\ No newline at end of file
+set ::tdbc::lazyDefined 1
@@ -0,0 +1,269 @@
+# mockdriver.tcl --
+#
+#	A minimal in-memory TDBC driver that the test suite uses to exercise
+#	the base classes in library/tdbc.tcl without a database.
+#
+#	The connection does not interpret SQL. Instead, each execution is
+#	passed to a 'handler' command prefix, which is called with the SQL
+#	code and the dictionary of bound values and returns a dictionary
+#	with the keys:
+#		columns  - List of column names in the result
+#		rows	 - List of rows, each a dictionary mapping column
+#			   names to values. A missing key is a NULL.
+#		rowcount - (Optional) Count of rows affected.
+#		types	 - (Optional) Dictionary mapping column names to
+#			   'integer', 'double' or 'bytes'. When the
+#			   connection is configured with '-typed 1', values
+#			   in those columns are given native representations.
+#	If the handler throws an error, the error propagates out of
+#	'execute'. Every execution, and every transaction boundary, is
+#	recorded in the connection's log.
+#
+# Copyright (c) 2026 by the TDBC contributors.
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+#
+#------------------------------------------------------------------------------
+
+package require tdbc
+
+namespace eval ::tdbc::mock {}
+
+oo::class create ::tdbc::mock::connection {
+
+    superclass ::tdbc::connection
+
+    variable handler log options
+
+    constructor {args} {
+	next
+	set handler {}
+	set log {}
+	set options [dict create -isolation readcommitted -readonly 0 \
+			 -timeout 0]
+	if {[llength $args] > 0} {
+	    my configure {*}$args
+	}
+    }
+
+    forward statementCreate ::tdbc::mock::statement create
+
+    method configure args {
+	if {[llength $args] == 0} {
+	    return $options
+	} elseif {[llength $args] == 1} {
+	    if {![dict exists $options [lindex $args 0]]} {
+		return -code error "bad option \"[lindex $args 0]\""
+	    }
+	    return [dict get $options [lindex $args 0]]
+	}
+	foreach {key value} $args {
+	    if {![dict exists $options $key]} {
+		return -code error "bad option \"$key\""
+	    }
+	    dict set options $key $value
+	}
+	return
+    }
+
+    method handler {cmdPrefix} {
+	set handler $cmdPrefix
+    }
+
+    method log {} {
+	return $log
+    }
+
+    method clearlog {} {
+	set log {}
+    }
+
+    method mockrun {sql params} {
+	lappend log [list execute [string trim $sql] $params]
+	if {$handler eq {}} {
+	    return {columns {} rows {} rowcount 0}
+	}
+	return [{*}$handler [string trim $sql] $params]
+    }
+
+    method begintransaction {} {
+	lappend log begin
+    }
+    method commit {} {
+	lappend log commit
+    }
+    method rollback {} {
+	lappend log rollback
+    }
+
+    method prepareCall {call} {
+	return -code error "stored procedures are not supported"
+    }
+
+    method tables {{pattern %}} {
+	return {}
+    }
+    method columns {table {pattern %}} {
+	return {}
+    }
+}
+
+oo::class create ::tdbc::mock::statement {
+
+    superclass ::tdbc::statement
+
+    variable db sql params
+
+    constructor {connection sqlcode} {
+	next
+	set db $connection
+	set sql $sqlcode
+	set params {}
+	foreach token [::tdbc::tokenize $sqlcode] {
+	    if {[string index $token 0] in {$ : @}} {
+		dict set params [string range $token 1 end] \
+		    {direction in type varchar precision 0 scale 0 nullable 1}
+	    }
+	}
+    }
+
+    forward resultSetCreate ::tdbc::mock::resultset create
+
+    method connection {} {
+	return $db
+    }
+
+    method sql {} {
+	return $sql
+    }
+
+    method params {} {
+	return $params
+    }
+
+    method paramtype args {
+	return
+    }
+}
+
+oo::class create ::tdbc::mock::resultset {
+
+    superclass ::tdbc::resultset
+
+    # results is a list of the further sets of results, which the
+    #	handler may give in the 'more' element of its result
+    # typed is 1 if the connection's -typed option is set
+
+    variable columns rows cursor count results typed
+
+    constructor {statement args} {
+	next
+	if {[llength $args] == 0} {
+	    set bind {}
+	    foreach name [dict keys [$statement params]] {
+		upvar 1 $name value
+		if {[info exists value]} {
+		    dict set bind $name $value
+		}
+	    }
+	} elseif {[llength $args] == 1} {
+	    set bind [lindex $args 0]
+	} else {
+	    return -code error "wrong # args: should be\
+                 \"[lindex [info level 0] 0] statement ?dictionary?\""
+	}
+	set result [[$statement connection] mockrun [$statement sql] $bind]
+	set typed [[$statement connection] configure -typed]
+	set results {}
+	if {[dict exists $result more]} {
+	    set results [dict get $result more]
+	}
+	my Load $result
+    }
+
+    method Load {result} {
+	set columns {}
+	set rows {}
+	if {[dict exists $result columns]} {
+	    set columns [dict get $result columns]
+	}
+	if {[dict exists $result rows]} {
+	    set rows [dict get $result rows]
+	}
+	if {[dict exists $result rowcount]} {
+	    set count [dict get $result rowcount]
+	} else {
+	    set count [llength $rows]
+	}
+	if {[dict exists $result types] && $typed} {
+	    set rows [lmap row $rows {
+		dict for {c type} [dict get $result types] {
+		    if {[dict exists $row $c]} {
+			set v [dict get $row $c]
+			switch -exact -- $type {
+			    integer { set v [expr {wide($v)}] }
+			    double { set v [expr {double($v)}] }
+			    bytes { set v [encoding convertto utf-8 $v] }
+			}
+			dict set row $c $v
+		    }
+		}
+		set row
+	    }]
+	}
+	set cursor 0
+    }
+
+    method nextresults {} {
+	if {[llength $results] == 0} {
+	    return 0
+	}
+	set result [lindex $results 0]
+	set results [lrange $results 1 end]
+	my Load $result
+	return 1
+    }
+
+    method columns {} {
+	return $columns
+    }
+
+    method rowcount {} {
+	return $count
+    }
+
+    method nextdict {varName} {
+	upvar 1 $varName row
+	if {$cursor >= [llength $rows]} {
+	    return 0
+	}
+	set row {}
+	set data [lindex $rows $cursor]
+	incr cursor
+	foreach c $columns {
+	    if {[dict exists $data $c]} {
+		dict set row $c [dict get $data $c]
+	    }
+	}
+	return 1
+    }
+
+    method nextlist {varName} {
+	upvar 1 $varName row
+	if {$cursor >= [llength $rows]} {
+	    return 0
+	}
+	set row {}
+	set data [lindex $rows $cursor]
+	incr cursor
+	foreach c $columns {
+	    if {[dict exists $data $c]} {
+		lappend row [dict get $data $c]
+	    } else {
+		lappend row {}
+	    }
+	}
+	return 1
+    }
+}
@@ -0,0 +1,108 @@
+# genScript.tcl --
+#
+#	Converts the TDBC library script into a C header, so that Tdbc_Init
+#	can evaluate it without finding and reading a file.
+#
+# Usage:
+#
+#	tclsh genScript.tcl tdbc.tcl tdbcScript.h
+#
+# Parameters:
+#
+#	tdbc.tcl --
+#		Name of the library script.
+#	tdbcScript.h --
+#		Name of the header file to write. It declares two arrays
+#		of strings, terminated by NULL: 'tdbcScript', the lines of
+#		the script that precede a line reading '#@lazy', and
+#		'tdbcLazyScript', the lines that follow it.
+#
+# Copyright (c) 2026 by the TDBC contributors.
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+#
+#------------------------------------------------------------------------------
+
+# cString --
+#
+#	Formats a line of the script as a C string literal
+#
+# Parameters:
+#	line -- Line of the script, without its newline
+#
+# Results:
+#	Returns the literal, including a trailing newline.
+#
+# Question marks are escaped so that no trigraphs are formed, and bytes
+# outside printable ASCII are given as octal escapes.
+
+proc cString {line} {
+    set result \"
+    foreach byte [split [encoding convertto utf-8 $line] {}] {
+	scan $byte %c code
+	if {$byte in {\\ \" ?}} {
+	    append result \\ $byte
+	} elseif {$code == 9} {
+	    append result \\t
+	} elseif {$code < 32 || $code > 126} {
+	    append result [format \\%03o $code]
+	} else {
+	    append result $byte
+	}
+    }
+    append result "\\n\""
+    return $result
+}
+
+# writeArray --
+#
+#	Writes the declaration of an array of the lines of a script
+#
+# Parameters:
+#	chan -- Channel on which to write
+#	name -- Name of the array
+#	lines -- Lines of the script
+
+proc writeArray {chan name lines} {
+    puts $chan "static const char *const ${name}\[\] = {"
+    foreach line $lines {
+	puts $chan "    [cString $line],"
+    }
+    puts $chan "    NULL"
+    puts $chan "};"
+}
+
+proc main {argv} {
+    if {[llength $argv] != 2} {
+	puts stderr "usage: genScript.tcl tdbc.tcl tdbcScript.h"
+	exit 1
+    }
+    lassign $argv inFile outFile
+    set f [open $inFile r]
+    fconfigure $f -encoding utf-8
+    set lines [split [read -nonewline $f] \n]
+    close $f
+
+    set marker [lsearch -exact $lines #@lazy]
+    if {$marker < 0} {
+	puts stderr "$inFile has no '#@lazy' line"
+	exit 1
+    }
+
+    set f [open $outFile w]
+    fconfigure $f -translation lf
+    puts $f "/*"
+    puts $f " * [file tail $outFile] --"
+    puts $f " *"
+    puts $f " *\tGenerated from [file tail $inFile] by genScript.tcl."
+    puts $f " *\tDO NOT EDIT."
+    puts $f " */"
+    puts $f ""
+    writeArray $f tdbcScript [lrange $lines 0 [expr {$marker - 1}]]
+    puts $f ""
+    writeArray $f tdbcLazyScript [lrange $lines [expr {$marker + 1}] end]
+    close $f
+}
+
+main $argv
@@ -0,0 +1,78 @@
+# loadbench.tcl --
+#
+#	Measures the time that 'package require tdbc' takes in a new
+#	interpreter.
+#
+# Usage:
+#
+#	tclsh loadbench.tcl ?count?
+#
+# Parameters:
+#
+#	count --
+#		Number of interpreters to create for each measurement.
+#		Default is 200.
+#
+# The package must be found on the 'auto_path', for instance by setting
+# TCLLIBPATH to the directory where it is built or installed. It is
+# located once, and each new interpreter is given its 'package ifneeded'
+# script, so that the time to search the 'auto_path' is not counted. The
+# time to create and delete an empty interpreter is reported alongside,
+# and subtracted to give the cost of the package itself.
+#
+# Copyright (c) 2026 by the TDBC contributors.
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+#
+#------------------------------------------------------------------------------
+
+# measure --
+#
+#	Times the creation of interpreters
+#
+# Parameters:
+#	count -- Number of interpreters to create
+#	setup -- Script to evaluate in each one before timing begins
+#	script -- Script to time in each one
+#
+# Results:
+#	Returns the mean time per interpreter, in microseconds.
+
+proc measure {count setup script} {
+    set total 0
+    for {set i 0} {$i < $count} {incr i} {
+	set start [clock microseconds]
+	set child [interp create]
+	set pause [clock microseconds]
+	$child eval $setup
+	incr start [expr {[clock microseconds] - $pause}]
+	$child eval $script
+	interp delete $child
+	incr total [expr {[clock microseconds] - $start}]
+    }
+    return [expr {double($total) / $count}]
+}
+
+proc main {argv} {
+    set count 200
+    if {[llength $argv] > 1} {
+	puts stderr "usage: loadbench.tcl ?count?"
+	exit 1
+    } elseif {[llength $argv] == 1} {
+	set count [lindex $argv 0]
+    }
+
+    set version [package require tdbc]
+    set setup [list package ifneeded tdbc $version \
+		   [package ifneeded tdbc $version]]
+    set empty [measure $count $setup {}]
+    set tdbc [measure $count $setup {package require tdbc}]
+
+    puts [format "interpreters:              %d" $count]
+    puts [format "empty interpreter:         %8.1f us" $empty]
+    puts [format "package require tdbc %-5s %8.1f us" $version $tdbc]
+    puts [format "cost of the package:       %8.1f us" [expr {$tdbc - $empty}]]
+}
+
+main $argv
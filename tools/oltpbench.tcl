@@ -0,0 +1,494 @@
+# oltpbench.tcl --
+#
+#	Runs a TPC-B-like workload through a TDBC driver from several threads
+#	for a fixed time, and reports the throughput and latency as JSON.
+#
+# Usage:
+#
+#	tclsh oltpbench.tcl ?-option value?...
+#
+# Options:
+#
+#	-driver package --
+#		Package of the driver, such as tdbc::sqlite3 or tdbc::postgres,
+#		or 'mock' for an in-memory stand-in. Default is tdbc::sqlite3.
+#	-connect script --
+#		Script that returns a new connection, evaluated in each thread
+#		after the driver is loaded. Default for tdbc::sqlite3 is
+#		{tdbc::sqlite3::connection new oltpbench.db}; other drivers
+#		require it.
+#	-threads n --
+#		Number of threads that run the workload. Default is 4.
+#	-duration seconds --
+#		Time for which the workload runs. Default is 10.
+#	-scale n --
+#		Number of branches. Each branch has 10 tellers and 100000
+#		accounts. Default is 1.
+#	-mix {operation weight ...} --
+#		Relative frequencies of the operations. Default is
+#		{lookup 50 update 35 insert 10 scan 5}.
+#	-batch n --
+#		Rows inserted by an 'insert' operation. Default is 10.
+#	-scanrows n --
+#		Rows read by a 'scan' operation. Default is 100.
+#	-load boolean --
+#		Whether to create and fill the tables first. Default is 1.
+#
+# The operations are:
+#
+#	lookup -- Reads the balance of one account.
+#	update -- The TPC-B transaction: changes the balances of an account,
+#		  a teller and a branch, reads the account back and records
+#		  the change in the history, in one 'transaction'.
+#	insert -- Inserts 'batch' rows into the history in one transaction.
+#	scan   -- Reads 'scanrows' consecutive accounts.
+#
+# Each thread opens its own connection and prepares each statement once.
+# Operations that fail are counted as errors and are not timed. The
+# result gives the totals over all operations (each counted as one
+# transaction) and for each operation, with latencies in milliseconds.
+# Rows are those read by queries plus those written.
+#
+# The stand-in driver keeps no tables: every thread has its own, and it
+# answers each statement without interpreting it, so that the time spent
+# is that of the TDBC base classes and the workload itself. It needs the
+# mock driver of the test suite in ../tests.
+#
+# Threads need the Thread package unless '-threads' is 1. The package
+# must be found on the 'auto_path', for instance by setting TCLLIBPATH to
+# the directory where it is built or installed.
+#
+# Copyright (c) 2026 by the TDBC contributors.
+#
+# See the file "license.terms" for information on usage and redistribution
+# of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+#
+#------------------------------------------------------------------------------
+
+package require tdbc
+
+# Sizes of the tables, per branch
+
+set tellersPerBranch 10
+set accountsPerBranch 100000
+
+# The statements of the workload
+
+set statements {
+    lookup {SELECT abalance FROM bench_accounts WHERE aid = :aid}
+    account {UPDATE bench_accounts SET abalance = abalance + :delta
+	WHERE aid = :aid}
+    teller {UPDATE bench_tellers SET tbalance = tbalance + :delta
+	WHERE tid = :tid}
+    branch {UPDATE bench_branches SET bbalance = bbalance + :delta
+	WHERE bid = :bid}
+    history {INSERT INTO bench_history (tid, bid, aid, delta, mtime)
+	VALUES (:tid, :bid, :aid, :delta, :mtime)}
+    scan {SELECT aid, abalance FROM bench_accounts
+	WHERE aid BETWEEN :lo AND :hi ORDER BY aid}
+}
+
+# standin --
+#
+#	Answers the statements of the workload for the stand-in driver.
+#
+# Parameters:
+#	sql -- SQL code of the statement
+#	params -- Dictionary of bound values
+#
+# Results:
+#	Returns the result in the form of the mock driver's handlers.
+
+proc standin {sql params} {
+    global standinBalance standinAccounts
+    switch -glob -- [string trim $sql] {
+	{SELECT abalance *} {
+	    set aid [dict get $params aid]
+	    if {![info exists standinBalance($aid)]} {
+		set standinBalance($aid) 0
+	    }
+	    return [list columns abalance \
+			rows [list [list abalance $standinBalance($aid)]]]
+	}
+	{SELECT aid, abalance *} {
+	    set rows {}
+	    set hi [expr {min([dict get $params hi], $standinAccounts)}]
+	    for {set aid [dict get $params lo]} {$aid <= $hi} {incr aid} {
+		set balance 0
+		if {[info exists standinBalance($aid)]} {
+		    set balance $standinBalance($aid)
+		}
+		lappend rows [list aid $aid abalance $balance]
+	    }
+	    return [list columns {aid abalance} rows $rows]
+	}
+	{UPDATE bench_accounts *} {
+	    incr standinBalance([dict get $params aid]) \
+		[dict get $params delta]
+	    return {columns {} rows {} rowcount 1}
+	}
+	{UPDATE *} - {INSERT *} {
+	    return {columns {} rows {} rowcount 1}
+	}
+	default {
+	    return {columns {} rows {} rowcount 0}
+	}
+    }
+}
+
+# connect --
+#
+#	Loads the driver and opens a connection.
+#
+# Parameters:
+#	config -- Dictionary of the options of the run
+#
+# Results:
+#	Returns the connection.
+
+proc connect {config} {
+    if {[dict get $config -driver] eq {mock}} {
+	if {[info commands ::oltpbench::standin] eq {}} {
+	    source [file join [dict get $config tools] .. tests mockdriver.tcl]
+	    oo::class create ::oltpbench::standin {
+		superclass ::tdbc::mock::connection
+		method mockrun {sql params} {
+		    standin $sql $params
+		}
+		method begintransaction {} {}
+		method commit {} {}
+		method rollback {} {}
+	    }
+	}
+	set ::standinAccounts \
+	    [expr {[dict get $config -scale] * $::accountsPerBranch}]
+	return [::oltpbench::standin new]
+    }
+    package require [dict get $config -driver]
+    return [uplevel #0 [dict get $config -connect]]
+}
+
+# populate --
+#
+#	Creates the tables of the workload and fills them.
+#
+# Parameters:
+#	config -- Dictionary of the options of the run
+
+proc populate {config} {
+    global tellersPerBranch accountsPerBranch
+    set db [connect $config]
+    foreach table {history accounts tellers branches} {
+	catch {$db allrows "DROP TABLE bench_$table"}
+    }
+    $db allrows {CREATE TABLE bench_branches (bid INTEGER PRIMARY KEY,
+	bbalance INTEGER NOT NULL)}
+    $db allrows {CREATE TABLE bench_tellers (tid INTEGER PRIMARY KEY,
+	bid INTEGER NOT NULL, tbalance INTEGER NOT NULL)}
+    $db allrows {CREATE TABLE bench_accounts (aid INTEGER PRIMARY KEY,
+	bid INTEGER NOT NULL, abalance INTEGER NOT NULL, filler CHAR(84))}
+    $db allrows {CREATE TABLE bench_history (tid INTEGER, bid INTEGER,
+	aid INTEGER, delta INTEGER, mtime BIGINT, filler CHAR(22))}
+
+    set branch [$db prepare {INSERT INTO bench_branches (bid, bbalance)
+	VALUES (:id, 0)}]
+    set teller [$db prepare {INSERT INTO bench_tellers (tid, bid, tbalance)
+	VALUES (:id, :bid, 0)}]
+    set account [$db prepare {INSERT INTO bench_accounts (aid, bid, abalance)
+	VALUES (:id, :bid, 0)}]
+    for {set bid 1} {$bid <= [dict get $config -scale]} {incr bid} {
+	$db transaction {
+	    $branch allrows [dict create id $bid]
+	    for {set i 1} {$i <= $tellersPerBranch} {incr i} {
+		$teller allrows [dict create \
+		    id [expr {($bid - 1) * $tellersPerBranch + $i}] bid $bid]
+	    }
+	}
+	for {set i 1} {$i <= $accountsPerBranch} {incr i 1000} {
+	    $db transaction {
+		for {set j $i} {$j < $i + 1000} {incr j} {
+		    $account allrows [dict create \
+			id [expr {($bid - 1) * $accountsPerBranch + $j}] \
+			bid $bid]
+		}
+	    }
+	}
+    }
+    $db close
+}
+
+# worker --
+#
+#	Runs the workload in one thread.
+#
+# Parameters:
+#	config -- Dictionary of the options of the run
+#	index -- Number of the thread, which seeds its random numbers
+#	start -- Time at which to start, in milliseconds
+#
+# Results:
+#	Returns a dictionary mapping each operation to a dictionary with the
+#	keys 'count', 'errors', 'rows' and 'latencies', the last a list of
+#	the time of each successful operation in microseconds.
+
+proc worker {config index start} {
+    global statements tellersPerBranch accountsPerBranch
+
+    set db [connect $config]
+    dict for {name sql} $statements {
+	set stmt($name) [$db prepare $sql]
+    }
+
+    # Make a table of the cumulative weights of the operations
+
+    set total 0
+    set table {}
+    dict for {op weight} [dict get $config -mix] {
+	if {$weight > 0} {
+	    incr total $weight
+	    lappend table $total $op
+	}
+	dict set stats $op [dict create count 0 errors 0 rows 0 latencies {}]
+    }
+
+    set scale [dict get $config -scale]
+    set batch [dict get $config -batch]
+    set scanrows [dict get $config -scanrows]
+    set accounts [expr {$scale * $accountsPerBranch}]
+    set tellers [expr {$scale * $tellersPerBranch}]
+    expr {srand($index + 1)}
+
+    while {[clock milliseconds] < $start} {
+	after 1
+    }
+    set end [expr {($start + 1000 * [dict get $config -duration]) * 1000}]
+    while {[set t0 [clock microseconds]] < $end} {
+	set r [expr {int(rand() * $total)}]
+	foreach {limit op} $table {
+	    if {$r < $limit} {
+		break
+	    }
+	}
+	set aid [expr {1 + int(rand() * $accounts)}]
+	set tid [expr {1 + int(rand() * $tellers)}]
+	set bid [expr {1 + ($tid - 1) / $tellersPerBranch}]
+	set delta [expr {int(rand() * 10001) - 5000}]
+	set status [catch {
+	    switch -exact -- $op {
+		lookup {
+		    llength [$stmt(lookup) allrows -as lists]
+		}
+		update {
+		    $db transaction {
+			$stmt(account) allrows
+			set n [llength [$stmt(lookup) allrows -as lists]]
+			$stmt(teller) allrows
+			$stmt(branch) allrows
+			set mtime [clock seconds]
+			$stmt(history) allrows
+		    }
+		    expr {$n + 4}
+		}
+		insert {
+		    $db transaction {
+			for {set i 0} {$i < $batch} {incr i} {
+			    set mtime [clock seconds]
+			    $stmt(history) allrows
+			}
+		    }
+		    set batch
+		}
+		scan {
+		    set lo $aid
+		    set hi [expr {$aid + $scanrows - 1}]
+		    llength [$stmt(scan) allrows -as lists]
+		}
+	    }
+	} touched]
+	set t1 [clock microseconds]
+	dict with stats $op {
+	    if {$status} {
+		incr errors
+	    } else {
+		incr count
+		incr rows $touched
+		lappend latencies [expr {$t1 - $t0}]
+	    }
+	}
+    }
+
+    $db close
+    return $stats
+}
+
+# percentiles --
+#
+#	Summarizes a list of latencies.
+#
+# Parameters:
+#	latencies -- List of times in microseconds
+#
+# Results:
+#	Returns a list of JSON members giving the percentiles and maximum
+#	in milliseconds.
+
+proc percentiles {latencies} {
+    set sorted [lsort -integer $latencies]
+    set n [llength $sorted]
+    set result {}
+    foreach p {50 90 95 99 99.9} {
+	if {$n == 0} {
+	    set value 0
+	} else {
+	    set value [lindex $sorted \
+			   [expr {max(0, int(ceil($p * $n / 100.0)) - 1)}]]
+	}
+	lappend result [format {"p%s": %.3f} [string map {. _} $p] \
+			    [expr {$value / 1000.0}]]
+    }
+    lappend result [format {"max": %.3f} \
+			[expr {$n == 0 ? 0 : [lindex $sorted end] / 1000.0}]]
+    return $result
+}
+
+proc usage {} {
+    puts stderr "usage: oltpbench.tcl ?-driver package? ?-connect script?\
+                 ?-threads n? ?-duration seconds? ?-scale n?\
+                 ?-mix {operation weight ...}? ?-batch n? ?-scanrows n?\
+                 ?-load boolean?"
+    exit 1
+}
+
+proc main {argv} {
+    set config [dict create -driver tdbc::sqlite3 -connect {} -threads 4 \
+		    -duration 10 -scale 1 \
+		    -mix {lookup 50 update 35 insert 10 scan 5} \
+		    -batch 10 -scanrows 100 -load 1 \
+		    tools [file dirname [file normalize [info script]]]]
+    if {[llength $argv] % 2 != 0} {
+	usage
+    }
+    foreach {option value} $argv {
+	if {![string match -* $option] || ![dict exists $config $option]} {
+	    usage
+	}
+	dict set config $option $value
+    }
+    foreach option {-threads -duration -scale -batch -scanrows} {
+	set value [dict get $config $option]
+	if {![string is entier -strict $value] || $value <= 0} {
+	    usage
+	}
+    }
+    if {![string is boolean -strict [dict get $config -load]]
+	|| [catch {dict size [dict get $config -mix]}]} {
+	usage
+    }
+    dict for {op weight} [dict get $config -mix] {
+	if {$op ni {lookup update insert scan}
+	    || ![string is entier -strict $weight] || $weight < 0} {
+	    usage
+	}
+    }
+    if {[dict get $config -connect] eq {}} {
+	if {[dict get $config -driver] eq {tdbc::sqlite3}} {
+	    dict set config -connect \
+		{tdbc::sqlite3::connection new oltpbench.db}
+	} elseif {[dict get $config -driver] ne {mock}} {
+	    usage
+	}
+    }
+
+    if {[dict get $config -load] && [dict get $config -driver] ne {mock}} {
+	populate $config
+    }
+
+    # Start the threads together, once they have had time to connect
+
+    set n [dict get $config -threads]
+    set start [expr {[clock milliseconds] + 1000}]
+    if {$n == 1} {
+	set results [list [worker $config 0 $start]]
+    } else {
+	package require Thread
+	set threads {}
+	for {set i 0} {$i < $n} {incr i} {
+	    set t [thread::create]
+	    thread::send $t [list set ::auto_path $::auto_path]
+	    thread::send $t [list set ::oltpbenchWorker 1]
+	    thread::send $t [list source \
+				[file join [dict get $config tools] oltpbench.tcl]]
+	    thread::send -async $t \
+		[list catch [list worker $config $i $start] ::result] ::status($i)
+	    lappend threads $t
+	}
+	set results {}
+	set i 0
+	foreach t $threads {
+	    if {![info exists ::status($i)]} {
+		vwait ::status($i)
+	    }
+	    set result [thread::send $t {set ::result}]
+	    if {$::status($i)} {
+		puts stderr "thread $i failed: $result"
+		exit 1
+	    }
+	    lappend results $result
+	    thread::release $t
+	    incr i
+	}
+    }
+
+    # Combine the results of the threads
+
+    set duration [dict get $config -duration]
+    set all {}
+    set operations {}
+    set count 0
+    set errors 0
+    set rows 0
+    dict for {op weight} [dict get $config -mix] {
+	set opCount 0
+	set opErrors 0
+	set opRows 0
+	set opLatencies {}
+	foreach result $results {
+	    set s [dict get $result $op]
+	    incr opCount [dict get $s count]
+	    incr opErrors [dict get $s errors]
+	    incr opRows [dict get $s rows]
+	    lappend opLatencies {*}[dict get $s latencies]
+	}
+	incr count $opCount
+	incr errors $opErrors
+	incr rows $opRows
+	lappend all {*}$opLatencies
+	lappend operations [format {"%s": {"count": %d, "errors": %d,\
+            "rows": %d, "tps": %.1f, "latency_ms": {%s}}} \
+				$op $opCount $opErrors $opRows \
+				[expr {double($opCount) / $duration}] \
+				[join [percentiles $opLatencies] {, }]]
+    }
+
+    puts "\{"
+    puts [format {  "driver": "%s",} [dict get $config -driver]]
+    puts [format {  "tdbc": "%s",} [package require tdbc]]
+    puts [format {  "threads": %d,} $n]
+    puts [format {  "duration": %d,} $duration]
+    puts [format {  "scale": %d,} [dict get $config -scale]]
+    puts [format {  "transactions": %d,} $count]
+    puts [format {  "errors": %d,} $errors]
+    puts [format {  "tps": %.1f,} [expr {double($count) / $duration}]]
+    puts [format {  "rows": %d,} $rows]
+    puts [format {  "rows_per_second": %.1f,} \
+	      [expr {double($rows) / $duration}]]
+    puts [format {  "latency_ms": {%s},} [join [percentiles $all] {, }]]
+    puts "  \"operations\": \{"
+    puts "    [join $operations ",\n    "]"
+    puts "  \}"
+    puts "\}"
+}
+
+if {![info exists ::oltpbenchWorker]} {
+    main $argv
+}